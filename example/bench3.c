@@ -0,0 +1,406 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+// Headless benchmark for milli2. Builds the material browser from docks_and_divs.md
+// with increasing number of rows and renders it into a nanovg back-end which only
+// counts the geometry it receives. Each row count is run with all rows built, which
+// stresses the pools and layout, and with only the visible rows built (miVisibleRange).
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "nanovg.h"
+#include "milli2.h"
+#define NANOSVG_IMPLEMENTATION 1
+#include "nanosvg.h"
+
+struct BenchRenderer {
+	int textures;
+	int texWidth[8], texHeight[8];
+	int fills, strokes, triangles;
+	int verts;
+};
+
+static int bench__renderCreate(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+	return 1;
+}
+
+static int bench__renderCreateTexture(void* uptr, int type, int w, int h, const unsigned char* data)
+{
+	struct BenchRenderer* r = (struct BenchRenderer*)uptr;
+	NVG_NOTUSED(type);
+	NVG_NOTUSED(data);
+	if (r->textures >= 8) return 0;
+	r->texWidth[r->textures] = w;
+	r->texHeight[r->textures] = h;
+	r->textures++;
+	return r->textures;
+}
+
+static int bench__renderDeleteTexture(void* uptr, int image)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(image);
+	return 1;
+}
+
+static int bench__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(image);
+	NVG_NOTUSED(x); NVG_NOTUSED(y);
+	NVG_NOTUSED(w); NVG_NOTUSED(h);
+	NVG_NOTUSED(data);
+	return 1;
+}
+
+static int bench__renderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	struct BenchRenderer* r = (struct BenchRenderer*)uptr;
+	if (image < 1 || image > r->textures) return 0;
+	*w = r->texWidth[image-1];
+	*h = r->texHeight[image-1];
+	return 1;
+}
+
+static void bench__renderViewport(void* uptr, int width, int height, int alphaBlend)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(width);
+	NVG_NOTUSED(height);
+	NVG_NOTUSED(alphaBlend);
+}
+
+static void bench__renderFlush(void* uptr, int alphaBlend)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(alphaBlend);
+}
+
+static void bench__renderFill(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe, const float* bounds, const struct NVGpath* paths, int npaths)
+{
+	struct BenchRenderer* r = (struct BenchRenderer*)uptr;
+	int i;
+	NVG_NOTUSED(paint);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(fringe);
+	NVG_NOTUSED(bounds);
+	r->fills++;
+	for (i = 0; i < npaths; i++)
+		r->verts += paths[i].nfill + paths[i].nstroke;
+}
+
+static void bench__renderStroke(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe, float strokeWidth, const struct NVGpath* paths, int npaths)
+{
+	struct BenchRenderer* r = (struct BenchRenderer*)uptr;
+	int i;
+	NVG_NOTUSED(paint);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(fringe);
+	NVG_NOTUSED(strokeWidth);
+	r->strokes++;
+	for (i = 0; i < npaths; i++)
+		r->verts += paths[i].nstroke;
+}
+
+static void bench__renderTriangles(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, const struct NVGvertex* verts, int nverts)
+{
+	struct BenchRenderer* r = (struct BenchRenderer*)uptr;
+	NVG_NOTUSED(paint);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(verts);
+	r->triangles++;
+	r->verts += nverts;
+}
+
+static void bench__renderDelete(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+}
+
+static struct NVGcontext* createBenchContext(struct BenchRenderer* r)
+{
+	struct NVGparams params;
+
+	memset(r, 0, sizeof(*r));
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = bench__renderCreate;
+	params.renderCreateTexture = bench__renderCreateTexture;
+	params.renderDeleteTexture = bench__renderDeleteTexture;
+	params.renderUpdateTexture = bench__renderUpdateTexture;
+	params.renderGetTextureSize = bench__renderGetTextureSize;
+	params.renderViewport = bench__renderViewport;
+	params.renderFlush = bench__renderFlush;
+	params.renderFill = bench__renderFill;
+	params.renderStroke = bench__renderStroke;
+	params.renderTriangles = bench__renderTriangles;
+	params.renderDelete = bench__renderDelete;
+	params.userPtr = r;
+	params.atlasWidth = 512;
+	params.atlasHeight = 512;
+	params.edgeAntiAlias = 1;
+	params.bufferedRender = 1;
+
+	return nvgCreateInternal(&params);
+}
+
+static double getTime()
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, t;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&t);
+	return (double)t.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+static const char* materialNames[] = {
+	"Gold", "Matte Plastic", "Glass", "Brushed Steel", "Rubber", "Car Paint", "Wood", "Skin",
+};
+static const char* materialTypes[] = {
+	"Metal", "Phong", "Dielectric", "Anisotropic",
+};
+
+static MIhandle popupHandle = 0;
+
+static void buildMaterialBrowser(int rowCount, int virtualized, char* search, int searchSize, float* value)
+{
+	int i, first, end;
+	char name[64], size[32];
+	float cols[3] = {25, -1, 25};
+	float cols2[3] = {-1, 60, 40};
+	float cols3[2] = {50, -1};
+	float rows[4] = {-1, 20, 15, -1};
+	MIhandle add;
+
+	miPanelBegin(50,50, 250,450);
+
+	// Header
+	miDockBegin(MI_TOP_BOTTOM);
+		miText("Materials");
+		miDivsBegin(MI_LEFT_RIGHT, 3, cols);
+			miRowHeight(25);
+			miText("S");
+			miInput(search, searchSize);
+			miText("X");
+		miDivsEnd();
+		miSliderValue(value, -1.0f, 1.0f);
+	miDockEnd();
+
+	// Footer
+	miDockBegin(MI_BOTTOM_TOP);
+		miDivsBegin(MI_LEFT_RIGHT, 3, cols2);
+			miRowHeight(20);
+			miSpacer();
+			add = miButton("Add");
+			miButton("Delete");
+		miDivsEnd();
+		popupHandle = miPopupBegin(add, MI_ONCLICK, MI_BELOW);
+			miText("New material");
+			miButton("Create");
+		miPopupEnd();
+	miDockEnd();
+
+	// List, when virtualized only the visible rows are built.
+	miDockBegin(MI_FILLY);
+		if (virtualized) {
+			miOverflow(MI_SCROLL);
+			miVisibleRange(50, rowCount, &first, &end);
+		} else {
+			first = 0;
+			end = rowCount;
+		}
+		for (i = first; i < end; i++) {
+			snprintf(name, sizeof(name), "%s %d", materialNames[i % 8], i);
+			snprintf(size, sizeof(size), "%dkB", (i * 7) % 100);
+			miDivsBegin(MI_LEFT_RIGHT, 2, cols3);
+				miRowHeight(50);
+				miText("IMG");
+				miDivsBegin(MI_TOP_BOTTOM, 4, rows);
+					miSpacer();
+					miText(name);
+					miLayoutBegin(MI_LEFT_RIGHT);
+						miPack(MI_LEFT_RIGHT);
+						miText(materialTypes[i % 4]);
+						miPack(MI_RIGHT_LEFT);
+						miText(size);
+					miLayoutEnd();
+				miDivsEnd();
+			miDivsEnd();
+		}
+	miDockEnd();
+
+	miPanelEnd();
+}
+
+static int loadFonts(const char* path)
+{
+	char filename[256];
+	snprintf(filename, sizeof(filename), "%s/Roboto-Regular.ttf", path);
+	if (miCreateFont(MI_FONT_NORMAL, filename)) return -1;
+	snprintf(filename, sizeof(filename), "%s/Roboto-Italic.ttf", path);
+	if (miCreateFont(MI_FONT_ITALIC, filename)) return -1;
+	snprintf(filename, sizeof(filename), "%s/Roboto-Bold.ttf", path);
+	if (miCreateFont(MI_FONT_BOLD, filename)) return -1;
+	return 0;
+}
+
+static void printPool(const char* name, int used, int max)
+{
+	printf("    %-10s %7d / %-7d%s\n", name, used, max, used >= max ? "  (full)" : "");
+}
+
+struct BenchResult {
+	double buildTime, drawTime;
+	int shapes, verts;
+};
+
+static void runBench(struct NVGcontext* vg, struct BenchRenderer* r, int rowCount, int virtualized, int frames,
+					 struct BenchResult* res)
+{
+	MIinputState input;
+	MIpoolStats stats;
+	struct NVGframeStats frameStats, firstStats;
+	char search[64] = "Foob-foob";
+	float value = 0.15f;
+	double t0, t1, t2, t3;
+	double buildTime = 0, drawTime = 0, flushTime = 0;
+	int i, warmup = 2;
+
+	memset(&input, 0, sizeof(input));
+	memset(&firstStats, 0, sizeof(firstStats));
+
+	for (i = 0; i < warmup + frames; i++) {
+		r->fills = r->strokes = r->triangles = r->verts = 0;
+
+		t0 = getTime();
+		nvgBeginFrame(vg, 1000, 600, 1.0f, NVG_STRAIGHT_ALPHA);
+		input.mx = 300;
+		input.my = 300;
+		miFrameBegin(1000, 600, &input, 1.0f/60.0f);
+
+		// Keep the footer popup open so that its panel is built and drawn too.
+		if (popupHandle != 0)
+			miPopupShow(popupHandle);
+
+		buildMaterialBrowser(rowCount, virtualized, search, sizeof(search), &value);
+
+		t1 = getTime();
+		miFrameEnd();
+		t2 = getTime();
+		nvgEndFrame(vg);
+		t3 = getTime();
+
+		nvgFrameStats(vg, &frameStats);
+		if (i == 0)
+			firstStats = frameStats;
+
+		if (i >= warmup) {
+			buildTime += t1 - t0;
+			drawTime += t2 - t1;
+			flushTime += t3 - t2;
+		}
+	}
+
+	miGetPoolStats(&stats);
+
+	res->buildTime = buildTime * 1000.0 / frames;
+	res->drawTime = drawTime * 1000.0 / frames;
+	res->shapes = r->fills + r->strokes + r->triangles;
+	res->verts = r->verts;
+
+	printf("%d rows, %s, %d frames\n", rowCount, virtualized ? "visible rows" : "all rows", frames);
+	printf("  build+layout  %8.3f ms/frame\n", buildTime * 1000.0 / frames);
+	printf("  draw replay   %8.3f ms/frame\n", drawTime * 1000.0 / frames);
+	printf("  nvg flush     %8.3f ms/frame\n", flushTime * 1000.0 / frames);
+	printf("  fills %d, strokes %d, triangles %d, verts %d\n", r->fills, r->strokes, r->triangles, r->verts);
+	printf("  atlas uploads: first frame %d (%d bytes), last frame %d (%d bytes)\n",
+		   firstStats.atlasUploads, firstStats.atlasUploadBytes, frameStats.atlasUploads, frameStats.atlasUploadBytes);
+	printf("  pools:\n");
+	printPool("panels", stats.panels, stats.maxPanels);
+	printPool("shapes", stats.shapes, stats.maxShapes);
+	printPool("boxes", stats.boxes, stats.maxBoxes);
+	printPool("text", stats.text, stats.maxText);
+	printPool("states", stats.states, stats.maxStates);
+	printPool("statemem", stats.stateMem, stats.maxStateMem);
+	printPool("sizes", stats.sizes, stats.maxSizes);
+}
+
+int main(int argc, char** argv)
+{
+	struct BenchRenderer renderer;
+	struct NVGcontext* vg = NULL;
+	const char* fontPath = "../example/fonts";
+	int rowCounts[] = {10, 1000, 100000};
+	int frameCounts[] = {100, 20, 5};
+	struct BenchResult full[3], visible[3];
+	int deferred = 0;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-deferred") == 0)
+			deferred = 1;
+		else
+			fontPath = argv[i];
+	}
+
+	vg = createBenchContext(&renderer);
+	if (vg == NULL) {
+		printf("Could not init nanovg.\n");
+		return -1;
+	}
+
+	miInit(vg);
+	miDeferLayout(deferred);
+
+	if (loadFonts(fontPath)) {
+		printf("Could not load fonts from '%s'.\n", fontPath);
+		return -1;
+	}
+
+	printf("milli2 benchmark%s\n", deferred ? " (deferred layout)" : "");
+	for (i = 0; i < 3; i++) {
+		runBench(vg, &renderer, rowCounts[i], 0, frameCounts[i], &full[i]);
+		runBench(vg, &renderer, rowCounts[i], 1, frameCounts[i], &visible[i]);
+	}
+
+	printf("\n%8s  %-28s  %-28s\n", "", "all rows", "visible rows");
+	printf("%8s  %9s %9s %8s  %9s %9s %8s\n", "rows", "build ms", "draw ms", "verts", "build ms", "draw ms", "verts");
+	for (i = 0; i < 3; i++) {
+		printf("%8d  %9.3f %9.3f %8d  %9.3f %9.3f %8d\n", rowCounts[i],
+			   full[i].buildTime, full[i].drawTime, full[i].verts,
+			   visible[i].buildTime, visible[i].drawTime, visible[i].verts);
+	}
+
+	nvgDeleteInternal(vg);
+
+	miTerminate();
+
+	return 0;
+}
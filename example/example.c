@@ -217,6 +217,8 @@ int main()
 		printf("Could not add font bold.\n");
 		return -1;
 	}
+	// Rasterize new glyphs in the background.
+	nvgFontWorkers(vg, 2);
 
 	mgInit();
 
@@ -160,6 +160,13 @@ static void buttoncb(GLFWwindow* window, int button, int action, int mods)
 	}
 }
 
+static void scrollcb(GLFWwindow* window, double x, double y)
+{
+	(void)window;
+	(void)x;
+	input.scrolly += (float)y;
+}
+
 /*
 
 
@@ -222,6 +229,7 @@ int main()
 	glfwSetKeyCallback(window, keycb);
 	glfwSetCharCallback(window, charcb);
     glfwSetMouseButtonCallback(window, buttoncb);
+	glfwSetScrollCallback(window, scrollcb);
 
 	glfwMakeContextCurrent(window);
 
@@ -375,7 +383,7 @@ int main()
 //		miLayoutEnd();
 
 		miDockBegin(MI_FILLY);
-
+			miOverflow(MI_SCROLL);
 
 			float cols3[2] = {50, -1};
 			miDivsBegin(MI_LEFT_RIGHT, 2, cols3);
@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+// Checks for mgui, the frames are drawn with the software renderer so no window is needed.
+// Prints the failed checks and returns non-zero if any of them failed.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "nanovg.h"
+#define NANOVG_SW_IMPLEMENTATION
+#include "nanovg_sw.h"
+#include "mgui.h"
+#define NANOSVG_IMPLEMENTATION 1
+#include "nanosvg.h"
+
+#define WIDTH 128
+#define HEIGHT 128
+
+static int failed = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); failed++; } } while(0)
+
+// Canvas widgets do not have user data, so the events are counted globally.
+static int pressedCount = 0;
+static int releasedCount = 0;
+
+static void countLogic(void* uptr, struct MGwidget* w, int event, struct MGhit* hit)
+{
+	(void)uptr; (void)w; (void)hit;
+	if (event == MG_PRESSED) pressedCount++;
+	if (event == MG_RELEASED) releasedCount++;
+}
+
+static void frame(struct NVGcontext* vg, unsigned char* pixels)
+{
+	nvgSetTargetSW(vg, pixels, WIDTH, HEIGHT, WIDTH*4);
+	nvgBeginFrame(vg, WIDTH, HEIGHT, 1.0f, NVG_STRAIGHT_ALPHA);
+	mgFrameBegin(vg, WIDTH, HEIGHT, NULL, 1.0f/60.0f);
+	mgPanelBegin(MG_COL, 0, 0, 0, NULL);
+	mgCanvas(100, 100, countLogic, NULL, mgOpts(mgLogic(MG_DRAG)));
+	mgPanelEnd();
+	mgFrameEnd();
+	nvgEndFrame(vg);
+}
+
+// Drags flood the queue with moves, which are not merged while the button is down.
+// Every press and release must still reach the widget.
+static void checkInputFlood(struct NVGcontext* vg, unsigned char* pixels)
+{
+	int i, j, ok = 1;
+	for (i = 0; i < 3; i++) {
+		ok &= mgPushMouseButton(0.0, 20, 20, 1);
+		for (j = 0; j < 1000; j++)
+			ok &= mgPushMouseMove(0.0, 20 + (j & 7), 20);
+		ok &= mgPushMouseButton(0.0, 20, 20, 0);
+	}
+	CHECK(ok);
+	for (i = 0; i < 1000; i++)
+		frame(vg, pixels);
+	CHECK(pressedCount == 3);
+	CHECK(releasedCount == 3);
+}
+
+int main()
+{
+	struct NVGcontext* vg = NULL;
+	unsigned char* pixels = NULL;
+
+	vg = nvgCreateSW(512, 512, 1, 0);
+	pixels = (unsigned char*)calloc(WIDTH*HEIGHT, 4);
+	if (vg == NULL || pixels == NULL) {
+		printf("Could not init renderer.\n");
+		return 1;
+	}
+	mgInit();
+
+	checkInputFlood(vg, pixels);
+
+	mgTerminate();
+	nvgDeleteSW(vg);
+	free(pixels);
+
+	if (failed > 0) {
+		printf("%d checks failed.\n", failed);
+		return 1;
+	}
+	printf("All checks passed.\n");
+	return 0;
+}
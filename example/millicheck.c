@@ -0,0 +1,204 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+// Checks for milli which do not need a window or renderer. Prints the failed
+// checks and returns non-zero if any of them failed.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "nanovg.h"
+#include "milli.h"
+#define NANOSVG_IMPLEMENTATION 1
+#include "nanosvg.h"
+
+static int failed = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); failed++; } } while(0)
+
+// Builds a blob of 'count' boxes where each box is the only child of the previous one.
+static void* buildChain(int count, int* size)
+{
+	struct MIuiHeader* hdr;
+	struct MIuiCell* cells;
+	unsigned char* data;
+	int i;
+
+	*size = sizeof(struct MIuiHeader) + sizeof(struct MIuiCell) * count + sizeof(int);
+	data = (unsigned char*)malloc(*size);
+	if (data == NULL) return NULL;
+	memset(data, 0, *size);
+
+	hdr = (struct MIuiHeader*)data;
+	hdr->magic = MI_UI_MAGIC;
+	hdr->version = MI_UI_VERSION;
+	hdr->cellCount = count;
+	hdr->paramCount = 0;
+	hdr->stringsSize = 1;
+	hdr->cellsOffset = sizeof(struct MIuiHeader);
+	hdr->paramsOffset = sizeof(struct MIuiHeader);
+	hdr->stringsOffset = *size - sizeof(int);
+
+	cells = (struct MIuiCell*)(data + hdr->cellsOffset);
+	for (i = 0; i < count; i++) {
+		cells[i].type = 0;	// box
+		cells[i].id = -1;
+		cells[i].parent = i-1;
+		cells[i].firstChild = i+1 < count ? i+1 : -1;
+		cells[i].next = -1;
+	}
+
+	return data;
+}
+
+static void checkUIDepth()
+{
+	void* data;
+	char* text;
+	int size, i, n;
+
+	// Deep chains would overflow the stack in miCreateFromUI().
+	data = buildChain(100000, &size);
+	CHECK(data != NULL && !miCheckUI(data, size));
+	free(data);
+
+	data = buildChain(65, &size);
+	CHECK(data != NULL && !miCheckUI(data, size));
+	free(data);
+
+	// The deepest chain the text compiler accepts is fine.
+	data = buildChain(64, &size);
+	CHECK(data != NULL && miCheckUI(data, size));
+	if (data != NULL && miCheckUI(data, size)) {
+		struct MIcell* cell = miCreateFromUI(data, 0);
+		CHECK(cell != NULL);
+		miFreeCell(cell);
+	}
+	free(data);
+
+	text = (char*)malloc(64*65 + 1);
+	if (text == NULL) return;
+	n = 0;
+	for (i = 0; i < 64; i++) {
+		memset(&text[n], '\t', i);
+		n += i;
+		memcpy(&text[n], "box\n", 4);
+		n += 4;
+	}
+	text[n] = '\0';
+	CHECK(miCompileUI(text, &data, &size) && miCheckUI(data, size));
+	free(data);
+	free(text);
+}
+
+// The header declares the function with different case.
+struct MIcell* miCreateTemplate(struct MIcell* host);
+
+static void checkTemplateVars()
+{
+	struct MIparam* params;
+	struct MIcell *tmpl, *host, *a, *b, *c;
+
+	// Compile the params before any var with the names exists.
+	params = miCompileParams("name=foo size='20 30' grow=1");
+	CHECK(params != NULL);
+
+	host = miCreateBox("dir=col");
+	a = miCreateText("label={name}");
+	b = miCreateBox("width={size} height=5");
+	c = miCreateText("label={name}");
+	miAddChild(host, a);
+	miAddChild(host, b);
+	miAddChild(b, c);
+	tmpl = miCreateTemplate(host);
+	CHECK(tmpl != NULL);
+	if (tmpl == NULL || params == NULL) return;
+
+	miSetCompiled(tmpl, params);
+	CHECK(strcmp(((struct MItext*)a)->text, "foo") == 0);
+	CHECK(strcmp(((struct MItext*)c)->text, "foo") == 0);
+	CHECK(((struct MIbox*)b)->width == 20);
+	CHECK(((struct MIbox*)b)->height == 5);
+	CHECK(tmpl->grow == 1);
+
+	// Vars added after the template was created are found too.
+	miSet(c, "label={other}");
+	miSet(tmpl, "name=bar other=baz");
+	CHECK(strcmp(((struct MItext*)a)->text, "bar") == 0);
+	CHECK(strcmp(((struct MItext*)c)->text, "baz") == 0);
+
+	miFreeParams(params);
+	miFreeCell(tmpl);
+}
+
+static int pressedCount = 0;
+static int releasedCount = 0;
+
+static int countLogic(struct MIcell* cell, struct MIevent* event)
+{
+	(void)cell;
+	if (event->type == MI_PRESSED) pressedCount++;
+	if (event->type == MI_RELEASED) releasedCount++;
+	return 1;
+}
+
+// Drags flood the queue with moves, which are not merged while the button is down.
+// Every press and release must still reach the cell.
+static void checkInputFlood()
+{
+	struct MIcell* box;
+	int i, j, ok = 1;
+
+	box = miCreateBox(NULL);
+	CHECK(box != NULL);
+	if (box == NULL) return;
+	box->frame.width = 100;
+	box->frame.height = 100;
+	box->logic = countLogic;
+
+	for (i = 0; i < 3; i++) {
+		ok &= miPushMouseButton(0.0, 20, 20, 1);
+		for (j = 0; j < 1000; j++)
+			ok &= miPushMouseMove(0.0, 20 + (j & 7), 20);
+		ok &= miPushMouseButton(0.0, 20, 20, 0);
+	}
+	CHECK(ok);
+	miInput(box, NULL);
+	CHECK(pressedCount == 3);
+	CHECK(releasedCount == 3);
+
+	miFreeCell(box);
+}
+
+int main()
+{
+	miInit();
+
+	checkUIDepth();
+	checkTemplateVars();
+	checkInputFlood();
+
+	miTerminate();
+
+	if (failed > 0) {
+		printf("%d checks failed.\n", failed);
+		return 1;
+	}
+	printf("All checks passed.\n");
+	return 0;
+}
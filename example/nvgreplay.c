@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+// Replays a nanovg recording (see nanovg_rec.h) headlessly into the software
+// back-end and reports the per frame render time. Since the recording holds
+// the final geometry, the time excludes the application and nanovg itself.
+//
+//		nvgreplay [-t threads] [-s width height] [-o last.ppm] capture.nvgr
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "nanovg.h"
+#define NANOVG_SW_IMPLEMENTATION
+#include "nanovg_sw.h"
+#define NANOVG_REC_IMPLEMENTATION
+#include "nanovg_rec.h"
+
+struct ReplayState {
+	unsigned char* pixels;
+	int width, height;
+	const char* output;
+	double start;
+	double total, minTime, maxTime;
+	int frames;
+};
+
+static double getTime()
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, t;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&t);
+	return (double)t.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+static void writePPM(const char* filename, const unsigned char* rgba, int w, int h)
+{
+	FILE* fp = fopen(filename, "wb");
+	int i;
+	if (fp == NULL) return;
+	fprintf(fp, "P6\n%d %d\n255\n", w, h);
+	for (i = 0; i < w*h; i++)
+		fwrite(&rgba[i*4], 1, 3, fp);
+	fclose(fp);
+}
+
+static void frameDone(void* uptr, int frame)
+{
+	struct ReplayState* state = (struct ReplayState*)uptr;
+	double t = getTime() - state->start;
+	NVG_NOTUSED(frame);
+
+	state->total += t;
+	if (state->frames == 0 || t < state->minTime) state->minTime = t;
+	if (state->frames == 0 || t > state->maxTime) state->maxTime = t;
+	state->frames++;
+
+	// Write and clear for next frame, not timed.
+	if (state->output != NULL)
+		writePPM(state->output, state->pixels, state->width, state->height);
+	memset(state->pixels, 0, state->width*state->height*4);
+	state->start = getTime();
+}
+
+int main(int argc, char** argv)
+{
+	struct ReplayState state;
+	struct NVGcontext* vg = NULL;
+	const char* capture = NULL;
+	int i, frames, threads = 4;
+
+	memset(&state, 0, sizeof(state));
+	state.width = 1280;
+	state.height = 800;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-s") == 0 && i+2 < argc) {
+			state.width = atoi(argv[++i]);
+			state.height = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-o") == 0 && i+1 < argc) {
+			state.output = argv[++i];
+		} else {
+			capture = argv[i];
+		}
+	}
+	if (capture == NULL || state.width <= 0 || state.height <= 0) {
+		printf("usage: nvgreplay [-t threads] [-s width height] [-o last.ppm] capture.nvgr\n");
+		return -1;
+	}
+
+	state.pixels = (unsigned char*)malloc(state.width*state.height*4);
+	if (state.pixels == NULL) return -1;
+	memset(state.pixels, 0, state.width*state.height*4);
+
+	vg = nvgCreateSW(512, 512, 1, threads);
+	if (vg == NULL) {
+		printf("Could not init nanovg.\n");
+		return -1;
+	}
+	nvgSetTargetSW(vg, state.pixels, state.width, state.height, state.width*4);
+
+	// The recorded frames set the viewport, the target is scaled to cover it.
+	state.start = getTime();
+	frames = nvgReplayRec(vg, capture, frameDone, &state);
+	if (frames < 0) {
+		printf("Could not replay '%s'.\n", capture);
+		nvgDeleteSW(vg);
+		free(state.pixels);
+		return -1;
+	}
+
+	printf("%s: %d frames, %d threads\n", capture, frames, threads);
+	if (state.frames > 0) {
+		printf("  avg %8.3f ms/frame\n", state.total * 1000.0 / state.frames);
+		printf("  min %8.3f ms/frame\n", state.minTime * 1000.0);
+		printf("  max %8.3f ms/frame\n", state.maxTime * 1000.0);
+	}
+
+	nvgDeleteSW(vg);
+
+	free(state.pixels);
+
+	return 0;
+}
@@ -0,0 +1,398 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+// Checks that the SIMD kernels in nanovg produce bit-exact vertices compared to the
+// scalar code. Tessellates a fixed set of fills and strokes with anti-aliasing, and
+// captures every vertex buffer passed to the back-end. The program is built twice,
+// simdcheck_scalar with NVG_NO_SIMD writes the reference, and simdcheck compares
+// against it. Returns non-zero on any difference.
+//
+//		simdcheck_scalar -o scalar.bin
+//		simdcheck scalar.bin
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "nanovg.h"
+
+#define NUM_SHAPES 4000
+
+struct CheckRenderer {
+	unsigned char* data;
+	int size, cap;
+	int* draws;		// Offset of each draw call in data.
+	int ndraws, cdraws;
+	int failed;
+};
+
+static void check__append(struct CheckRenderer* r, const void* src, int size)
+{
+	if (r->failed) return;
+	if (r->size + size > r->cap) {
+		int cap = r->cap == 0 ? 1024*1024 : r->cap;
+		unsigned char* data;
+		while (cap < r->size + size) cap *= 2;
+		data = (unsigned char*)realloc(r->data, cap);
+		if (data == NULL) {
+			r->failed = 1;
+			return;
+		}
+		r->data = data;
+		r->cap = cap;
+	}
+	memcpy(r->data + r->size, src, size);
+	r->size += size;
+}
+
+static void check__beginDraw(struct CheckRenderer* r)
+{
+	if (r->failed) return;
+	if (r->ndraws+1 > r->cdraws) {
+		int cdraws = r->cdraws == 0 ? 1024 : r->cdraws*2;
+		int* draws = (int*)realloc(r->draws, sizeof(int)*cdraws);
+		if (draws == NULL) {
+			r->failed = 1;
+			return;
+		}
+		r->draws = draws;
+		r->cdraws = cdraws;
+	}
+	r->draws[r->ndraws++] = r->size;
+}
+
+static void check__appendPaths(struct CheckRenderer* r, const struct NVGpath* paths, int npaths)
+{
+	int i;
+	check__append(r, &npaths, sizeof(int));
+	for (i = 0; i < npaths; i++) {
+		const struct NVGpath* path = &paths[i];
+		int info[5];
+		info[0] = path->nfill;
+		info[1] = path->nstroke;
+		info[2] = path->nbevel;
+		info[3] = path->winding;
+		info[4] = path->convex;
+		check__append(r, info, sizeof(info));
+		if (path->nfill > 0)
+			check__append(r, path->fill, sizeof(struct NVGvertex) * path->nfill);
+		if (path->nstroke > 0)
+			check__append(r, path->stroke, sizeof(struct NVGvertex) * path->nstroke);
+	}
+}
+
+static int check__renderCreate(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+	return 1;
+}
+
+static int check__renderCreateTexture(void* uptr, int type, int w, int h, const unsigned char* data)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(type);
+	NVG_NOTUSED(w); NVG_NOTUSED(h);
+	NVG_NOTUSED(data);
+	return 1;
+}
+
+static int check__renderDeleteTexture(void* uptr, int image)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(image);
+	return 1;
+}
+
+static int check__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(image);
+	NVG_NOTUSED(x); NVG_NOTUSED(y);
+	NVG_NOTUSED(w); NVG_NOTUSED(h);
+	NVG_NOTUSED(data);
+	return 1;
+}
+
+static int check__renderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(image);
+	*w = *h = 512;
+	return 1;
+}
+
+static void check__renderViewport(void* uptr, int width, int height, int alphaBlend)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(width); NVG_NOTUSED(height);
+	NVG_NOTUSED(alphaBlend);
+}
+
+static void check__renderFlush(void* uptr, int alphaBlend)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(alphaBlend);
+}
+
+static void check__renderFill(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe, const float* bounds, const struct NVGpath* paths, int npaths)
+{
+	struct CheckRenderer* r = (struct CheckRenderer*)uptr;
+	NVG_NOTUSED(paint); NVG_NOTUSED(scissor);
+	check__beginDraw(r);
+	check__append(r, &fringe, sizeof(float));
+	check__append(r, bounds, sizeof(float)*4);
+	check__appendPaths(r, paths, npaths);
+}
+
+static void check__renderStroke(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe, float strokeWidth, const struct NVGpath* paths, int npaths)
+{
+	struct CheckRenderer* r = (struct CheckRenderer*)uptr;
+	NVG_NOTUSED(paint); NVG_NOTUSED(scissor);
+	check__beginDraw(r);
+	check__append(r, &fringe, sizeof(float));
+	check__append(r, &strokeWidth, sizeof(float));
+	check__appendPaths(r, paths, npaths);
+}
+
+static void check__renderTriangles(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, const struct NVGvertex* verts, int nverts)
+{
+	struct CheckRenderer* r = (struct CheckRenderer*)uptr;
+	NVG_NOTUSED(paint); NVG_NOTUSED(scissor);
+	check__beginDraw(r);
+	check__append(r, &nverts, sizeof(int));
+	check__append(r, verts, sizeof(struct NVGvertex) * nverts);
+}
+
+static void check__renderDelete(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+}
+
+static struct NVGcontext* createCheckContext(struct CheckRenderer* r)
+{
+	struct NVGparams params;
+
+	memset(r, 0, sizeof(*r));
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = check__renderCreate;
+	params.renderCreateTexture = check__renderCreateTexture;
+	params.renderDeleteTexture = check__renderDeleteTexture;
+	params.renderUpdateTexture = check__renderUpdateTexture;
+	params.renderGetTextureSize = check__renderGetTextureSize;
+	params.renderViewport = check__renderViewport;
+	params.renderFlush = check__renderFlush;
+	params.renderFill = check__renderFill;
+	params.renderStroke = check__renderStroke;
+	params.renderTriangles = check__renderTriangles;
+	params.renderDelete = check__renderDelete;
+	params.userPtr = r;
+	params.atlasWidth = 512;
+	params.atlasHeight = 512;
+	params.edgeAntiAlias = 1;
+
+	return nvgCreateInternal(&params);
+}
+
+static float frand(unsigned int* seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return (float)((*seed >> 8) & 0xffff) / 65535.0f;
+}
+
+static void shapePath(struct NVGcontext* vg, int type, unsigned int* seed)
+{
+	float x = frand(seed) * 800, y = frand(seed) * 600;
+	float w = 0.5f + frand(seed) * 200, h = 0.5f + frand(seed) * 200;
+	int i, n;
+
+	nvgBeginPath(vg);
+	switch (type) {
+	case 0:
+		nvgRect(vg, x, y, w, h);
+		break;
+	case 1:
+		nvgRoundedRect(vg, x, y, w, h, frand(seed) * 20);
+		break;
+	case 2:
+		nvgCircle(vg, x, y, w*0.5f);
+		break;
+	case 3:
+		nvgEllipse(vg, x, y, w*0.5f, h*0.5f);
+		break;
+	case 4:
+		nvgArc(vg, x, y, w*0.5f, frand(seed) * NVG_PI*2, frand(seed) * NVG_PI*2, frand(seed) < 0.5f ? NVG_CW : NVG_CCW);
+		break;
+	case 5:
+		nvgMoveTo(vg, x, y);
+		nvgBezierTo(vg, x + frand(seed)*w, y + frand(seed)*h, x + frand(seed)*w, y + frand(seed)*h, x + w, y + h);
+		nvgLineTo(vg, x, y + h);
+		break;
+	case 6:
+		// Polyline with repeated and nearly collinear points.
+		n = 2 + (int)(frand(seed) * 20);
+		nvgMoveTo(vg, x, y);
+		for (i = 0; i < n; i++) {
+			if (frand(seed) < 0.2f)
+				nvgLineTo(vg, x, y);
+			x += (frand(seed) - 0.5f) * w;
+			y += (frand(seed) - 0.5f) * (frand(seed) < 0.3f ? 0.01f : h);
+			nvgLineTo(vg, x, y);
+		}
+		if (frand(seed) < 0.5f)
+			nvgClosePath(vg);
+		break;
+	default:
+		nvgMoveTo(vg, x, y);
+		nvgArcTo(vg, x + w, y, x + w, y + h, frand(seed) * 30);
+		nvgLineTo(vg, x + w, y + h);
+		nvgRect(vg, x + w*0.25f, y + h*0.25f, w*0.5f, h*0.5f);
+		nvgPathWinding(vg, NVG_HOLE);
+		break;
+	}
+}
+
+static void drawShapes(struct NVGcontext* vg)
+{
+	static const int joins[] = { NVG_MITER, NVG_ROUND, NVG_BEVEL };
+	static const int caps[] = { NVG_BUTT, NVG_ROUND, NVG_SQUARE };
+	unsigned int seed = 1;
+	int i;
+
+	nvgBeginFrame(vg, 1000, 1000, 1.0f, NVG_STRAIGHT_ALPHA);
+	for (i = 0; i < NUM_SHAPES; i++) {
+		nvgSave(vg);
+		if (i % 3 == 1) {
+			nvgTranslate(vg, frand(&seed) * 100, frand(&seed) * 100);
+			nvgRotate(vg, frand(&seed) * NVG_PI*2);
+			nvgScale(vg, 0.1f + frand(&seed) * 3, 0.1f + frand(&seed) * 3);
+		} else if (i % 3 == 2) {
+			nvgSkewX(vg, (frand(&seed) - 0.5f) * 1.5f);
+		}
+		shapePath(vg, i % 8, &seed);
+		if (i & 8) {
+			nvgStrokeWidth(vg, 0.25f + frand(&seed) * 12);
+			nvgLineJoin(vg, joins[(i/16) % 3]);
+			nvgLineCap(vg, caps[(i/48) % 3]);
+			nvgMiterLimit(vg, 1 + frand(&seed) * 10);
+			nvgStroke(vg);
+		} else {
+			nvgFill(vg);
+		}
+		nvgRestore(vg);
+	}
+	nvgEndFrame(vg);
+}
+
+static int writeFile(const char* filename, const unsigned char* data, int size)
+{
+	FILE* fp = fopen(filename, "wb");
+	int n;
+	if (fp == NULL) return 0;
+	n = (int)fwrite(data, 1, size, fp);
+	fclose(fp);
+	return n == size;
+}
+
+static unsigned char* readFile(const char* filename, int* size)
+{
+	FILE* fp = fopen(filename, "rb");
+	unsigned char* data = NULL;
+	long n;
+	if (fp == NULL) return NULL;
+	fseek(fp, 0, SEEK_END);
+	n = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	data = (unsigned char*)malloc(n > 0 ? n : 1);
+	if (data == NULL || (long)fread(data, 1, n, fp) != n) {
+		free(data);
+		fclose(fp);
+		return NULL;
+	}
+	fclose(fp);
+	*size = (int)n;
+	return data;
+}
+
+int main(int argc, char** argv)
+{
+	struct CheckRenderer renderer;
+	struct NVGcontext* vg = NULL;
+	const char* output = NULL;
+	const char* reference = NULL;
+	unsigned char* ref = NULL;
+	int i, refSize = 0, diff, draw, ret = 0;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-o") == 0 && i+1 < argc)
+			output = argv[++i];
+		else
+			reference = argv[i];
+	}
+	if (output == NULL && reference == NULL) {
+		printf("usage: simdcheck [-o out.bin] [reference.bin]\n");
+		return -1;
+	}
+
+	vg = createCheckContext(&renderer);
+	if (vg == NULL) {
+		printf("Could not init nanovg.\n");
+		return -1;
+	}
+	drawShapes(vg);
+	nvgDeleteInternal(vg);
+	if (renderer.failed) {
+		printf("Out of memory.\n");
+		return -1;
+	}
+
+#ifdef NVG_NO_SIMD
+	printf("scalar: %d draws, %d bytes of vertex data\n", renderer.ndraws, renderer.size);
+#else
+	printf("simd: %d draws, %d bytes of vertex data\n", renderer.ndraws, renderer.size);
+#endif
+
+	if (output != NULL && !writeFile(output, renderer.data, renderer.size)) {
+		printf("Could not write '%s'.\n", output);
+		ret = -1;
+	}
+
+	if (reference != NULL) {
+		ref = readFile(reference, &refSize);
+		if (ref == NULL) {
+			printf("Could not read '%s'.\n", reference);
+			ret = -1;
+		} else {
+			// Find first differing byte and the draw call it belongs to.
+			for (diff = 0; diff < refSize && diff < renderer.size; diff++) {
+				if (ref[diff] != renderer.data[diff]) break;
+			}
+			if (diff < refSize || diff < renderer.size) {
+				for (draw = 0; draw+1 < renderer.ndraws && renderer.draws[draw+1] <= diff; draw++);
+				printf("FAILED: vertex data differs from '%s' at byte %d, draw %d (%d vs %d bytes).\n",
+					   reference, diff, draw, renderer.size, refSize);
+				ret = 1;
+			} else {
+				printf("Vertex data matches '%s'.\n", reference);
+			}
+			free(ref);
+		}
+	}
+
+	free(renderer.data);
+	free(renderer.draws);
+
+	return ret;
+}
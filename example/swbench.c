@@ -0,0 +1,425 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+// Headless benchmark for the software nanovg back-end. Draws an editor like
+// frame with panels, gradients, strokes and lots of text, and times it with
+// different number of worker threads. Optionally writes the result as PPM,
+// and records the frames for nvgreplay.
+//
+// When built with SWBENCH_GL the same frame is drawn with the GL3 back-end
+// instead, on a headless EGL context (Mesa surfaceless platform), and the
+// number of glDraw* calls and the frame time distribution are reported.
+// Building it also with NANOVG_GL_NO_PERSISTENT_MAP compares the orphaned
+// buffer updates against the persistently mapped rings.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "nanovg.h"
+#define NANOVG_SW_IMPLEMENTATION
+#include "nanovg_sw.h"
+#define NANOVG_REC_IMPLEMENTATION
+#include "nanovg_rec.h"
+#ifdef SWBENCH_GL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#define NANOVG_GL3_IMPLEMENTATION
+#include "nanovg_gl.h"
+#endif
+
+#define WIDTH 1280
+#define HEIGHT 800
+
+static double getTime()
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, t;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&t);
+	return (double)t.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+static void drawPanel(struct NVGcontext* vg, float x, float y, float w, float h, const char* title)
+{
+	struct NVGpaint shadow, header;
+
+	// Drop shadow
+	shadow = nvgBoxGradient(vg, x,y+2, w,h, 6, 10, nvgRGBA(0,0,0,128), nvgRGBA(0,0,0,0));
+	nvgBeginPath(vg);
+	nvgRect(vg, x-10,y-10, w+20,h+30);
+	nvgRoundedRect(vg, x,y, w,h, 4);
+	nvgPathWinding(vg, NVG_HOLE);
+	nvgFillPaint(vg, shadow);
+	nvgFill(vg);
+
+	nvgBeginPath(vg);
+	nvgRoundedRect(vg, x,y, w,h, 4);
+	nvgFillColor(vg, nvgRGBA(28,30,34,230));
+	nvgFill(vg);
+
+	header = nvgLinearGradient(vg, x,y, x,y+24, nvgRGBA(255,255,255,16), nvgRGBA(0,0,0,16));
+	nvgBeginPath(vg);
+	nvgRoundedRect(vg, x+1,y+1, w-2,24, 3);
+	nvgFillPaint(vg, header);
+	nvgFill(vg);
+
+	nvgFontSize(vg, 16.0f);
+	nvgFontFace(vg, "sans-bold");
+	nvgTextAlign(vg, NVG_ALIGN_LEFT|NVG_ALIGN_MIDDLE);
+	nvgFillColor(vg, nvgRGBA(220,220,220,200));
+	nvgText(vg, x+10, y+13, title, NULL);
+}
+
+static void drawList(struct NVGcontext* vg, float x, float y, float w, float h)
+{
+	char label[64];
+	int i, n = (int)(h / 22);
+
+	nvgSave(vg);
+	nvgScissor(vg, x, y, w, h);
+
+	nvgFontSize(vg, 14.0f);
+	nvgFontFace(vg, "sans");
+	nvgTextAlign(vg, NVG_ALIGN_LEFT|NVG_ALIGN_MIDDLE);
+	for (i = 0; i < n; i++) {
+		float ry = y + i*22;
+		if (i == 3) {
+			nvgBeginPath(vg);
+			nvgRoundedRect(vg, x+2, ry+1, w-4, 20, 3);
+			nvgFillColor(vg, nvgRGBA(0,96,128,255));
+			nvgFill(vg);
+		}
+		nvgBeginPath(vg);
+		nvgCircle(vg, x+12, ry+11, 5);
+		nvgFillColor(vg, nvgHSLA(i*0.07f, 0.6f, 0.5f, 255));
+		nvgFill(vg);
+
+		snprintf(label, sizeof(label), "Material %d - metal, rough %.2f", i, (i % 10) * 0.1f);
+		nvgFillColor(vg, nvgRGBA(255,255,255,160));
+		nvgText(vg, x+24, ry+11, label, NULL);
+	}
+
+	nvgRestore(vg);
+}
+
+static void drawGraph(struct NVGcontext* vg, float x, float y, float w, float h, float t)
+{
+	struct NVGpaint bg;
+	float sx[6], sy[6];
+	float dx = w/5.0f;
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		sx[i] = x + i*dx;
+		sy[i] = y + h*(0.5f + 0.4f*sinf(t + i*1.3f));
+	}
+
+	bg = nvgLinearGradient(vg, x,y, x,y+h, nvgRGBA(0,160,192,0), nvgRGBA(0,160,192,64));
+	nvgBeginPath(vg);
+	nvgMoveTo(vg, sx[0], sy[0]);
+	for (i = 1; i < 6; i++)
+		nvgBezierTo(vg, sx[i-1]+dx*0.5f,sy[i-1], sx[i]-dx*0.5f,sy[i], sx[i],sy[i]);
+	nvgLineTo(vg, x+w, y+h);
+	nvgLineTo(vg, x, y+h);
+	nvgFillPaint(vg, bg);
+	nvgFill(vg);
+
+	nvgBeginPath(vg);
+	nvgMoveTo(vg, sx[0], sy[0]);
+	for (i = 1; i < 6; i++)
+		nvgBezierTo(vg, sx[i-1]+dx*0.5f,sy[i-1], sx[i]-dx*0.5f,sy[i], sx[i],sy[i]);
+	nvgStrokeColor(vg, nvgRGBA(0,160,192,255));
+	nvgStrokeWidth(vg, 3.0f);
+	nvgStroke(vg);
+}
+
+static void drawFrame(struct NVGcontext* vg, float t)
+{
+	struct NVGpaint bg;
+	int i;
+
+	nvgBeginFrame(vg, WIDTH, HEIGHT, 1.0f, NVG_STRAIGHT_ALPHA);
+
+	bg = nvgLinearGradient(vg, 0,0, 0,HEIGHT, nvgRGBA(60,64,72,255), nvgRGBA(32,34,38,255));
+	nvgBeginPath(vg);
+	nvgRect(vg, 0,0, WIDTH,HEIGHT);
+	nvgFillPaint(vg, bg);
+	nvgFill(vg);
+
+	drawPanel(vg, 20, 20, 300, HEIGHT-40, "Materials");
+	drawList(vg, 20, 50, 300, HEIGHT-80);
+
+	drawPanel(vg, 340, 20, WIDTH-600, HEIGHT-240, "Viewport");
+	for (i = 0; i < 40; i++) {
+		float a = t + i*0.3f;
+		nvgBeginPath(vg);
+		nvgCircle(vg, 340+(WIDTH-600)*0.5f + cosf(a)*(100+i*4), 20+(HEIGHT-240)*0.5f + sinf(a*1.3f)*(80+i*3), 10+i*0.5f);
+		nvgFillColor(vg, nvgHSLA(i/40.0f, 0.7f, 0.5f, 160));
+		nvgFill(vg);
+		nvgStrokeColor(vg, nvgRGBA(0,0,0,96));
+		nvgStrokeWidth(vg, 1.0f);
+		nvgStroke(vg);
+	}
+
+	drawPanel(vg, 340, HEIGHT-200, WIDTH-600, 180, "Timeline");
+	drawGraph(vg, 350, HEIGHT-170, WIDTH-620, 140, t);
+
+	drawPanel(vg, WIDTH-240, 20, 220, HEIGHT-40, "Properties");
+	drawList(vg, WIDTH-240, 50, 220, HEIGHT-80);
+
+	nvgEndFrame(vg);
+}
+
+static void writePPM(const char* filename, const unsigned char* rgba, int w, int h)
+{
+	FILE* fp = fopen(filename, "wb");
+	int i;
+	if (fp == NULL) return;
+	fprintf(fp, "P6\n%d %d\n255\n", w, h);
+	for (i = 0; i < w*h; i++)
+		fwrite(&rgba[i*4], 1, 3, fp);
+	fclose(fp);
+}
+
+static int loadFonts(struct NVGcontext* vg, const char* path)
+{
+	char filename[256];
+	snprintf(filename, sizeof(filename), "%s/Roboto-Regular.ttf", path);
+	if (nvgCreateFont(vg, "sans", filename) == -1) return -1;
+	snprintf(filename, sizeof(filename), "%s/Roboto-Bold.ttf", path);
+	if (nvgCreateFont(vg, "sans-bold", filename) == -1) return -1;
+	return 0;
+}
+
+#ifdef SWBENCH_GL
+// Creates a GL 3.3 core context without a window and binds a framebuffer object to draw to.
+static int initGL(int w, int h)
+{
+	EGLint configAttribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLint contextAttribs[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, EGL_NONE };
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay;
+	EGLDisplay display;
+	EGLConfig config;
+	EGLContext context;
+	EGLint major, minor, n;
+	GLuint fbo, rb[2];
+
+	getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay == NULL) return -1;
+	display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) return -1;
+	if (!eglChooseConfig(display, configAttribs, &config, 1, &n) || n < 1) return -1;
+	eglBindAPI(EGL_OPENGL_API);
+	context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+	if (context == EGL_NO_CONTEXT) return -1;
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) return -1;
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glGenRenderbuffers(2, rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, rb[0]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rb[0]);
+	glBindRenderbuffer(GL_RENDERBUFFER, rb[1]);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rb[1]);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) return -1;
+	glViewport(0, 0, w, h);
+
+	printf("GL %s, %s\n", glGetString(GL_VERSION), glGetString(GL_RENDERER));
+	return 0;
+}
+
+static int cmpTime(const void* a, const void* b)
+{
+	double ta = *(const double*)a, tb = *(const double*)b;
+	return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+static void clearGL()
+{
+	glClearColor(0,0,0,0);
+	glClear(GL_COLOR_BUFFER_BIT|GL_STENCIL_BUFFER_BIT);
+}
+
+// Draws the frames with the GL3 back-end and reads the last one back to 'pixels'.
+static int benchGL(const char* fontPath, unsigned char* pixels, int frames)
+{
+	struct NVGcontext* vg;
+	struct NVGframeStats stats;
+	double t0, t1, total = 0.0;
+	double* times;
+	int i;
+
+	times = (double*)malloc(sizeof(double) * frames);
+	if (times == NULL) return -1;
+	if (initGL(WIDTH, HEIGHT)) {
+		printf("Could not init headless GL.\n");
+		return -1;
+	}
+	vg = nvgCreateGL3(512, 512, 1);
+	if (vg == NULL) {
+		printf("Could not init nanovg.\n");
+		return -1;
+	}
+	if (loadFonts(vg, fontPath)) {
+		printf("Could not load fonts from '%s'.\n", fontPath);
+		return -1;
+	}
+
+	// Warm up glyph cache.
+	clearGL();
+	drawFrame(vg, 0.0f);
+	glFinish();
+
+	// CPU time from the start of the frame to the flush, the GPU is not waited
+	// for, so that stalls on buffers still in use show up.
+	for (i = 0; i < frames; i++) {
+		t0 = getTime();
+		clearGL();
+		drawFrame(vg, 0.0f);
+		glFlush();
+		t1 = getTime();
+		times[i] = (t1 - t0) * 1000.0;
+		total += times[i];
+	}
+	glFinish();
+
+	nvgFrameStats(vg, &stats);
+	qsort(times, frames, sizeof(double), cmpTime);
+#ifdef NANOVG_GL_USE_PERSISTENT_MAP
+	printf("  GL3 persistent map if supported, %d frames\n", frames);
+#else
+	printf("  GL3 orphaned buffers, %d frames\n", frames);
+#endif
+	printf("  avg %8.3f ms  p99 %8.3f ms  max %8.3f ms\n", total / frames, times[(frames-1) * 99 / 100], times[frames-1]);
+	printf("  %d nanovg calls, %d GL draw calls\n", stats.drawCalls, stats.renderDrawCalls);
+	free(times);
+
+	// GL rows are bottom up.
+	for (i = 0; i < HEIGHT; i++)
+		glReadPixels(0, HEIGHT-1-i, WIDTH, 1, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[i*WIDTH*4]);
+
+	nvgDeleteGL3(vg);
+	return 0;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+	const char* fontPath = "../example/fonts";
+	const char* output = NULL;
+	const char* record = NULL;
+	unsigned char* pixels;
+#ifndef SWBENCH_GL
+	int threads[] = {1, 2, 4, 8};
+#endif
+	int i, j, frames = 20;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-o") == 0 && i+1 < argc)
+			output = argv[++i];
+		else if (strcmp(argv[i], "-rec") == 0 && i+1 < argc)
+			record = argv[++i];
+		else if (strcmp(argv[i], "-n") == 0 && i+1 < argc)
+			frames = atoi(argv[++i]);
+		else
+			fontPath = argv[i];
+	}
+
+	if (frames < 1) frames = 1;
+	pixels = (unsigned char*)malloc(WIDTH*HEIGHT*4);
+	if (pixels == NULL) return -1;
+
+#ifdef SWBENCH_GL
+	printf("nanovg GL3 back-end, %dx%d\n", WIDTH, HEIGHT);
+	if (benchGL(fontPath, pixels, frames)) return -1;
+#else
+	printf("nanovg software back-end, %dx%d\n", WIDTH, HEIGHT);
+
+	for (i = 0; i < (int)(sizeof(threads)/sizeof(threads[0])); i++) {
+		struct NVGcontext* vg = nvgCreateSW(512, 512, 1, threads[i]);
+		double t0, t1;
+		if (vg == NULL) {
+			printf("Could not init nanovg.\n");
+			return -1;
+		}
+		if (loadFonts(vg, fontPath)) {
+			printf("Could not load fonts from '%s'.\n", fontPath);
+			return -1;
+		}
+
+		nvgSetTargetSW(vg, pixels, WIDTH, HEIGHT, WIDTH*4);
+
+		// Warm up glyph cache.
+		memset(pixels, 0, WIDTH*HEIGHT*4);
+		drawFrame(vg, 0.0f);
+
+		t0 = getTime();
+		for (j = 0; j < frames; j++) {
+			memset(pixels, 0, WIDTH*HEIGHT*4);
+			drawFrame(vg, 0.0f);
+		}
+		t1 = getTime();
+
+		printf("  %d thread%s %8.3f ms/frame\n", threads[i], threads[i] > 1 ? "s" : " ", (t1 - t0) * 1000.0 / frames);
+
+		nvgDeleteSW(vg);
+	}
+#endif
+
+	if (record != NULL) {
+		// Record a few animated frames while rendering them.
+		struct NVGcontext* swvg = nvgCreateSW(512, 512, 1, 1);
+		struct NVGcontext* vg = swvg != NULL ? nvgCreateRec(record, 512, 512, 1, swvg) : NULL;
+		if (vg == NULL || loadFonts(vg, fontPath)) {
+			printf("Could not record to '%s'.\n", record);
+			return -1;
+		}
+		nvgSetTargetSW(swvg, pixels, WIDTH, HEIGHT, WIDTH*4);
+		for (j = 0; j < frames; j++) {
+			memset(pixels, 0, WIDTH*HEIGHT*4);
+			drawFrame(vg, j / 60.0f);
+		}
+		nvgDeleteRec(vg);
+		nvgDeleteSW(swvg);
+		printf("Recorded %d frames to '%s'.\n", frames, record);
+	}
+
+	if (output != NULL)
+		writePPM(output, pixels, WIDTH, HEIGHT);
+
+	free(pixels);
+
+	return 0;
+}
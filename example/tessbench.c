@@ -0,0 +1,364 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+// Benchmark and tolerance check for nanovg bezier flattening. Fills single
+// bezier curves using a back-end which captures the flattened points, and
+// compares them against the true curve and against the recursive subdivision
+// nanovg used before.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "nanovg.h"
+
+#define MAX_POINTS 4096
+#define CURVE_SAMPLES 256
+
+struct TessRenderer {
+	float pts[MAX_POINTS*2];
+	int npts;
+};
+
+struct Curve {
+	float p[8];
+};
+
+static int tess__renderCreate(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+	return 1;
+}
+
+static int tess__renderCreateTexture(void* uptr, int type, int w, int h, const unsigned char* data)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(type);
+	NVG_NOTUSED(w); NVG_NOTUSED(h);
+	NVG_NOTUSED(data);
+	return 1;
+}
+
+static int tess__renderDeleteTexture(void* uptr, int image)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(image);
+	return 1;
+}
+
+static int tess__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(image);
+	NVG_NOTUSED(x); NVG_NOTUSED(y);
+	NVG_NOTUSED(w); NVG_NOTUSED(h);
+	NVG_NOTUSED(data);
+	return 1;
+}
+
+static int tess__renderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(image);
+	*w = *h = 512;
+	return 1;
+}
+
+static void tess__renderViewport(void* uptr, int width, int height, int alphaBlend)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(width); NVG_NOTUSED(height);
+	NVG_NOTUSED(alphaBlend);
+}
+
+static void tess__renderFlush(void* uptr, int alphaBlend)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(alphaBlend);
+}
+
+// Without anti-aliasing the fill vertices are the flattened points.
+static void tess__renderFill(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe, const float* bounds, const struct NVGpath* paths, int npaths)
+{
+	struct TessRenderer* r = (struct TessRenderer*)uptr;
+	int i;
+	NVG_NOTUSED(paint); NVG_NOTUSED(scissor);
+	NVG_NOTUSED(fringe); NVG_NOTUSED(bounds);
+	r->npts = 0;
+	if (npaths < 1) return;
+	for (i = 0; i < paths[0].nfill && r->npts < MAX_POINTS; i++) {
+		r->pts[r->npts*2+0] = paths[0].fill[i].x;
+		r->pts[r->npts*2+1] = paths[0].fill[i].y;
+		r->npts++;
+	}
+}
+
+static void tess__renderStroke(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe, float strokeWidth, const struct NVGpath* paths, int npaths)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(paint); NVG_NOTUSED(scissor);
+	NVG_NOTUSED(fringe); NVG_NOTUSED(strokeWidth);
+	NVG_NOTUSED(paths); NVG_NOTUSED(npaths);
+}
+
+static void tess__renderTriangles(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, const struct NVGvertex* verts, int nverts)
+{
+	NVG_NOTUSED(uptr); NVG_NOTUSED(paint); NVG_NOTUSED(scissor);
+	NVG_NOTUSED(verts); NVG_NOTUSED(nverts);
+}
+
+static void tess__renderDelete(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+}
+
+static struct NVGcontext* createTessContext(struct TessRenderer* r)
+{
+	struct NVGparams params;
+
+	memset(r, 0, sizeof(*r));
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = tess__renderCreate;
+	params.renderCreateTexture = tess__renderCreateTexture;
+	params.renderDeleteTexture = tess__renderDeleteTexture;
+	params.renderUpdateTexture = tess__renderUpdateTexture;
+	params.renderGetTextureSize = tess__renderGetTextureSize;
+	params.renderViewport = tess__renderViewport;
+	params.renderFlush = tess__renderFlush;
+	params.renderFill = tess__renderFill;
+	params.renderStroke = tess__renderStroke;
+	params.renderTriangles = tess__renderTriangles;
+	params.renderDelete = tess__renderDelete;
+	params.userPtr = r;
+	params.atlasWidth = 512;
+	params.atlasHeight = 512;
+	params.edgeAntiAlias = 0;
+
+	return nvgCreateInternal(&params);
+}
+
+static double getTime()
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, t;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&t);
+	return (double)t.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Recursive subdivision nanovg used before the iterative flattener, tolerance 1.0.
+static void refTesselate(float x1, float y1, float x2, float y2, float x3, float y3, float x4, float y4,
+						 int level, float* pts, int* npts)
+{
+	float x12,y12,x23,y23,x34,y34,x123,y123,x234,y234,x1234,y1234;
+	float dx,dy,d2,d3;
+
+	if (level > 10) return;
+
+	x12 = (x1+x2)*0.5f;
+	y12 = (y1+y2)*0.5f;
+	x23 = (x2+x3)*0.5f;
+	y23 = (y2+y3)*0.5f;
+	x34 = (x3+x4)*0.5f;
+	y34 = (y3+y4)*0.5f;
+	x123 = (x12+x23)*0.5f;
+	y123 = (y12+y23)*0.5f;
+
+	dx = x3 - x1;
+	dy = y3 - y1;
+	d2 = fabsf(((x2 - x4) * dy - (y2 - y4) * dx));
+	d3 = fabsf(((x3 - x4) * dy - (y3 - y4) * dx));
+
+	if ((d2 + d3)*(d2 + d3) < 1.0f * (dx*dx + dy*dy)) {
+		if (*npts < MAX_POINTS) {
+			pts[*npts*2+0] = x4;
+			pts[*npts*2+1] = y4;
+			(*npts)++;
+		}
+		return;
+	}
+
+	x234 = (x23+x34)*0.5f;
+	y234 = (y23+y34)*0.5f;
+	x1234 = (x123+x234)*0.5f;
+	y1234 = (y123+y234)*0.5f;
+
+	refTesselate(x1,y1, x12,y12, x123,y123, x1234,y1234, level+1, pts, npts);
+	refTesselate(x1234,y1234, x234,y234, x34,y34, x4,y4, level+1, pts, npts);
+}
+
+static float distPtSegSq(float x, float y, float px, float py, float qx, float qy)
+{
+	float pqx = qx-px, pqy = qy-py, dx = x-px, dy = y-py;
+	float d = pqx*pqx + pqy*pqy;
+	float t = pqx*dx + pqy*dy;
+	if (d > 0) t /= d;
+	if (t < 0) t = 0;
+	else if (t > 1) t = 1;
+	dx = px + t*pqx - x;
+	dy = py + t*pqy - y;
+	return dx*dx + dy*dy;
+}
+
+// Maximum distance from the curve to the closed polygon.
+static float curveError(const struct Curve* c, const float* pts, int npts)
+{
+	float maxd = 0;
+	int i, j;
+	for (i = 0; i <= CURVE_SAMPLES; i++) {
+		float t = (float)i / CURVE_SAMPLES, it = 1-t;
+		float x = it*it*it*c->p[0] + 3*it*it*t*c->p[2] + 3*it*t*t*c->p[4] + t*t*t*c->p[6];
+		float y = it*it*it*c->p[1] + 3*it*it*t*c->p[3] + 3*it*t*t*c->p[5] + t*t*t*c->p[7];
+		float mind = 1e30f;
+		for (j = 0; j < npts; j++) {
+			int k = (j+1) % npts;
+			float d = distPtSegSq(x, y, pts[j*2], pts[j*2+1], pts[k*2], pts[k*2+1]);
+			if (d < mind) mind = d;
+		}
+		if (mind > maxd) maxd = mind;
+	}
+	return sqrtf(maxd);
+}
+
+static float frand(unsigned int* seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return (float)((*seed >> 8) & 0xffff) / 65535.0f;
+}
+
+static int makeCurves(struct Curve* curves, int maxCurves)
+{
+	unsigned int seed = 1;
+	int i, j, n = 0;
+	float k = 0.5522847493f;
+
+	// Random curves from small icon details to large shapes.
+	for (i = 0; i < maxCurves/2; i++) {
+		float size = 4.0f * powf(2.0f, frand(&seed) * 8.0f);
+		float ox = frand(&seed) * 500, oy = frand(&seed) * 500;
+		for (j = 0; j < 8; j++)
+			curves[n].p[j] = (j & 1 ? oy : ox) + frand(&seed) * size;
+		n++;
+	}
+	// Quarter circles, like rounded rects and circles.
+	for (i = 0; n < maxCurves; i++) {
+		float r = 1.0f + (i % 200) * 2.0f;
+		float cx = 100, cy = 100;
+		float p[8] = {cx+r,cy, cx+r,cy+r*k, cx+r*k,cy+r, cx,cy+r};
+		memcpy(curves[n].p, p, sizeof(p));
+		n++;
+	}
+	return n;
+}
+
+static void drawCurve(struct NVGcontext* vg, const struct Curve* c)
+{
+	nvgBeginPath(vg);
+	nvgMoveTo(vg, c->p[0], c->p[1]);
+	nvgBezierTo(vg, c->p[2], c->p[3], c->p[4], c->p[5], c->p[6], c->p[7]);
+	nvgFill(vg);
+}
+
+int main()
+{
+	struct TessRenderer renderer;
+	struct NVGcontext* vg = NULL;
+	static struct Curve curves[2000];
+	static float refPts[MAX_POINTS*2];
+	int ncurves = makeCurves(curves, 2000);
+	int i, iter, iters = 50, refNpts;
+	int points = 0, refPoints = 0, worst = 0;
+	float err, maxErr = 0, refMaxErr = 0;
+	double sumErr = 0, refSumErr = 0;
+	double t0, t1, t2;
+
+	vg = createTessContext(&renderer);
+	if (vg == NULL) {
+		printf("Could not init nanovg.\n");
+		return -1;
+	}
+
+	// Tolerance check
+	nvgBeginFrame(vg, 1000, 1000, 1.0f, NVG_STRAIGHT_ALPHA);
+	for (i = 0; i < ncurves; i++) {
+		const float* p = curves[i].p;
+		drawCurve(vg, &curves[i]);
+		err = curveError(&curves[i], renderer.pts, renderer.npts);
+		points += renderer.npts;
+		sumErr += err;
+		if (err > maxErr) {
+			maxErr = err;
+			worst = i;
+		}
+
+		refPts[0] = p[0];
+		refPts[1] = p[1];
+		refNpts = 1;
+		refTesselate(p[0],p[1], p[2],p[3], p[4],p[5], p[6],p[7], 0, refPts, &refNpts);
+		err = curveError(&curves[i], refPts, refNpts);
+		refPoints += refNpts;
+		refSumErr += err;
+		if (err > refMaxErr) refMaxErr = err;
+	}
+	nvgEndFrame(vg);
+
+	// Timing, the curve fill includes flattening and expanding the path.
+	t0 = getTime();
+	for (iter = 0; iter < iters; iter++) {
+		nvgBeginFrame(vg, 1000, 1000, 1.0f, NVG_STRAIGHT_ALPHA);
+		for (i = 0; i < ncurves; i++)
+			drawCurve(vg, &curves[i]);
+		nvgEndFrame(vg);
+	}
+	t1 = getTime();
+	for (iter = 0; iter < iters; iter++) {
+		for (i = 0; i < ncurves; i++) {
+			const float* p = curves[i].p;
+			refNpts = 0;
+			refTesselate(p[0],p[1], p[2],p[3], p[4],p[5], p[6],p[7], 0, refPts, &refNpts);
+		}
+	}
+	t2 = getTime();
+
+	printf("%d curves\n", ncurves);
+	printf("  nanovg     %7d points, max error %.3f px, avg error %.3f px, %.3f us/curve (fill)\n",
+		   points, maxErr, sumErr / ncurves, (t1 - t0) * 1e6 / (iters * ncurves));
+	printf("  recursive  %7d points, max error %.3f px, avg error %.3f px, %.3f us/curve (flatten only)\n",
+		   refPoints, refMaxErr, refSumErr / ncurves, (t2 - t1) * 1e6 / (iters * ncurves));
+	printf("  worst curve %d: %.1f,%.1f %.1f,%.1f %.1f,%.1f %.1f,%.1f\n", worst,
+		   curves[worst].p[0], curves[worst].p[1], curves[worst].p[2], curves[worst].p[3],
+		   curves[worst].p[4], curves[worst].p[5], curves[worst].p[6], curves[worst].p[7]);
+
+	nvgDeleteInternal(vg);
+
+	// Half a pixel is where the flattening starts to be visible with anti-aliasing.
+	if (maxErr > 0.5f) {
+		printf("FAILED: flattening error %.3f px is over tolerance 0.5 px.\n", maxErr);
+		return 1;
+	}
+	printf("Tolerance check passed.\n");
+
+	return 0;
+}
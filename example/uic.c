@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+// Compiles text UI description into binary blob which can be loaded with miCreateFromUI().
+// Usage: uic input.txt output.mui
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "nanovg.h"
+#include "milli.h"
+#define NANOSVG_IMPLEMENTATION 1
+#include "nanosvg.h"
+
+static char* readFile(const char* path)
+{
+	FILE* fp = NULL;
+	char* data = NULL;
+	long size = 0;
+
+	fp = fopen(path, "rb");
+	if (fp == NULL) goto error;
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	data = (char*)malloc(size+1);
+	if (data == NULL) goto error;
+	if (fread(data, 1, size, fp) != (size_t)size) goto error;
+	data[size] = '\0';
+	fclose(fp);
+	return data;
+
+error:
+	if (fp != NULL) fclose(fp);
+	free(data);
+	return NULL;
+}
+
+int main(int argc, char** argv)
+{
+	FILE* fp = NULL;
+	char* text = NULL;
+	void* data = NULL;
+	int size = 0;
+	const struct MIuiHeader* hdr;
+
+	if (argc < 3) {
+		printf("usage: uic input.txt output.mui\n");
+		return 1;
+	}
+
+	text = readFile(argv[1]);
+	if (text == NULL) {
+		printf("Could not read '%s'.\n", argv[1]);
+		goto error;
+	}
+
+	if (!miCompileUI(text, &data, &size)) {
+		printf("Could not compile '%s'.\n", argv[1]);
+		goto error;
+	}
+
+	fp = fopen(argv[2], "wb");
+	if (fp == NULL) {
+		printf("Could not open '%s' for writing.\n", argv[2]);
+		goto error;
+	}
+	if (fwrite(data, 1, size, fp) != (size_t)size) {
+		printf("Could not write '%s'.\n", argv[2]);
+		goto error;
+	}
+	fclose(fp);
+
+	hdr = (const struct MIuiHeader*)data;
+	printf("%s: %d cells, %d params, %d bytes of strings, %d bytes total.\n", argv[2], hdr->cellCount, hdr->paramCount, hdr->stringsSize, size);
+
+	free(text);
+	free(data);
+	return 0;
+
+error:
+	if (fp != NULL) fclose(fp);
+	free(text);
+	free(data);
+	return 1;
+}
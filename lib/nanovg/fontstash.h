@@ -21,6 +21,12 @@
 
 #define FONS_INVALID -1
 
+// Max number of atlas pages. When all pages are full, the least recently used page is
+// cleared and reused, see fonsBeginFrame().
+#ifndef FONS_MAX_PAGES
+#	define FONS_MAX_PAGES 4
+#endif
+
 enum FONSflags {
 	FONS_ZERO_TOPLEFT = 1,
 	FONS_ZERO_BOTTOMLEFT = 2,
@@ -38,6 +44,12 @@ enum FONSalign {
 	FONS_ALIGN_BASELINE	= 1<<6, // Default
 };
 
+enum FONSglyphBitmap {
+	// Glyph metrics only, the bitmap is not rasterized to the atlas.
+	FONS_GLYPH_BITMAP_OPTIONAL = 1,
+	FONS_GLYPH_BITMAP_REQUIRED = 2,
+};
+
 enum FONSerrorCode {
 	// Font atlas is full.
 	FONS_ATLAS_FULL = 1,
@@ -70,8 +82,10 @@ struct FONStextIter {
 	float x, y, nextx, nexty, scale, spacing;
 	unsigned int codepoint;
 	short isize, iblur;
+	int bitmapOption;
+	int page;			// Atlas page of the current quad.
 	struct FONSfont* font;
-	struct FONSglyph* prevGlyph;
+	int prevGlyphIndex;	// Font glyph index of the current quad, -1 if the glyph is missing.
 	const char* str;
 	const char* next;
 	const char* end;
@@ -89,6 +103,23 @@ void fonsGetAtlasSize(struct FONScontext* s, int* width, int* height);
 int fonsExpandAtlas(struct FONScontext* s, int width, int height);
 // Reseta the whole stash.
 int fonsResetAtlas(struct FONScontext* stash, int width, int height);
+// Returns counter which changes every time the atlas is reset or resized, and previously returned quads become invalid.
+int fonsGetAtlasGeneration(struct FONScontext* s);
+
+// Starts new frame. Glyphs are stamped when used, the atlas pages which have not been
+// used during the current frame can be evicted to make room for new glyphs.
+// Evicting a page bumps the atlas generation.
+void fonsBeginFrame(struct FONScontext* s);
+// Marks page used in current frame, when the glyph quads are cached by the caller.
+void fonsTouchPage(struct FONScontext* s, int page);
+
+// Starts worker threads which rasterize new glyphs in the background. The space for the glyph
+// is reserved right away, the bitmap is copied into the atlas by fonsBeginFrame() once it is ready.
+// Returns number of started workers, 0 if threads are not supported.
+int fonsStartWorkers(struct FONScontext* s, int threads);
+// Waits until all queued glyphs are rasterized, and copies them into the atlas.
+// Glyphs can be prewarmed at startup by laying out the text and waiting.
+void fonsWaitGlyphs(struct FONScontext* s);
 
 // Add fonts
 int fonsAddFont(struct FONScontext* s, const char* name, const char* path);
@@ -117,12 +148,18 @@ void fonsLineBounds(struct FONScontext* s, float y, float* miny, float* maxy);
 void fonsVertMetrics(struct FONScontext* s, float* ascender, float* descender, float* lineh);
 
 // Text iterator
-int fonsTextIterInit(struct FONScontext* stash, struct FONStextIter* iter, float x, float y, const char* str, const char* end);
+// Pass FONS_GLYPH_BITMAP_OPTIONAL as bitmapOption when only measuring, the quad texture coordinates are not valid then.
+int fonsTextIterInit(struct FONScontext* stash, struct FONStextIter* iter, float x, float y, const char* str, const char* end, int bitmapOption);
 int fonsTextIterNext(struct FONScontext* stash, struct FONStextIter* iter, struct FONSquad* quad);
 
 // Pull texture changes
 const unsigned char* fonsGetTextureData(struct FONScontext* stash, int* width, int* height);
 int fonsValidateTexture(struct FONScontext* s, int* dirty);
+// Multiple atlas pages are used only when the render callbacks are not set,
+// the above access the first page.
+int fonsGetPageCount(struct FONScontext* s);
+const unsigned char* fonsGetPageTextureData(struct FONScontext* stash, int page, int* width, int* height);
+int fonsValidatePageTexture(struct FONScontext* s, int page, int* dirty);
 
 // Draws the stash texture for debugging
 void fonsDrawDebug(struct FONScontext* s, float x, float y);
@@ -134,6 +171,22 @@ void fonsDrawDebug(struct FONScontext* s, float x, float y);
 
 #define FONS_NOTUSED(v)  (void)sizeof(v)
 
+// FreeType faces keep the glyph slot state, they cannot be shared with the workers.
+#if defined(FONS_USE_FREETYPE) && !defined(FONS_NO_THREADS)
+#	define FONS_NO_THREADS
+#endif
+
+#ifndef FONS_NO_THREADS
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#endif
+
 #ifdef FONS_USE_FREETYPE
 
 #include <ft2build.h>
@@ -232,6 +285,7 @@ int fons__tt_getGlyphKernAdvance(struct FONSttFontImpl *font, int glyph1, int gl
 #define STB_TRUETYPE_IMPLEMENTATION
 static void* fons__tmpalloc(size_t size, void* up);
 static void fons__tmpfree(void* ptr, void* up);
+static void* fons__scratch(struct FONScontext* stash);
 #define STBTT_malloc(x,u)    fons__tmpalloc(x,u)
 #define STBTT_free(x,u)      fons__tmpfree(x,u)
 #include "stb_truetype.h"
@@ -251,7 +305,7 @@ int fons__tt_loadFont(struct FONScontext *context, struct FONSttFontImpl *font,
 	int stbError;
 	FONS_NOTUSED(dataSize);
 
-	font->font.userdata = context;
+	font->font.userdata = fons__scratch(context);
 	stbError = stbtt_InitFont(&font->font, data, 0);
 	return stbError;
 }
@@ -312,6 +366,13 @@ int fons__tt_getGlyphKernAdvance(struct FONSttFontImpl *font, int glyph1, int gl
 #ifndef FONS_MAX_STATES
 #	define FONS_MAX_STATES 20
 #endif
+#ifndef FONS_MAX_WORKERS
+#	define FONS_MAX_WORKERS 8
+#endif
+// Measured only glyphs per font, above this the ones not used in the last frame are dropped.
+#ifndef FONS_MAX_MEASURED_GLYPHS
+#	define FONS_MAX_MEASURED_GLYPHS 1024
+#endif
 
 static unsigned int fons__hashint(unsigned int a)
 {
@@ -339,6 +400,8 @@ struct FONSglyph
 	unsigned int codepoint;
 	int index;
 	int next;
+	int page;
+	unsigned int lastUsed;
 	short size, blur;
 	short x0,y0,x1,y1;
 	short xadv,xoff,yoff;
@@ -357,6 +420,7 @@ struct FONSfont
 	struct FONSglyph* glyphs;
 	int cglyphs;
 	int nglyphs;
+	int nmeasured;		// Number of glyphs without bitmap (page -1).
 	int lut[FONS_HASH_LUT_SIZE];
 };
 
@@ -382,40 +446,109 @@ struct FONSatlas
 	int cnodes;
 };
 
+struct FONSpage
+{
+	struct FONSatlas* atlas;
+	unsigned char* texData;
+	int dirtyRect[4];
+	unsigned int lastUsed;
+	int nused;				// Glyph uses during the current frame.
+	unsigned int epoch;		// Changes when the page is cleared.
+};
+
+struct FONSscratch
+{
+	unsigned char data[FONS_SCRATCH_BUF_SIZE];
+	int n;
+	struct FONScontext* stash;	// For error reporting, NULL on worker threads.
+};
+
+// Glyph waiting to be rasterized by a worker, the atlas space is already reserved.
+struct FONSjob
+{
+	struct FONSfont* font;
+	int glyph;
+	float scale;
+	int pad, blur;
+	int page, x, y, w, h;
+	unsigned int epoch;		// Epoch of the page when queued, stale results are dropped.
+	unsigned char* data;	// Result, w*h pixels.
+	int done;
+};
+
+struct FONSworker
+{
+	struct FONScontext* stash;
+	struct FONSscratch scratch;
+#ifndef FONS_NO_THREADS
+#ifdef _WIN32
+	HANDLE thread;
+#else
+	pthread_t thread;
+#endif
+#endif
+};
+
 struct FONScontext
 {
 	struct FONSparams params;
 	float itw,ith;
-	unsigned char* texData;
-	int dirtyRect[4];
+	struct FONSpage pages[FONS_MAX_PAGES];
+	int npages;
+	int maxPages;
+	unsigned int frame;
+	int atlasFull;			// Set when glyphs could not be added during the frame.
+	unsigned int pageEpoch;
 	struct FONSfont** fonts;
-	struct FONSatlas* atlas;
 	int cfonts;
 	int nfonts;
 	float verts[FONS_VERTEX_COUNT*2];
 	float tcoords[FONS_VERTEX_COUNT*2];
 	unsigned int colors[FONS_VERTEX_COUNT];
 	int nverts;
-	unsigned char scratch[FONS_SCRATCH_BUF_SIZE];
-	int nscratch;
+	struct FONSscratch scratch;
 	struct FONSstate states[FONS_MAX_STATES];
 	int nstates;
 	void (*handleError)(void* uptr, int error, int val);
 	void* errorUptr;
+	int atlasGeneration;
+
+	// Background rasterization, the jobs are guarded by the lock. Job 'jobBase+i' is
+	// stored at jobs[i], jobs before 'nextJob' have been picked up by the workers.
+	struct FONSworker* workers;
+	int nworkers;
+	struct FONSjob* jobs;
+	int njobs;
+	int cjobs;
+	int nextJob;
+	int jobBase;
+	int nidle;
+	int quit;
+#ifndef FONS_NO_THREADS
+#ifdef _WIN32
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE start;
+	CONDITION_VARIABLE finish;
+#else
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t finish;
+#endif
+#endif
 };
 
 static void* fons__tmpalloc(size_t size, void* up)
 {
 	unsigned char* ptr;
 
-	struct FONScontext* stash = (struct FONScontext*)up;
-	if (stash->nscratch+(int)size > FONS_SCRATCH_BUF_SIZE) {
-		if (stash->handleError)
-			stash->handleError(stash->errorUptr, FONS_SCRATCH_FULL, stash->nscratch+(int)size);
+	struct FONSscratch* scratch = (struct FONSscratch*)up;
+	if (scratch->n+(int)size > FONS_SCRATCH_BUF_SIZE) {
+		if (scratch->stash != NULL && scratch->stash->handleError)
+			scratch->stash->handleError(scratch->stash->errorUptr, FONS_SCRATCH_FULL, scratch->n+(int)size);
 		return NULL;
 	}
-	ptr = stash->scratch + stash->nscratch;
-	stash->nscratch += (int)size;
+	ptr = scratch->data + scratch->n;
+	scratch->n += (int)size;
 	return ptr;
 }
 
@@ -426,6 +559,13 @@ static void fons__tmpfree(void* ptr, void* up)
 	// empty
 }
 
+#ifndef FONS_USE_FREETYPE
+static void* fons__scratch(struct FONScontext* stash)
+{
+	return &stash->scratch;
+}
+#endif
+
 // Copyright (c) 2008-2010 Bjoern Hoehrmann <bjoern@hoehrmann.de>
 // See http://bjoern.hoehrmann.de/utf-8/decoder/dfa/ for details.
 
@@ -647,25 +787,183 @@ static int fons__atlasAddRect(struct FONSatlas* atlas, int rw, int rh, int* rx,
 	return 1;
 }
 
+static void fons__flush(struct FONScontext* stash);
+
+static void fons__markDirty(struct FONSpage* page, int x0, int y0, int x1, int y1)
+{
+	page->dirtyRect[0] = fons__mini(page->dirtyRect[0], x0);
+	page->dirtyRect[1] = fons__mini(page->dirtyRect[1], y0);
+	page->dirtyRect[2] = fons__maxi(page->dirtyRect[2], x1);
+	page->dirtyRect[3] = fons__maxi(page->dirtyRect[3], y1);
+}
+
+static void fons__resetDirty(struct FONScontext* stash, struct FONSpage* page)
+{
+	page->dirtyRect[0] = stash->params.width;
+	page->dirtyRect[1] = stash->params.height;
+	page->dirtyRect[2] = 0;
+	page->dirtyRect[3] = 0;
+}
+
 static void fons__addWhiteRect(struct FONScontext* stash, int w, int h)
 {
 	int x, y, gx, gy;
 	unsigned char* dst;
-	if (fons__atlasAddRect(stash->atlas, w, h, &gx, &gy) == 0)
+	struct FONSpage* page = &stash->pages[0];
+	if (fons__atlasAddRect(page->atlas, w, h, &gx, &gy) == 0)
 		return;
 
 	// Rasterize
-	dst = &stash->texData[gx + gy * stash->params.width];
+	dst = &page->texData[gx + gy * stash->params.width];
 	for (y = 0; y < h; y++) {
 		for (x = 0; x < w; x++)
 			dst[x] = 0xff;
 		dst += stash->params.width;
 	}
 
-	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], gx);
-	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], gy);
-	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], gx+w);
-	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], gy+h);
+	fons__markDirty(page, gx, gy, gx+w, gy+h);
+}
+
+static void fons__freePage(struct FONSpage* page)
+{
+	if (page->atlas != NULL) fons__deleteAtlas(page->atlas);
+	if (page->texData != NULL) free(page->texData);
+	memset(page, 0, sizeof(*page));
+}
+
+static int fons__addPage(struct FONScontext* stash)
+{
+	struct FONSpage* page;
+	if (stash->npages >= stash->maxPages)
+		return 0;
+	page = &stash->pages[stash->npages];
+	memset(page, 0, sizeof(*page));
+
+	page->atlas = fons__allocAtlas(stash->params.width, stash->params.height, FONS_INIT_ATLAS_NODES);
+	if (page->atlas == NULL) goto error;
+	page->texData = (unsigned char*)malloc(stash->params.width * stash->params.height);
+	if (page->texData == NULL) goto error;
+	memset(page->texData, 0, stash->params.width * stash->params.height);
+	page->lastUsed = stash->frame;
+	page->epoch = ++stash->pageEpoch;
+
+	// New page is uploaded as whole.
+	page->dirtyRect[0] = 0;
+	page->dirtyRect[1] = 0;
+	page->dirtyRect[2] = stash->params.width;
+	page->dirtyRect[3] = stash->params.height;
+
+	stash->npages++;
+	return 1;
+
+error:
+	fons__freePage(page);
+	return 0;
+}
+
+static void fons__rebuildLut(struct FONSfont* font)
+{
+	int i;
+	for (i = 0; i < FONS_HASH_LUT_SIZE; i++)
+		font->lut[i] = -1;
+	for (i = 0; i < font->nglyphs; i++) {
+		unsigned int h = fons__hashint(font->glyphs[i].codepoint) & (FONS_HASH_LUT_SIZE-1);
+		font->glyphs[i].next = font->lut[h];
+		font->lut[h] = i;
+	}
+}
+
+// Returns the least recently used page which has not been used in the current frame, or -1.
+static int fons__lruPage(struct FONScontext* stash)
+{
+	int i, victim = -1;
+	for (i = 0; i < stash->npages; i++) {
+		if (stash->pages[i].lastUsed >= stash->frame)
+			continue;
+		if (victim == -1 || stash->pages[i].lastUsed < stash->pages[victim].lastUsed)
+			victim = i;
+	}
+	return victim;
+}
+
+// Removes the glyphs of the page (or none if -1) from the cache, and the measured only
+// glyphs which have not been used since 'frame'.
+static void fons__pruneGlyphs(struct FONScontext* stash, int victim, unsigned int frame)
+{
+	int i, j, n, nmeasured;
+	for (i = 0; i < stash->nfonts; i++) {
+		struct FONSfont* font = stash->fonts[i];
+		n = 0;
+		nmeasured = 0;
+		for (j = 0; j < font->nglyphs; j++) {
+			struct FONSglyph* glyph = &font->glyphs[j];
+			if (victim != -1 && glyph->page == victim)
+				continue;
+			if (glyph->page == -1) {
+				if (glyph->lastUsed < frame)
+					continue;
+				nmeasured++;
+			}
+			font->glyphs[n++] = *glyph;
+		}
+		if (n == font->nglyphs)
+			continue;
+		font->nglyphs = n;
+		font->nmeasured = nmeasured;
+		fons__rebuildLut(font);
+	}
+}
+
+// Clears the page and removes its glyphs from the cache.
+static void fons__evictPage(struct FONScontext* stash, int victim)
+{
+	struct FONSpage* page;
+
+	// Flush pending quads which may use the page.
+	fons__flush(stash);
+
+	page = &stash->pages[victim];
+	fons__atlasReset(page->atlas, stash->params.width, stash->params.height);
+	memset(page->texData, 0, stash->params.width * stash->params.height);
+	fons__markDirty(page, 0, 0, stash->params.width, stash->params.height);
+	page->nused = 0;
+	page->epoch = ++stash->pageEpoch;
+	if (victim == 0)
+		fons__addWhiteRect(stash, 2,2);
+
+	// Drop the glyphs of the page, prune also measured only glyphs which
+	// have not been needed in this frame.
+	fons__pruneGlyphs(stash, victim, stash->frame);
+
+	// Cached quads pointing to the page are stale.
+	stash->atlasGeneration++;
+}
+
+// Finds space for a glyph, adding or evicting pages if needed. Returns page index or -1.
+static int fons__allocGlyphRect(struct FONScontext* stash, int w, int h, int* x, int* y)
+{
+	int i;
+	for (i = stash->npages-1; i >= 0; i--) {
+		if (fons__atlasAddRect(stash->pages[i].atlas, w, h, x, y))
+			return i;
+	}
+	if (fons__addPage(stash)) {
+		i = stash->npages-1;
+		if (fons__atlasAddRect(stash->pages[i].atlas, w, h, x, y))
+			return i;
+	}
+	// Pages used in the current frame cannot be touched, since the quads
+	// referring to them may not have been drawn yet.
+	i = fons__lruPage(stash);
+	if (i != -1) {
+		fons__evictPage(stash, i);
+		if (fons__atlasAddRect(stash->pages[i].atlas, w, h, x, y))
+			return i;
+	}
+	// Glyphs which would not fit even an empty page are just skipped.
+	if (w <= stash->params.width && h <= stash->params.height)
+		stash->atlasFull = 1;
+	return -1;
 }
 
 struct FONScontext* fonsCreateInternal(struct FONSparams* params)
@@ -678,6 +976,7 @@ struct FONScontext* fonsCreateInternal(struct FONSparams* params)
 	memset(stash, 0, sizeof(struct FONScontext));
 
 	stash->params = *params;
+	stash->scratch.stash = stash;
 
 	// Initialize implementation library
 	if (!fons__tt_init(stash)) goto error;
@@ -687,9 +986,6 @@ struct FONScontext* fonsCreateInternal(struct FONSparams* params)
 			goto error;
 	}
 
-	stash->atlas = fons__allocAtlas(stash->params.width, stash->params.height, FONS_INIT_ATLAS_NODES);
-	if (stash->atlas == NULL) goto error;
-
 	// Allocate space for fonts.
 	stash->fonts = (struct FONSfont**)malloc(sizeof(struct FONSfont*) * FONS_INIT_FONTS);
 	if (stash->fonts == NULL) goto error;
@@ -697,17 +993,14 @@ struct FONScontext* fonsCreateInternal(struct FONSparams* params)
 	stash->cfonts = FONS_INIT_FONTS;
 	stash->nfonts = 0;
 
-	// Create texture for the cache.
+	// Create texture for the cache. The render callbacks know only about one texture.
 	stash->itw = 1.0f/stash->params.width;
 	stash->ith = 1.0f/stash->params.height;
-	stash->texData = (unsigned char*)malloc(stash->params.width * stash->params.height);
-	if (stash->texData == NULL) goto error;
-	memset(stash->texData, 0, stash->params.width * stash->params.height);
-
-	stash->dirtyRect[0] = stash->params.width;
-	stash->dirtyRect[1] = stash->params.height;
-	stash->dirtyRect[2] = 0;
-	stash->dirtyRect[3] = 0;
+	stash->maxPages = 1;
+	if (stash->params.renderUpdate == NULL && stash->params.renderDraw == NULL)
+		stash->maxPages = FONS_MAX_PAGES;
+	if (!fons__addPage(stash)) goto error;
+	fons__resetDirty(stash, &stash->pages[0]);
 
 	// Add white rect at 0,0 for debug drawing.
 	fons__addWhiteRect(stash, 2,2);
@@ -875,7 +1168,7 @@ int fonsAddFontMem(struct FONScontext* stash, const char* name, unsigned char* d
 	font->freeData = (unsigned char)freeData;
 
 	// Init font
-	stash->nscratch = 0;
+	stash->scratch.n = 0;
 	if (!fons__tt_loadFont(stash, &font->font, data, dataSize)) goto error;
 
 	// Store normalized line height. The real line height is got
@@ -982,32 +1275,345 @@ static void fons__blur(struct FONScontext* stash, unsigned char* dst, int w, int
 //	fons__blurcols(dst, w, h, dstStride, alpha);
 }
 
+// Rasterizes the glyph on the calling thread into its reserved rect of the page.
+static void fons__rasterizeGlyph(struct FONScontext* stash, struct FONSfont* font, int g, float scale, int pad, int blur,
+								 struct FONSpage* page, int x0, int y0, int gw, int gh)
+{
+	unsigned char* dst;
+	int x, y;
+
+	// Rasterize
+	stash->scratch.n = 0;
+	dst = &page->texData[(x0+pad) + (y0+pad) * stash->params.width];
+	fons__tt_renderGlyphBitmap(&font->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale,scale, g);
+
+	// Make sure there is one pixel empty border.
+	dst = &page->texData[x0 + y0 * stash->params.width];
+	for (y = 0; y < gh; y++) {
+		dst[y*stash->params.width] = 0;
+		dst[gw-1 + y*stash->params.width] = 0;
+	}
+	for (x = 0; x < gw; x++) {
+		dst[x] = 0;
+		dst[x + (gh-1)*stash->params.width] = 0;
+	}
+
+	// Debug code to color the glyph background
+/*	unsigned char* fdst = &page->texData[x0 + y0 * stash->params.width];
+	for (y = 0; y < gh; y++) {
+		for (x = 0; x < gw; x++) {
+			int a = (int)fdst[x+y*stash->params.width] + 20;
+			if (a > 255) a = 255;
+			fdst[x+y*stash->params.width] = a;
+		}
+	}*/
+
+	// Blur
+	if (blur > 0) {
+		stash->scratch.n = 0;
+		fons__blur(stash, dst, gw,gh, stash->params.width, blur);
+	}
+
+	fons__markDirty(page, x0, y0, x0+gw, y0+gh);
+}
+
+// Glyphs which have been only measured so far have no space in the atlas, x0 and y0 are -1.
+#ifndef FONS_NO_THREADS
+
+static void fons__lock(struct FONScontext* stash)
+{
+#ifdef _WIN32
+	EnterCriticalSection(&stash->lock);
+#else
+	pthread_mutex_lock(&stash->lock);
+#endif
+}
+
+static void fons__unlock(struct FONScontext* stash)
+{
+#ifdef _WIN32
+	LeaveCriticalSection(&stash->lock);
+#else
+	pthread_mutex_unlock(&stash->lock);
+#endif
+}
+
+// Waits on the condition, the lock must be held.
+#ifdef _WIN32
+static void fons__wait(struct FONScontext* stash, CONDITION_VARIABLE* cond)
+{
+	SleepConditionVariableCS(cond, &stash->lock, INFINITE);
+}
+
+static void fons__wakeOne(CONDITION_VARIABLE* cond)
+{
+	WakeConditionVariable(cond);
+}
+
+static void fons__wakeAll(CONDITION_VARIABLE* cond)
+{
+	WakeAllConditionVariable(cond);
+}
+#else
+static void fons__wait(struct FONScontext* stash, pthread_cond_t* cond)
+{
+	pthread_cond_wait(cond, &stash->lock);
+}
+
+static void fons__wakeOne(pthread_cond_t* cond)
+{
+	pthread_cond_signal(cond);
+}
+
+static void fons__wakeAll(pthread_cond_t* cond)
+{
+	pthread_cond_broadcast(cond);
+}
+#endif
+
+// Renders the glyph of the job into a new buffer, the border is left empty.
+static unsigned char* fons__renderJob(struct FONSjob* job, struct FONSscratch* scratch)
+{
+	struct FONSttFontImpl tt;
+	unsigned char* data = (unsigned char*)malloc(job->w * job->h);
+	if (data == NULL) return NULL;
+	memset(data, 0, job->w * job->h);
+
+	// The font data is shared, the rasterizer temp memory is per worker.
+	tt = job->font->font;
+	tt.font.userdata = scratch;
+	scratch->n = 0;
+	fons__tt_renderGlyphBitmap(&tt, &data[job->pad + job->pad*job->w], job->w-job->pad*2, job->h-job->pad*2, job->w, job->scale, job->scale, job->glyph);
+
+	if (job->blur > 0)
+		fons__blur(NULL, data, job->w, job->h, job->w, job->blur);
+
+	return data;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI fons__workerThread(LPVOID arg)
+#else
+static void* fons__workerThread(void* arg)
+#endif
+{
+	struct FONSworker* worker = (struct FONSworker*)arg;
+	struct FONScontext* stash = worker->stash;
+	struct FONSjob job;
+	int seq;
+
+	fons__lock(stash);
+	for (;;) {
+		while (stash->nextJob == stash->njobs && !stash->quit) {
+			stash->nidle++;
+			fons__wait(stash, &stash->start);
+			stash->nidle--;
+		}
+		if (stash->quit) break;
+
+		// The job array may be moved while rendering, refer to the job by sequence number.
+		seq = stash->jobBase + stash->nextJob;
+		job = stash->jobs[stash->nextJob++];
+		// Pass the wake up along, so that the main thread only needs to wake one worker.
+		if (stash->nextJob < stash->njobs && stash->nidle > 0)
+			fons__wakeOne(&stash->start);
+		fons__unlock(stash);
+
+		job.data = fons__renderJob(&job, &worker->scratch);
+
+		fons__lock(stash);
+		stash->jobs[seq - stash->jobBase].data = job.data;
+		stash->jobs[seq - stash->jobBase].done = 1;
+		fons__wakeAll(&stash->finish);
+	}
+	fons__unlock(stash);
+
+	return 0;
+}
+
+static int fons__queueJob(struct FONScontext* stash, struct FONSfont* font, int glyph, float scale, int pad, int blur,
+						  int page, int x, int y, int w, int h)
+{
+	struct FONSjob* job;
+	if (stash->nworkers == 0) return 0;
+
+	fons__lock(stash);
+	if (stash->njobs+1 > stash->cjobs) {
+		int cjobs = stash->cjobs == 0 ? 64 : stash->cjobs*2;
+		struct FONSjob* jobs = (struct FONSjob*)realloc(stash->jobs, sizeof(struct FONSjob) * cjobs);
+		if (jobs == NULL) {
+			fons__unlock(stash);
+			return 0;
+		}
+		stash->jobs = jobs;
+		stash->cjobs = cjobs;
+	}
+	job = &stash->jobs[stash->njobs++];
+	memset(job, 0, sizeof(*job));
+	job->font = font;
+	job->glyph = glyph;
+	job->scale = scale;
+	job->pad = pad;
+	job->blur = blur;
+	job->page = page;
+	job->x = x;
+	job->y = y;
+	job->w = w;
+	job->h = h;
+	job->epoch = stash->pages[page].epoch;
+	// Busy workers pick up the job without waking anyone.
+	if (stash->nextJob == stash->njobs-1 && stash->nidle > 0)
+		fons__wakeOne(&stash->start);
+	fons__unlock(stash);
+
+	return 1;
+}
+
+static int fons__jobsDone(struct FONScontext* stash)
+{
+	int i;
+	for (i = 0; i < stash->njobs; i++) {
+		if (!stash->jobs[i].done)
+			return 0;
+	}
+	return 1;
+}
+
+// Copies finished glyphs into the atlas in queue order, optionally waits for all of them.
+static void fons__collectJobs(struct FONScontext* stash, int wait)
+{
+	int i, y;
+	if (stash->nworkers == 0) return;
+
+	fons__lock(stash);
+	if (wait) {
+		while (!fons__jobsDone(stash))
+			fons__wait(stash, &stash->finish);
+	}
+	for (i = 0; i < stash->njobs && stash->jobs[i].done; i++) {
+		struct FONSjob* job = &stash->jobs[i];
+		struct FONSpage* page = &stash->pages[job->page];
+		// The page may have been cleared since.
+		if (job->page < stash->npages && page->epoch == job->epoch) {
+			if (job->data != NULL) {
+				for (y = 0; y < job->h; y++)
+					memcpy(&page->texData[job->x + (job->y+y) * stash->params.width], &job->data[y*job->w], job->w);
+				fons__markDirty(page, job->x, job->y, job->x+job->w, job->y+job->h);
+			} else {
+				// The worker could not allocate the result, render here instead of leaving a hole.
+				fons__rasterizeGlyph(stash, job->font, job->glyph, job->scale, job->pad, job->blur,
+									 page, job->x, job->y, job->w, job->h);
+			}
+		}
+		free(job->data);
+	}
+	if (i > 0) {
+		memmove(stash->jobs, &stash->jobs[i], sizeof(struct FONSjob) * (stash->njobs - i));
+		stash->njobs -= i;
+		stash->nextJob -= i;
+		stash->jobBase += i;
+	}
+	fons__unlock(stash);
+}
+
+static void fons__stopWorkers(struct FONScontext* stash)
+{
+	int i;
+	if (stash->nworkers > 0) {
+		fons__lock(stash);
+		stash->quit = 1;
+		fons__wakeAll(&stash->start);
+		fons__unlock(stash);
+		for (i = 0; i < stash->nworkers; i++) {
+#ifdef _WIN32
+			WaitForSingleObject(stash->workers[i].thread, INFINITE);
+			CloseHandle(stash->workers[i].thread);
+#else
+			pthread_join(stash->workers[i].thread, NULL);
+#endif
+		}
+#ifdef _WIN32
+		DeleteCriticalSection(&stash->lock);
+#else
+		pthread_mutex_destroy(&stash->lock);
+		pthread_cond_destroy(&stash->start);
+		pthread_cond_destroy(&stash->finish);
+#endif
+		stash->nworkers = 0;
+	}
+	for (i = 0; i < stash->njobs; i++)
+		free(stash->jobs[i].data);
+	free(stash->jobs);
+	free(stash->workers);
+}
+
+#else
+
+static int fons__queueJob(struct FONScontext* stash, struct FONSfont* font, int glyph, float scale, int pad, int blur,
+						  int page, int x, int y, int w, int h)
+{
+	FONS_NOTUSED(stash); FONS_NOTUSED(font); FONS_NOTUSED(glyph); FONS_NOTUSED(scale);
+	FONS_NOTUSED(pad); FONS_NOTUSED(blur); FONS_NOTUSED(page);
+	FONS_NOTUSED(x); FONS_NOTUSED(y); FONS_NOTUSED(w); FONS_NOTUSED(h);
+	return 0;
+}
+
+static void fons__collectJobs(struct FONScontext* stash, int wait)
+{
+	FONS_NOTUSED(stash);
+	FONS_NOTUSED(wait);
+}
+
+static void fons__stopWorkers(struct FONScontext* stash)
+{
+	FONS_NOTUSED(stash);
+}
+
+#endif
+
+static struct FONSglyph* fons__findGlyph(struct FONSfont* font, unsigned int h, unsigned int codepoint, short isize, short iblur)
+{
+	int i = font->lut[h];
+	while (i != -1) {
+		if (font->glyphs[i].codepoint == codepoint && font->glyphs[i].size == isize && font->glyphs[i].blur == iblur)
+			return &font->glyphs[i];
+		i = font->glyphs[i].next;
+	}
+	return NULL;
+}
+
 static struct FONSglyph* fons__getGlyph(struct FONScontext* stash, struct FONSfont* font, unsigned int codepoint,
-										short isize, short iblur)
+										short isize, short iblur, int bitmapOption)
 {
-	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, x, y;
+	int g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, pageIdx = -1;
 	float scale;
 	struct FONSglyph* glyph = NULL;
+	struct FONSpage* page = NULL;
 	unsigned int h;
 	float size = isize/10.0f;
-	int pad, added;
-	unsigned char* bdst;
-	unsigned char* dst;
+	int pad, gen;
 
 	if (isize < 2) return NULL;
 	if (iblur > 20) iblur = 20;
 	pad = iblur+2;
 
 	// Reset allocator.
-	stash->nscratch = 0;
+	stash->scratch.n = 0;
 
 	// Find code point and size.
 	h = fons__hashint(codepoint) & (FONS_HASH_LUT_SIZE-1);
-	i = font->lut[h];
-	while (i != -1) {
-		if (font->glyphs[i].codepoint == codepoint && font->glyphs[i].size == isize && font->glyphs[i].blur == iblur)
-			return &font->glyphs[i];
-		i = font->glyphs[i].next;
+	glyph = fons__findGlyph(font, h, codepoint, isize, iblur);
+	if (glyph != NULL) {
+		if (glyph->page != -1 && glyph->lastUsed != stash->frame)
+			stash->pages[glyph->page].nused++;
+		glyph->lastUsed = stash->frame;
+		if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL)
+			return glyph;
+		if (glyph->page != -1) {
+			stash->pages[glyph->page].lastUsed = stash->frame;
+			return glyph;
+		}
+		// Glyph has been measured, but not rasterized yet.
 	}
 
 	// Could not find glyph, create it.
@@ -1017,21 +1623,45 @@ static struct FONSglyph* fons__getGlyph(struct FONScontext* stash, struct FONSfo
 	gw = x1-x0 + pad*2;
 	gh = y1-y0 + pad*2;
 
-	// Find free spot for the rect in the atlas
-	added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
-	if (added == 0 && stash->handleError != NULL) {
-		// Atlas is full, let the user to resize the atlas (or not), and try again.
-		stash->handleError(stash->errorUptr, FONS_ATLAS_FULL, 0);
-		added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
+	if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL) {
+		gx = -1;
+		gy = -1;
+	} else {
+		// Find free spot for the rect in the atlas
+		gen = stash->atlasGeneration;
+		pageIdx = fons__allocGlyphRect(stash, gw, gh, &gx, &gy);
+		if (pageIdx == -1 && stash->handleError != NULL) {
+			// Atlas is full, let the user to resize the atlas (or not), and try again.
+			stash->handleError(stash->errorUptr, FONS_ATLAS_FULL, 0);
+			pageIdx = fons__allocGlyphRect(stash, gw, gh, &gx, &gy);
+		}
+		if (pageIdx == -1) return NULL;
+		// Evicting or resetting the atlas rebuilt the glyph cache. A measured glyph
+		// used in this frame survives eviction, but may have moved.
+		if (glyph != NULL && stash->atlasGeneration != gen)
+			glyph = fons__findGlyph(font, h, codepoint, isize, iblur);
+		page = &stash->pages[pageIdx];
+		page->lastUsed = stash->frame;
+		page->nused++;
 	}
-	if (added == 0) return NULL;
 
 	// Init glyph.
-	glyph = fons__allocGlyph(font);
-	glyph->codepoint = codepoint;
-	glyph->size = isize;
-	glyph->blur = iblur;
+	if (glyph == NULL) {
+		glyph = fons__allocGlyph(font);
+		glyph->codepoint = codepoint;
+		glyph->size = isize;
+		glyph->blur = iblur;
+		// Insert char to hash lookup.
+		glyph->next = font->lut[h];
+		font->lut[h] = font->nglyphs-1;
+		if (pageIdx == -1)
+			font->nmeasured++;
+	} else if (glyph->page == -1 && pageIdx != -1) {
+		font->nmeasured--;
+	}
 	glyph->index = g;
+	glyph->page = pageIdx;
+	glyph->lastUsed = stash->frame;
 	glyph->x0 = (short)gx;
 	glyph->y0 = (short)gy;
 	glyph->x1 = (short)(glyph->x0+gw);
@@ -1039,60 +1669,27 @@ static struct FONSglyph* fons__getGlyph(struct FONScontext* stash, struct FONSfo
 	glyph->xadv = (short)(scale * advance * 10.0f);
 	glyph->xoff = (short)(x0 - pad);
 	glyph->yoff = (short)(y0 - pad);
-	glyph->next = 0;
-
-	// Insert char to hash lookup.
-	glyph->next = font->lut[h];
-	font->lut[h] = font->nglyphs-1;
-
-	// Rasterize
-	dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
-	fons__tt_renderGlyphBitmap(&font->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale,scale, g);
 
-	// Make sure there is one pixel empty border.
-	dst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-	for (y = 0; y < gh; y++) {
-		dst[y*stash->params.width] = 0;
-		dst[gw-1 + y*stash->params.width] = 0;
-	}
-	for (x = 0; x < gw; x++) {
-		dst[x] = 0;
-		dst[x + (gh-1)*stash->params.width] = 0;
-	}
+	if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL)
+		return glyph;
 
-	// Debug code to color the glyph background
-/*	unsigned char* fdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-	for (y = 0; y < gh; y++) {
-		for (x = 0; x < gw; x++) {
-			int a = (int)fdst[x+y*stash->params.width] + 20;
-			if (a > 255) a = 255;
-			fdst[x+y*stash->params.width] = a;
-		}
-	}*/
+	// Let the workers rasterize the glyph, until it is copied to the atlas the quad is empty.
+	if (fons__queueJob(stash, font, g, scale, pad, iblur, pageIdx, glyph->x0, glyph->y0, gw, gh))
+		return glyph;
 
-	// Blur
-	if (iblur > 0) {
-		stash->nscratch = 0;
-		bdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-		fons__blur(stash, bdst, gw,gh, stash->params.width, iblur);
-	}
-
-	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], glyph->x0);
-	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], glyph->y0);
-	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], glyph->x1);
-	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], glyph->y1);
+	fons__rasterizeGlyph(stash, font, g, scale, pad, iblur, page, glyph->x0, glyph->y0, gw, gh);
 
 	return glyph;
 }
 
 static void fons__getQuad(struct FONScontext* stash, struct FONSfont* font,
-						   struct FONSglyph* prevGlyph, struct FONSglyph* glyph,
+						   int prevGlyphIndex, struct FONSglyph* glyph,
 						   float scale, float spacing, float* x, float* y, struct FONSquad* q)
 {
 	float rx,ry,xoff,yoff,x0,y0,x1,y1;
 
-	if (prevGlyph) {
-		float adv = fons__tt_getGlyphKernAdvance(&font->font, prevGlyph->index, glyph->index) * scale;
+	if (prevGlyphIndex != -1) {
+		float adv = fons__tt_getGlyphKernAdvance(&font->font, prevGlyphIndex, glyph->index) * scale;
 		*x += (int)(adv + spacing + 0.5f);
 	}
 
@@ -1139,15 +1736,15 @@ static void fons__getQuad(struct FONScontext* stash, struct FONSfont* font,
 
 static void fons__flush(struct FONScontext* stash)
 {
-	// Flush texture
-	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
-		if (stash->params.renderUpdate != NULL)
-			stash->params.renderUpdate(stash->params.userPtr, stash->dirtyRect, stash->texData);
-		// Reset dirty rect
-		stash->dirtyRect[0] = stash->params.width;
-		stash->dirtyRect[1] = stash->params.height;
-		stash->dirtyRect[2] = 0;
-		stash->dirtyRect[3] = 0;
+	struct FONSpage* page = &stash->pages[0];
+
+	// Flush texture, the render callbacks are used with single page only.
+	// Without them the dirty rect is kept for fonsValidateTexture().
+	if (page->dirtyRect[0] < page->dirtyRect[2] && page->dirtyRect[1] < page->dirtyRect[3]) {
+		if (stash->params.renderUpdate != NULL) {
+			stash->params.renderUpdate(stash->params.userPtr, page->dirtyRect, page->texData);
+			fons__resetDirty(stash, page);
+		}
 	}
 
 	// Flush triangles
@@ -1202,8 +1799,8 @@ float fonsDrawText(struct FONScontext* stash,
 	unsigned int codepoint;
 	unsigned int utf8state = 0;
 	struct FONSglyph* glyph = NULL;
-	struct FONSglyph* prevGlyph = NULL;
 	struct FONSquad q;
+	int prevGlyphIndex = -1;
 	short isize = (short)(state->size*10.0f);
 	short iblur = (short)state->blur;
 	float scale;
@@ -1236,9 +1833,9 @@ float fonsDrawText(struct FONScontext* stash,
 	for (; str != end; ++str) {
 		if (fons__decutf8(&utf8state, &codepoint, *(const unsigned char*)str))
 			continue;
-		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur);
+		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, FONS_GLYPH_BITMAP_REQUIRED);
 		if (glyph) {
-			fons__getQuad(stash, font, prevGlyph, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
 
 			if (stash->nverts+6 > FONS_VERTEX_COUNT)
 				fons__flush(stash);
@@ -1251,7 +1848,7 @@ float fonsDrawText(struct FONScontext* stash,
 			fons__vertex(stash, q.x0, q.y1, q.s0, q.t1, state->color);
 			fons__vertex(stash, q.x1, q.y1, q.s1, q.t1, state->color);
 		}
-		prevGlyph = glyph;
+		prevGlyphIndex = glyph != NULL ? glyph->index : -1;
 	}
 	fons__flush(stash);
 
@@ -1259,7 +1856,7 @@ float fonsDrawText(struct FONScontext* stash,
 }
 
 int fonsTextIterInit(struct FONScontext* stash, struct FONStextIter* iter,
-					 float x, float y, const char* str, const char* end)
+					 float x, float y, const char* str, const char* end, int bitmapOption)
 {
 	struct FONSstate* state = fons__getState(stash);
 	float width;
@@ -1294,6 +1891,8 @@ int fonsTextIterInit(struct FONScontext* stash, struct FONStextIter* iter,
 	iter->x = iter->nextx = x;
 	iter->y = iter->nexty = y;
 	iter->spacing = state->spacing;
+	iter->bitmapOption = bitmapOption;
+	iter->prevGlyphIndex = -1;
 	iter->str = str;
 	iter->next = str;
 	iter->end = end;
@@ -1318,10 +1917,11 @@ int fonsTextIterNext(struct FONScontext* stash, struct FONStextIter* iter, struc
 		// Get glyph and quad
 		iter->x = iter->nextx;
 		iter->y = iter->nexty;
-		glyph = fons__getGlyph(stash, iter->font, iter->codepoint, iter->isize, iter->iblur);
+		glyph = fons__getGlyph(stash, iter->font, iter->codepoint, iter->isize, iter->iblur, iter->bitmapOption);
 		if (glyph != NULL)
-			fons__getQuad(stash, iter->font, iter->prevGlyph, glyph, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
-		iter->prevGlyph = glyph;
+			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
+		iter->prevGlyphIndex = glyph != NULL ? glyph->index : -1;
+		iter->page = glyph != NULL ? glyph->page : -1;
 		break;
 	}
 	iter->next = str;
@@ -1359,8 +1959,8 @@ void fonsDrawDebug(struct FONScontext* stash, float x, float y)
 	fons__vertex(stash, x+w, y+h, 1, 1, 0xffffffff);
 
 	// Drawbug draw atlas
-	for (i = 0; i < stash->atlas->nnodes; i++) {
-		struct FONSatlasNode* n = &stash->atlas->nodes[i];
+	for (i = 0; i < stash->pages[0].atlas->nnodes; i++) {
+		struct FONSatlasNode* n = &stash->pages[0].atlas->nodes[i];
 
 		if (stash->nverts+6 > FONS_VERTEX_COUNT)
 			fons__flush(stash);
@@ -1387,7 +1987,7 @@ float fonsTextBounds(struct FONScontext* stash,
 	unsigned int utf8state = 0;
 	struct FONSquad q;
 	struct FONSglyph* glyph = NULL;
-	struct FONSglyph* prevGlyph = NULL;
+	int prevGlyphIndex = -1;
 	short isize = (short)(state->size*10.0f);
 	short iblur = (short)state->blur;
 	float scale;
@@ -1415,9 +2015,10 @@ float fonsTextBounds(struct FONScontext* stash,
 	for (; str != end; ++str) {
 		if (fons__decutf8(&utf8state, &codepoint, *(const unsigned char*)str))
 			continue;
-		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur);
+		// Only the metrics are needed, glyphs are rasterized when they get drawn.
+		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, FONS_GLYPH_BITMAP_OPTIONAL);
 		if (glyph) {
-			fons__getQuad(stash, font, prevGlyph, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
 			if (q.x0 < minx) minx = q.x0;
 			if (q.x1 > maxx) maxx = q.x1;
 			if (stash->params.flags & FONS_ZERO_TOPLEFT) {
@@ -1428,7 +2029,7 @@ float fonsTextBounds(struct FONScontext* stash,
 				if (q.y0 > maxy) maxy = q.y0;
 			}
 		}
-		prevGlyph = glyph;
+		prevGlyphIndex = glyph != NULL ? glyph->index : -1;
 	}
 
 	advance = x - startx;
@@ -1499,31 +2100,145 @@ void fonsLineBounds(struct FONScontext* stash, float y, float* miny, float* maxy
 }
 
 const unsigned char* fonsGetTextureData(struct FONScontext* stash, int* width, int* height)
+{
+	return fonsGetPageTextureData(stash, 0, width, height);
+}
+
+int fonsValidateTexture(struct FONScontext* stash, int* dirty)
+{
+	return fonsValidatePageTexture(stash, 0, dirty);
+}
+
+int fonsGetPageCount(struct FONScontext* stash)
+{
+	return stash->npages;
+}
+
+const unsigned char* fonsGetPageTextureData(struct FONScontext* stash, int page, int* width, int* height)
 {
 	if (width != NULL)
 		*width = stash->params.width;
 	if (height != NULL)
 		*height = stash->params.height;
-	return stash->texData;
+	if (page < 0 || page >= stash->npages) return NULL;
+	return stash->pages[page].texData;
 }
 
-int fonsValidateTexture(struct FONScontext* stash, int* dirty)
+int fonsValidatePageTexture(struct FONScontext* stash, int page, int* dirty)
 {
-	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
-		dirty[0] = stash->dirtyRect[0];
-		dirty[1] = stash->dirtyRect[1];
-		dirty[2] = stash->dirtyRect[2];
-		dirty[3] = stash->dirtyRect[3];
-		// Reset dirty rect
-		stash->dirtyRect[0] = stash->params.width;
-		stash->dirtyRect[1] = stash->params.height;
-		stash->dirtyRect[2] = 0;
-		stash->dirtyRect[3] = 0;
+	struct FONSpage* p;
+	if (page < 0 || page >= stash->npages) return 0;
+	p = &stash->pages[page];
+	if (p->dirtyRect[0] < p->dirtyRect[2] && p->dirtyRect[1] < p->dirtyRect[3]) {
+		dirty[0] = p->dirtyRect[0];
+		dirty[1] = p->dirtyRect[1];
+		dirty[2] = p->dirtyRect[2];
+		dirty[3] = p->dirtyRect[3];
+		fons__resetDirty(stash, p);
 		return 1;
 	}
 	return 0;
 }
 
+void fonsBeginFrame(struct FONScontext* stash)
+{
+	int i, victim = 0;
+
+	stash->frame++;
+
+	// Pick up the glyphs rasterized in the background.
+	fons__collectJobs(stash, 0);
+
+	// When the glyphs used in a frame got spread over all pages, none of the pages
+	// can be evicted during the frame. Clear the least used page between frames
+	// so that the used glyphs get packed together again.
+	if (stash->atlasFull) {
+		for (i = 1; i < stash->npages; i++) {
+			if (stash->pages[i].nused < stash->pages[victim].nused)
+				victim = i;
+		}
+		fons__evictPage(stash, victim);
+		stash->atlasFull = 0;
+	}
+
+	for (i = 0; i < stash->npages; i++)
+		stash->pages[i].nused = 0;
+
+	// Text which is only measured never reaches the atlas, and so is not pruned by the
+	// evictions. Keep the glyphs measured in the last frame, when there are too many.
+	for (i = 0; i < stash->nfonts; i++) {
+		if (stash->fonts[i]->nmeasured > FONS_MAX_MEASURED_GLYPHS) {
+			fons__pruneGlyphs(stash, -1, stash->frame-1);
+			break;
+		}
+	}
+}
+
+int fonsStartWorkers(struct FONScontext* stash, int threads)
+{
+#ifdef FONS_NO_THREADS
+	FONS_NOTUSED(stash);
+	FONS_NOTUSED(threads);
+	return 0;
+#else
+	int i;
+	if (stash == NULL) return 0;
+	if (stash->nworkers > 0) return stash->nworkers;
+
+	threads = fons__mini(threads, FONS_MAX_WORKERS);
+	if (threads <= 0) return 0;
+	stash->workers = (struct FONSworker*)malloc(sizeof(struct FONSworker) * threads);
+	if (stash->workers == NULL) return 0;
+	memset(stash->workers, 0, sizeof(struct FONSworker) * threads);
+
+#ifdef _WIN32
+	InitializeCriticalSection(&stash->lock);
+	InitializeConditionVariable(&stash->start);
+	InitializeConditionVariable(&stash->finish);
+#else
+	pthread_mutex_init(&stash->lock, NULL);
+	pthread_cond_init(&stash->start, NULL);
+	pthread_cond_init(&stash->finish, NULL);
+#endif
+	for (i = 0; i < threads; i++) {
+		stash->workers[i].stash = stash;
+#ifdef _WIN32
+		stash->workers[i].thread = CreateThread(NULL, 0, fons__workerThread, &stash->workers[i], 0, NULL);
+		if (stash->workers[i].thread == NULL) break;
+#else
+		if (pthread_create(&stash->workers[i].thread, NULL, fons__workerThread, &stash->workers[i]) != 0) break;
+#endif
+	}
+	// Run with the threads we got.
+	stash->nworkers = i;
+	if (stash->nworkers == 0) {
+#ifdef _WIN32
+		DeleteCriticalSection(&stash->lock);
+#else
+		pthread_mutex_destroy(&stash->lock);
+		pthread_cond_destroy(&stash->start);
+		pthread_cond_destroy(&stash->finish);
+#endif
+		free(stash->workers);
+		stash->workers = NULL;
+	}
+	return stash->nworkers;
+#endif
+}
+
+void fonsWaitGlyphs(struct FONScontext* stash)
+{
+	if (stash == NULL) return;
+	fons__collectJobs(stash, 1);
+}
+
+void fonsTouchPage(struct FONScontext* stash, int page)
+{
+	if (page < 0 || page >= stash->npages) return;
+	stash->pages[page].lastUsed = stash->frame;
+	stash->pages[page].nused++;
+}
+
 void fonsDeleteInternal(struct FONScontext* stash)
 {
 	int i;
@@ -1532,12 +2247,15 @@ void fonsDeleteInternal(struct FONScontext* stash)
 	if (stash->params.renderDelete)
 		stash->params.renderDelete(stash->params.userPtr);
 
+	// Workers refer to the fonts.
+	fons__stopWorkers(stash);
+
 	for (i = 0; i < stash->nfonts; ++i)
 		fons__freeFont(stash->fonts[i]);
 
-	if (stash->atlas) fons__deleteAtlas(stash->atlas);
+	for (i = 0; i < stash->npages; i++)
+		fons__freePage(&stash->pages[i]);
 	if (stash->fonts) free(stash->fonts);
-	if (stash->texData) free(stash->texData);
 	free(stash);
 }
 
@@ -1557,7 +2275,7 @@ void fonsGetAtlasSize(struct FONScontext* stash, int* width, int* height)
 
 int fonsExpandAtlas(struct FONScontext* stash, int width, int height)
 {
-	int i, maxy = 0;
+	int i, j, maxy;
 	unsigned char* data = NULL;
 	if (stash == NULL) return 0;
 
@@ -1575,38 +2293,44 @@ int fonsExpandAtlas(struct FONScontext* stash, int width, int height)
 		if (stash->params.renderResize(stash->params.userPtr, width, height) == 0)
 			return 0;
 	}
-	// Copy old texture data over.
-	data = (unsigned char*)malloc(width * height);
-	if (data == NULL)
-		return 0;
-	for (i = 0; i < stash->params.height; i++) {
-		unsigned char* dst = &data[i*width];
-		unsigned char* src = &stash->texData[i*stash->params.width];
-		memcpy(dst, src, stash->params.width);
-		if (width > stash->params.width)
-			memset(dst+stash->params.width, 0, width - stash->params.width);
-	}
-	if (height > stash->params.height)
-		memset(&data[stash->params.height * width], 0, (height - stash->params.height) * width);
+	for (j = 0; j < stash->npages; j++) {
+		struct FONSpage* page = &stash->pages[j];
 
-	free(stash->texData);
-	stash->texData = data;
-
-	// Increase atlas size
-	fons__atlasExpand(stash->atlas, width, height);
-
-	// Add axisting data as dirty.
-	for (i = 0; i < stash->atlas->nnodes; i++)
-		maxy = fons__maxi(maxy, stash->atlas->nodes[i].y);
-	stash->dirtyRect[0] = 0;
-	stash->dirtyRect[1] = 0;
-	stash->dirtyRect[2] = stash->params.width;
-	stash->dirtyRect[3] = maxy;
+		// Copy old texture data over.
+		data = (unsigned char*)malloc(width * height);
+		if (data == NULL)
+			return 0;
+		for (i = 0; i < stash->params.height; i++) {
+			unsigned char* dst = &data[i*width];
+			unsigned char* src = &page->texData[i*stash->params.width];
+			memcpy(dst, src, stash->params.width);
+			if (width > stash->params.width)
+				memset(dst+stash->params.width, 0, width - stash->params.width);
+		}
+		if (height > stash->params.height)
+			memset(&data[stash->params.height * width], 0, (height - stash->params.height) * width);
+
+		free(page->texData);
+		page->texData = data;
+
+		// Increase atlas size
+		fons__atlasExpand(page->atlas, width, height);
+
+		// Add axisting data as dirty.
+		maxy = 0;
+		for (i = 0; i < page->atlas->nnodes; i++)
+			maxy = fons__maxi(maxy, page->atlas->nodes[i].y);
+		page->dirtyRect[0] = 0;
+		page->dirtyRect[1] = 0;
+		page->dirtyRect[2] = stash->params.width;
+		page->dirtyRect[3] = maxy;
+	}
 
 	stash->params.width = width;
 	stash->params.height = height;
 	stash->itw = 1.0f/stash->params.width;
 	stash->ith = 1.0f/stash->params.height;
+	stash->atlasGeneration++;
 
 	return 1;
 }
@@ -1625,24 +2349,24 @@ int fonsResetAtlas(struct FONScontext* stash, int width, int height)
 			return 0;
 	}
 
+	// Drop extra pages, they are added back on demand.
+	for (i = 1; i < stash->npages; i++)
+		fons__freePage(&stash->pages[i]);
+	stash->npages = 1;
+
 	// Reset atlas
-	fons__atlasReset(stash->atlas, width, height);
+	fons__atlasReset(stash->pages[0].atlas, width, height);
 
 	// Clear texture data.
-	stash->texData = (unsigned char*)realloc(stash->texData, width * height);
-	if (stash->texData == NULL) return 0;
-	memset(stash->texData, 0, width * height);
-
-	// Reset dirty rect
-	stash->dirtyRect[0] = width;
-	stash->dirtyRect[1] = height;
-	stash->dirtyRect[2] = 0;
-	stash->dirtyRect[3] = 0;
+	stash->pages[0].texData = (unsigned char*)realloc(stash->pages[0].texData, width * height);
+	if (stash->pages[0].texData == NULL) return 0;
+	memset(stash->pages[0].texData, 0, width * height);
 
 	// Reset cached glyphs
 	for (i = 0; i < stash->nfonts; i++) {
 		struct FONSfont* font = stash->fonts[i];
 		font->nglyphs = 0;
+		font->nmeasured = 0;
 		for (j = 0; j < FONS_HASH_LUT_SIZE; j++)
 			font->lut[j] = -1;
 	}
@@ -1651,6 +2375,9 @@ int fonsResetAtlas(struct FONScontext* stash, int width, int height)
 	stash->params.height = height;
 	stash->itw = 1.0f/stash->params.width;
 	stash->ith = 1.0f/stash->params.height;
+	stash->atlasGeneration++;
+	stash->pages[0].epoch = ++stash->pageEpoch;
+	fons__resetDirty(stash, &stash->pages[0]);
 
 	// Add white rect at 0,0 for debug drawing.
 	fons__addWhiteRect(stash, 2,2);
@@ -1658,5 +2385,10 @@ int fonsResetAtlas(struct FONScontext* stash, int width, int height)
 	return 1;
 }
 
+int fonsGetAtlasGeneration(struct FONScontext* stash)
+{
+	return stash->atlasGeneration;
+}
+
 
 #endif
@@ -27,11 +27,73 @@
 
 #define NVG_INIT_PATH_SIZE 256
 #define NVG_MAX_STATES 32
+#define NVG_TEXT_CACHE_SETS 256
+#define NVG_TEXT_CACHE_WAYS 4
+
+#define NVG_BEZIER_TOL 0.25f		// Max distance between a bezier and its flattened segments, in tessTol units.
+#define NVG_BEZIER_MAX_SEGS 1024	// Same as the old subdivision depth limit of 10.
 
 #define NVG_KAPPA90 0.5522847493f	// Lenght proportional to radius of a cubic bezier handle for 90deg arcs.
 
 #define NVG_COUNTOF(arr) (sizeof(arr) / sizeof(0[arr]))
 
+// SIMD kernels for point transform, segment directions and joins.
+// The vector code does the same float operations in the same order as the scalar code,
+// so the results are bit-exact. Define NVG_NO_SIMD to use only the scalar code.
+// Note: compilers which contract scalar a*b+c into fused multiply-add (e.g. GCC on AArch64)
+// need -ffp-contract=off for the scalar and vector results to match exactly.
+#if !defined(NVG_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define NVG_SIMD 1
+typedef __m128 NVGv4;
+#define nvg__v4load(p) _mm_loadu_ps(p)
+#define nvg__v4store(p,v) _mm_storeu_ps(p,v)
+#define nvg__v4set(a,b,c,d) _mm_set_ps(d,c,b,a)
+#define nvg__v4set1(a) _mm_set1_ps(a)
+#define nvg__v4add(a,b) _mm_add_ps(a,b)
+#define nvg__v4sub(a,b) _mm_sub_ps(a,b)
+#define nvg__v4mul(a,b) _mm_mul_ps(a,b)
+#define nvg__v4div(a,b) _mm_div_ps(a,b)
+#define nvg__v4sqrt(a) _mm_sqrt_ps(a)
+#define nvg__v4neg(a) _mm_xor_ps(a, _mm_set1_ps(-0.0f))
+#define nvg__v4min(a,b) _mm_min_ps(a,b)	// a < b ? a : b
+#define nvg__v4max(a,b) _mm_max_ps(a,b)	// a > b ? a : b
+#define nvg__v4gt(a,b) _mm_cmpgt_ps(a,b)
+#define nvg__v4lt(a,b) _mm_cmplt_ps(a,b)
+#define nvg__v4sel(m,a,b) _mm_or_ps(_mm_and_ps(m,a), _mm_andnot_ps(m,b))
+#define nvg__v4mask(m) _mm_movemask_ps(m)
+#define nvg__v4dupEven(a) _mm_shuffle_ps(a,a,_MM_SHUFFLE(2,2,0,0))
+#define nvg__v4dupOdd(a) _mm_shuffle_ps(a,a,_MM_SHUFFLE(3,3,1,1))
+static void nvg__v4get(NVGv4 v, float* dst) { _mm_storeu_ps(dst, v); }
+#elif !defined(NVG_NO_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NVG_SIMD 1
+typedef float32x4_t NVGv4;
+static NVGv4 nvg__v4set(float a, float b, float c, float d) { float v[4]; v[0] = a; v[1] = b; v[2] = c; v[3] = d; return vld1q_f32(v); }
+static int nvg__v4mask(NVGv4 m)
+{
+	uint32x4_t u = vshrq_n_u32(vreinterpretq_u32_f32(m), 31);
+	return (int)(vgetq_lane_u32(u,0) | (vgetq_lane_u32(u,1) << 1) | (vgetq_lane_u32(u,2) << 2) | (vgetq_lane_u32(u,3) << 3));
+}
+#define nvg__v4load(p) vld1q_f32(p)
+#define nvg__v4store(p,v) vst1q_f32(p,v)
+#define nvg__v4set1(a) vdupq_n_f32(a)
+#define nvg__v4add(a,b) vaddq_f32(a,b)
+#define nvg__v4sub(a,b) vsubq_f32(a,b)
+#define nvg__v4mul(a,b) vmulq_f32(a,b)
+#define nvg__v4div(a,b) vdivq_f32(a,b)
+#define nvg__v4sqrt(a) vsqrtq_f32(a)
+#define nvg__v4neg(a) vnegq_f32(a)
+#define nvg__v4min(a,b) vbslq_f32(vcltq_f32(a,b), a, b)
+#define nvg__v4max(a,b) vbslq_f32(vcgtq_f32(a,b), a, b)
+#define nvg__v4gt(a,b) vreinterpretq_f32_u32(vcgtq_f32(a,b))
+#define nvg__v4lt(a,b) vreinterpretq_f32_u32(vcltq_f32(a,b))
+#define nvg__v4sel(m,a,b) vbslq_f32(vreinterpretq_u32_f32(m), a, b)
+#define nvg__v4dupEven(a) vtrn1q_f32(a,a)
+#define nvg__v4dupOdd(a) vtrn2q_f32(a,a)
+static void nvg__v4get(NVGv4 v, float* dst) { vst1q_f32(dst, v); }
+#endif
+
 
 enum NVGcommands {
 	NVG_MOVETO = 0,
@@ -93,6 +155,67 @@ struct NVGpathCache {
 	float bounds[4];
 };
 
+// Expanded vertices of a cached path, valid as long as the expansion parameters match.
+struct NVGcachedExpand {
+	int valid;
+	float w;
+	int lineCap;
+	int lineJoin;
+	float miterLimit;
+	struct NVGpath* paths;
+	struct NVGvertex* verts;
+	int nverts;
+	int cverts;
+};
+
+struct NVGcachedPath {
+	// Commands as captured, already transformed by xform.
+	float* commands;
+	int ncommands;
+	float xform[6];
+	// Flattened points, valid as long as the transform and tessellation tolerance match.
+	int flatValid;
+	float flatXform[6];
+	float flatTessTol;
+	struct NVGpoint* points;
+	int npoints;
+	struct NVGpath* paths;
+	int npaths;
+	float bounds[4];
+	struct NVGcachedExpand fill;
+	struct NVGcachedExpand stroke;
+};
+
+// Glyph quad of a cached text run, in font pixels relative to the aligned start of the run.
+struct NVGtextGlyph {
+	float x, y, w, h;
+	float s0, t0, s1, t1;
+	int page;				// Atlas page of the glyph.
+};
+
+struct NVGtextRun {
+	unsigned int hash;
+	char* str;
+	int nstr;
+	int cstr;
+	int font;
+	int align;
+	float size, spacing, blur;
+	float alignx, aligny;	// Offset of the run start caused by alignment.
+	float lastx;			// Pen position of the last glyph relative to the run start.
+	struct NVGtextGlyph* glyphs;
+	int nglyphs;
+	int cglyphs;
+	unsigned int pages;		// Mask of atlas pages used by the glyphs.
+	unsigned int used;		// Frame stamp of last use, 0 if the slot is empty.
+};
+
+struct NVGtextCache {
+	struct NVGtextRun runs[NVG_TEXT_CACHE_SETS*NVG_TEXT_CACHE_WAYS];
+	int atlasGeneration;
+	unsigned int stamp;
+};
+
 struct NVGcontext {
 	struct NVGparams params;
 	float* commands;
@@ -102,17 +225,20 @@ struct NVGcontext {
 	struct NVGstate states[NVG_MAX_STATES];
 	int nstates;
 	struct NVGpathCache* cache;
+	struct NVGtextCache* textCache;
 	float tessTol;
 	float distTol;
 	float fringeWidth;
 	float devicePxRatio;
 	struct FONScontext* fs;
-	int fontImage;
+	int fontImages[FONS_MAX_PAGES];
 	int alphaBlend;
 	int drawCallCount;
 	int fillTriCount;
 	int strokeTriCount;
 	int textTriCount;
+	int atlasUploadCount;
+	int atlasUploadBytes;
 };
 
 static float nvg__sqrtf(float a) { return sqrtf(a); }
@@ -180,6 +306,26 @@ error:
 	return NULL;
 }
 
+static void nvg__deleteTextCache(struct NVGtextCache* c)
+{
+	int i;
+	if (c == NULL) return;
+	for (i = 0; i < NVG_TEXT_CACHE_SETS*NVG_TEXT_CACHE_WAYS; i++) {
+		if (c->runs[i].str != NULL) free(c->runs[i].str);
+		if (c->runs[i].glyphs != NULL) free(c->runs[i].glyphs);
+	}
+	free(c);
+}
+
+static struct NVGtextCache* nvg__allocTextCache()
+{
+	struct NVGtextCache* c = (struct NVGtextCache*)malloc(sizeof(struct NVGtextCache));
+	if (c == NULL) return NULL;
+	memset(c, 0, sizeof(struct NVGtextCache));
+	c->stamp = 1;
+	return c;
+}
+
 static void nvg__setDevicePixelRatio(struct NVGcontext* ctx, float ratio)
 {
 	ctx->tessTol = 1.0f / ratio;
@@ -207,6 +353,9 @@ struct NVGcontext* nvgCreateInternal(struct NVGparams* params)
 	ctx->cache = nvg__allocPathCache();
 	if (ctx->cache == NULL) goto error;
 
+	ctx->textCache = nvg__allocTextCache();
+	if (ctx->textCache == NULL) goto error;
+
 	nvgSave(ctx);
 	nvgReset(ctx);
 
@@ -227,9 +376,9 @@ struct NVGcontext* nvgCreateInternal(struct NVGparams* params)
 	ctx->fs = fonsCreateInternal(&fontParams);
 	if (ctx->fs == NULL) goto error;
 
-	// Create font texture
-	ctx->fontImage = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, fontParams.width, fontParams.height, NULL);
-	if (ctx->fontImage == 0) goto error;
+	// Create font texture, textures for further atlas pages are created on demand.
+	ctx->fontImages[0] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, fontParams.width, fontParams.height, NULL);
+	if (ctx->fontImages[0] == 0) goto error;
 
 	return ctx;
 
@@ -243,6 +392,7 @@ void nvgDeleteInternal(struct NVGcontext* ctx)
 	if (ctx == NULL) return;
 	if (ctx->commands != NULL) free(ctx->commands);
 	if (ctx->cache != NULL) nvg__deletePathCache(ctx->cache);
+	if (ctx->textCache != NULL) nvg__deleteTextCache(ctx->textCache);
 
 	if (ctx->fs)
 		fonsDeleteInternal(ctx->fs);
@@ -253,6 +403,11 @@ void nvgDeleteInternal(struct NVGcontext* ctx)
 	free(ctx);
 }
 
+struct NVGparams* nvgInternalParams(struct NVGcontext* ctx)
+{
+	return &ctx->params;
+}
+
 void nvgBeginFrame(struct NVGcontext* ctx, int windowWidth, int windowHeight, float devicePixelRatio, int alphaBlend)
 {
 /*	printf("Tris: draws:%d  fill:%d  stroke:%d  text:%d  TOT:%d\n",
@@ -272,13 +427,69 @@ void nvgBeginFrame(struct NVGcontext* ctx, int windowWidth, int windowHeight, fl
 	ctx->fillTriCount = 0;
 	ctx->strokeTriCount = 0;
 	ctx->textTriCount = 0;
+	ctx->atlasUploadCount = 0;
+	ctx->atlasUploadBytes = 0;
+
+	ctx->textCache->stamp++;
+	fonsBeginFrame(ctx->fs);
+}
+
+static int nvg__fontImage(struct NVGcontext* ctx, int page)
+{
+	if (page < 0 || page >= FONS_MAX_PAGES) return 0;
+	if (ctx->fontImages[page] == 0) {
+		int iw = 0, ih = 0;
+		fonsGetAtlasSize(ctx->fs, &iw, &ih);
+		ctx->fontImages[page] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, NULL);
+	}
+	return ctx->fontImages[page];
+}
+
+static void nvg__flushTextTexture(struct NVGcontext* ctx)
+{
+	int dirty[4];
+	int i, n = fonsGetPageCount(ctx->fs);
+
+	for (i = 0; i < n; i++) {
+		if (fonsValidatePageTexture(ctx->fs, i, dirty)) {
+			// Update texture
+			int image = nvg__fontImage(ctx, i);
+			if (image != 0) {
+				int iw, ih;
+				const unsigned char* data = fonsGetPageTextureData(ctx->fs, i, &iw, &ih);
+				int x = dirty[0];
+				int y = dirty[1];
+				int w = dirty[2] - dirty[0];
+				int h = dirty[3] - dirty[1];
+				ctx->params.renderUpdateTexture(ctx->params.userPtr, image, x,y, w,h, data);
+				ctx->atlasUploadCount++;
+				ctx->atlasUploadBytes += w*h;
+			}
+		}
+	}
 }
 
 void nvgEndFrame(struct NVGcontext* ctx)
 {
+	// Glyphs added during the frame are uploaded in one go before the buffered draw calls are rendered.
+	if (ctx->params.bufferedRender)
+		nvg__flushTextTexture(ctx);
 	ctx->params.renderFlush(ctx->params.userPtr, ctx->alphaBlend);
 }
 
+void nvgFrameStats(struct NVGcontext* ctx, struct NVGframeStats* stats)
+{
+	stats->drawCalls = ctx->drawCallCount;
+	stats->fillTris = ctx->fillTriCount;
+	stats->strokeTris = ctx->strokeTriCount;
+	stats->textTris = ctx->textTriCount;
+	stats->atlasUploads = ctx->atlasUploadCount;
+	stats->atlasUploadBytes = ctx->atlasUploadBytes;
+	stats->renderDrawCalls = 0;
+	if (ctx->params.renderGetDrawCount != NULL)
+		stats->renderDrawCalls = ctx->params.renderGetDrawCount(ctx->params.userPtr);
+}
+
 struct NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b)
 {
 	return nvgRGBA(r,g,b,255);
@@ -467,6 +678,23 @@ void nvgTransformPoint(float* dx, float* dy, const float* t, float sx, float sy)
 	*dy = sx*t[1] + sy*t[3] + t[5];
 }
 
+static void nvg__transformPoints(float* pts, int npts, const float* t)
+{
+	int i = 0;
+#ifdef NVG_SIMD
+	NVGv4 t01 = nvg__v4set(t[0],t[1],t[0],t[1]);
+	NVGv4 t23 = nvg__v4set(t[2],t[3],t[2],t[3]);
+	NVGv4 t45 = nvg__v4set(t[4],t[5],t[4],t[5]);
+	for (; i+2 <= npts; i += 2) {
+		NVGv4 p = nvg__v4load(&pts[i*2]);
+		NVGv4 r = nvg__v4add(nvg__v4add(nvg__v4mul(nvg__v4dupEven(p), t01), nvg__v4mul(nvg__v4dupOdd(p), t23)), t45);
+		nvg__v4store(&pts[i*2], r);
+	}
+#endif
+	for (; i < npts; i++)
+		nvgTransformPoint(&pts[i*2],&pts[i*2+1], t, pts[i*2],pts[i*2+1]);
+}
+
 float nvgDegToRad(float deg)
 {
 	return deg / 180.0f * NVG_PI;
@@ -851,36 +1079,22 @@ static float nvg__distPtSeg(float x, float y, float px, float py, float qx, floa
 	return dx*dx + dy*dy;
 }
 
-static void nvg__appendCommands(struct NVGcontext* ctx, float* vals, int nvals)
+static void nvg__transformCommands(float* vals, int nvals, const float* t)
 {
-	struct NVGstate* state = nvg__getState(ctx);
-	int i;
-
-	if (ctx->ncommands+nvals > ctx->ccommands) {
-		if (ctx->ccommands == 0) ctx->ccommands = 8;
-		while (ctx->ccommands < ctx->ncommands+nvals)
-			ctx->ccommands *= 2;
-		ctx->commands = (float*)realloc(ctx->commands, ctx->ccommands*sizeof(float));
-		if (ctx->commands == NULL) return;
-	}
-
-	// transform commands
-	i = 0;
+	int i = 0;
 	while (i < nvals) {
 		int cmd = (int)vals[i];
 		switch (cmd) {
 		case NVG_MOVETO:
-			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
+			nvgTransformPoint(&vals[i+1],&vals[i+2], t, vals[i+1],vals[i+2]);
 			i += 3;
 			break;
 		case NVG_LINETO:
-			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
+			nvgTransformPoint(&vals[i+1],&vals[i+2], t, vals[i+1],vals[i+2]);
 			i += 3;
 			break;
 		case NVG_BEZIERTO:
-			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
-			nvgTransformPoint(&vals[i+3],&vals[i+4], state->xform, vals[i+3],vals[i+4]);
-			nvgTransformPoint(&vals[i+5],&vals[i+6], state->xform, vals[i+5],vals[i+6]);
+			nvg__transformPoints(&vals[i+1], 3, t);
 			i += 7;
 			break;
 		case NVG_CLOSE:
@@ -893,6 +1107,21 @@ static void nvg__appendCommands(struct NVGcontext* ctx, float* vals, int nvals)
 			i++;
 		}
 	}
+}
+
+static void nvg__appendCommands(struct NVGcontext* ctx, float* vals, int nvals)
+{
+	struct NVGstate* state = nvg__getState(ctx);
+
+	if (ctx->ncommands+nvals > ctx->ccommands) {
+		if (ctx->ccommands == 0) ctx->ccommands = 8;
+		while (ctx->ccommands < ctx->ncommands+nvals)
+			ctx->ccommands *= 2;
+		ctx->commands = (float*)realloc(ctx->commands, ctx->ccommands*sizeof(float));
+		if (ctx->commands == NULL) return;
+	}
+
+	nvg__transformCommands(vals, nvals, state->xform);
 
 	memcpy(&ctx->commands[ctx->ncommands], vals, nvals*sizeof(float));
 
@@ -1048,47 +1277,149 @@ static void nvg__vset(struct NVGvertex* vtx, float x, float y, float u, float v)
 	vtx->v = v;
 }
 
+// Flattens a cubic bezier into uniform parameter steps using forward differencing.
+// The distance between the curve and a chord over a parameter step h is at most
+// h^2/8 * max|B''|, and max|B''| <= 6 * max(|p1-2p2+p3|, |p2-2p3+p4|),
+// so the segment count follows directly from the tolerance.
 static void nvg__tesselateBezier(struct NVGcontext* ctx,
 								 float x1, float y1, float x2, float y2,
 								 float x3, float y3, float x4, float y4,
-								 int level, int type)
+								 int type)
 {
-	float x12,y12,x23,y23,x34,y34,x123,y123,x234,y234,x1234,y1234;
-	float dx,dy,d2,d3;
-	
-	if (level > 10) return;
-
-	x12 = (x1+x2)*0.5f;
-	y12 = (y1+y2)*0.5f;
-	x23 = (x2+x3)*0.5f;
-	y23 = (y2+y3)*0.5f;
-	x34 = (x3+x4)*0.5f;
-	y34 = (y3+y4)*0.5f;
-	x123 = (x12+x23)*0.5f;
-	y123 = (y12+y23)*0.5f;
-
-	dx = x3 - x1;
-	dy = y3 - y1;
-	d2 = nvg__absf(((x2 - x4) * dy - (y2 - y4) * dx));
-	d3 = nvg__absf(((x3 - x4) * dy - (y3 - y4) * dx));
-
-	if ((d2 + d3)*(d2 + d3) < ctx->tessTol * (dx*dx + dy*dy)) {
-		nvg__addPoint(ctx, x4, y4, type);
-		return;
-	}
+	struct NVGpath* path = nvg__lastPath(ctx);
+	struct NVGpathCache* cache = ctx->cache;
+	struct NVGpoint* pt;
+	float ddx0, ddy0, ddx1, ddy1, dd, h, h2, h3;
+	float ax, ay, bx, by, cx, cy;
+	float fx, fy, dfx, dfy, ddfx, ddfy, dddfx, dddfy;
+	int i, n;
 
-/*	if (nvg__absf(x1+x3-x2-x2) + nvg__absf(y1+y3-y2-y2) + nvg__absf(x2+x4-x3-x3) + nvg__absf(y2+y4-y3-y3) < ctx->tessTol) {
-		nvg__addPoint(ctx, x4, y4, type);
-		return;
-	}*/
+	if (path == NULL) return;
 
-	x234 = (x23+x34)*0.5f;
-	y234 = (y23+y34)*0.5f;
-	x1234 = (x123+x234)*0.5f;
-	y1234 = (y123+y234)*0.5f;
+	ddx0 = x1 - 2*x2 + x3;
+	ddy0 = y1 - 2*y2 + y3;
+	ddx1 = x2 - 2*x3 + x4;
+	ddy1 = y2 - 2*y3 + y4;
+	dd = nvg__maxf(ddx0*ddx0 + ddy0*ddy0, ddx1*ddx1 + ddy1*ddy1);
+
+	// n = sqrt(6/8 * |dd| / tol)
+	n = (int)ceilf(nvg__sqrtf(nvg__sqrtf(dd) * 0.75f / (ctx->tessTol * NVG_BEZIER_TOL)));
+	n = nvg__clampi(n, 1, NVG_BEZIER_MAX_SEGS);
+
+	if (cache->npoints+n > cache->cpoints) {
+		int cpoints = nvg__maxi(cache->npoints+n, cache->cpoints == 0 ? 8 : cache->cpoints*2);
+		struct NVGpoint* points = (struct NVGpoint*)realloc(cache->points, sizeof(struct NVGpoint)*cpoints);
+		if (points == NULL) return;
+		cache->points = points;
+		cache->cpoints = cpoints;
+	}
 
-	nvg__tesselateBezier(ctx, x1,y1, x12,y12, x123,y123, x1234,y1234, level+1, 0); 
-	nvg__tesselateBezier(ctx, x1234,y1234, x234,y234, x34,y34, x4,y4, level+1, type); 
+	// B(t) = a t^3 + b t^2 + c t + p1
+	ax = -x1 + 3*x2 - 3*x3 + x4;
+	ay = -y1 + 3*y2 - 3*y3 + y4;
+	bx = 3*x1 - 6*x2 + 3*x3;
+	by = 3*y1 - 6*y2 + 3*y3;
+	cx = -3*x1 + 3*x2;
+	cy = -3*y1 + 3*y2;
+
+	h = 1.0f / n;
+	h2 = h*h;
+	h3 = h2*h;
+	fx = x1;
+	fy = y1;
+	dfx = ax*h3 + bx*h2 + cx*h;
+	dfy = ay*h3 + by*h2 + cy*h;
+	ddfx = 6*ax*h3 + 2*bx*h2;
+	ddfy = 6*ay*h3 + 2*by*h2;
+	dddfx = 6*ax*h3;
+	dddfy = 6*ay*h3;
+
+	pt = cache->npoints > 0 ? &cache->points[cache->npoints-1] : NULL;
+	for (i = 1; i <= n; i++) {
+		int flags = 0;
+		if (i < n) {
+			fx += dfx;
+			fy += dfy;
+			dfx += ddfx;
+			dfy += ddfy;
+			ddfx += dddfx;
+			ddfy += dddfy;
+		} else {
+			// Land exactly on the end point.
+			fx = x4;
+			fy = y4;
+			flags = type;
+		}
+		if (pt != NULL && nvg__ptEquals(pt->x,pt->y, fx,fy, ctx->distTol)) {
+			pt->flags |= flags;
+			continue;
+		}
+		pt = &cache->points[cache->npoints++];
+		memset(pt, 0, sizeof(*pt));
+		pt->x = fx;
+		pt->y = fy;
+		pt->flags = (unsigned char)flags;
+		path->count++;
+	}
+}
+
+// Calculates direction and length of the segment from each point to the next, and updates bounds.
+static void nvg__calcSegments(struct NVGpoint* pts, int count, float* bounds)
+{
+	struct NVGpoint* p0;
+	struct NVGpoint* p1;
+	int i = 0;
+#ifdef NVG_SIMD
+	// The last point wraps around to the first, it is handled by the scalar loop.
+	NVGv4 eps = nvg__v4set1(1e-6f), one = nvg__v4set1(1.0f);
+	NVGv4 bminx = nvg__v4set1(bounds[0]), bminy = nvg__v4set1(bounds[1]);
+	NVGv4 bmaxx = nvg__v4set1(bounds[2]), bmaxy = nvg__v4set1(bounds[3]);
+	float b[4], vdx[4], vdy[4], vlen[4];
+	int k;
+	for (; i+4 < count; i += 4) {
+		struct NVGpoint* p = &pts[i];
+		NVGv4 x0 = nvg__v4set(p[0].x, p[1].x, p[2].x, p[3].x);
+		NVGv4 y0 = nvg__v4set(p[0].y, p[1].y, p[2].y, p[3].y);
+		NVGv4 dx = nvg__v4sub(nvg__v4set(p[1].x, p[2].x, p[3].x, p[4].x), x0);
+		NVGv4 dy = nvg__v4sub(nvg__v4set(p[1].y, p[2].y, p[3].y, p[4].y), y0);
+		NVGv4 d = nvg__v4sqrt(nvg__v4add(nvg__v4mul(dx,dx), nvg__v4mul(dy,dy)));
+		NVGv4 m = nvg__v4gt(d, eps);
+		NVGv4 id = nvg__v4div(one, d);
+		nvg__v4get(nvg__v4sel(m, nvg__v4mul(dx,id), dx), vdx);
+		nvg__v4get(nvg__v4sel(m, nvg__v4mul(dy,id), dy), vdy);
+		nvg__v4get(d, vlen);
+		for (k = 0; k < 4; k++) {
+			p[k].dx = vdx[k];
+			p[k].dy = vdy[k];
+			p[k].len = vlen[k];
+		}
+		bminx = nvg__v4min(bminx, x0);
+		bminy = nvg__v4min(bminy, y0);
+		bmaxx = nvg__v4max(bmaxx, x0);
+		bmaxy = nvg__v4max(bmaxy, y0);
+	}
+	nvg__v4get(bminx, b);
+	for (k = 0; k < 4; k++) bounds[0] = nvg__minf(bounds[0], b[k]);
+	nvg__v4get(bminy, b);
+	for (k = 0; k < 4; k++) bounds[1] = nvg__minf(bounds[1], b[k]);
+	nvg__v4get(bmaxx, b);
+	for (k = 0; k < 4; k++) bounds[2] = nvg__maxf(bounds[2], b[k]);
+	nvg__v4get(bmaxy, b);
+	for (k = 0; k < 4; k++) bounds[3] = nvg__maxf(bounds[3], b[k]);
+#endif
+	for (; i < count; i++) {
+		p0 = &pts[i];
+		p1 = &pts[i+1 < count ? i+1 : 0];
+		// Calculate segment direction and length
+		p0->dx = p1->x - p0->x;
+		p0->dy = p1->y - p0->y;
+		p0->len = nvg__normalize(&p0->dx, &p0->dy);
+		// Update bounds
+		bounds[0] = nvg__minf(bounds[0], p0->x);
+		bounds[1] = nvg__minf(bounds[1], p0->y);
+		bounds[2] = nvg__maxf(bounds[2], p0->x);
+		bounds[3] = nvg__maxf(bounds[3], p0->y);
+	}
 }
 
 static void nvg__flattenPaths(struct NVGcontext* ctx)
@@ -1131,7 +1462,7 @@ static void nvg__flattenPaths(struct NVGcontext* ctx)
 				cp1 = &ctx->commands[i+1];
 				cp2 = &ctx->commands[i+3];
 				p = &ctx->commands[i+5];
-				nvg__tesselateBezier(ctx, last->x,last->y, cp1[0],cp1[1], cp2[0],cp2[1], p[0],p[1], 0, NVG_PT_CORNER);
+				nvg__tesselateBezier(ctx, last->x,last->y, cp1[0],cp1[1], cp2[0],cp2[1], p[0],p[1], NVG_PT_CORNER);
 			}
 			i += 7;
 			break;
@@ -1176,19 +1507,7 @@ static void nvg__flattenPaths(struct NVGcontext* ctx)
 		if (path->winding == NVG_REVERSE)
 			nvg__polyReverse(pts, path->count);
 
-		for(i = 0; i < path->count; ++i) {
-			// Calculate segment direction and length
-			p0->dx = p1->x - p0->x;
-			p0->dy = p1->y - p0->y;
-			p0->len = nvg__normalize(&p0->dx, &p0->dy);
-			// Update bounds
-			cache->bounds[0] = nvg__minf(cache->bounds[0], p0->x);
-			cache->bounds[1] = nvg__minf(cache->bounds[1], p0->y);
-			cache->bounds[2] = nvg__maxf(cache->bounds[2], p0->x);
-			cache->bounds[3] = nvg__maxf(cache->bounds[3], p0->y);
-			// Advance
-			p0 = p1++;
-		}
+		nvg__calcSegments(pts, path->count, cache->bounds);
 	}
 }
 
@@ -1360,6 +1679,105 @@ static struct NVGvertex* nvg__bevelJoin(struct NVGvertex* dst, struct NVGpoint*
 	return dst;
 }
 
+static void nvg__setJoinFlags(struct NVGpoint* p1, float dmr2, float cross, float limit,
+							  int lineJoin, float miterLimit, int* nleft, int* nbevel)
+{
+	// Clear flags, but keep the corner.
+	p1->flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+
+	// Keep track of left turns.
+	if (cross > 0.0f) {
+		(*nleft)++;
+		p1->flags |= NVG_PT_LEFT;
+	}
+
+	// Calculate if we should use bevel or miter for inner join.
+	if ((dmr2 * limit*limit) < 1.0f)
+		p1->flags |= NVG_PR_INNERBEVEL;
+
+	// Check to see if the corner needs to be beveled.
+	if (p1->flags & NVG_PT_CORNER) {
+		if ((dmr2 * miterLimit*miterLimit) < 1.0f || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND) {
+			p1->flags |= NVG_PT_BEVEL;
+		}
+	}
+
+	if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+		(*nbevel)++;
+}
+
+static void nvg__calcJoin(struct NVGpoint* p0, struct NVGpoint* p1, float iw,
+						  int lineJoin, float miterLimit, int* nleft, int* nbevel)
+{
+	float dlx0, dly0, dlx1, dly1, dmr2, cross, limit;
+	dlx0 = p0->dy;
+	dly0 = -p0->dx;
+	dlx1 = p1->dy;
+	dly1 = -p1->dx;
+	// Calculate extrusions
+	p1->dmx = (dlx0 + dlx1) * 0.5f;
+	p1->dmy = (dly0 + dly1) * 0.5f;
+	dmr2 = p1->dmx*p1->dmx + p1->dmy*p1->dmy;
+	if (dmr2 > 0.000001f) {
+		float scale = 1.0f / dmr2;
+		if (scale > 600.0f) {
+			scale = 600.0f;
+		}
+		p1->dmx *= scale;
+		p1->dmy *= scale;
+	}
+	cross = p1->dx * p0->dy - p0->dx * p1->dy;
+	limit = nvg__maxf(1.01f, nvg__minf(p0->len, p1->len) * iw);
+	nvg__setJoinFlags(p1, dmr2, cross, limit, lineJoin, miterLimit, nleft, nbevel);
+}
+
+// Calculates extrusion and join type for each point of a path.
+static void nvg__calcJoins(struct NVGpoint* pts, int count, float iw,
+						   int lineJoin, float miterLimit, int* nleft, int* nbevel)
+{
+	int i = 1;
+	if (count <= 0) return;
+	// The first point joins to the last one.
+	nvg__calcJoin(&pts[count-1], &pts[0], iw, lineJoin, miterLimit, nleft, nbevel);
+#ifdef NVG_SIMD
+	{
+		NVGv4 half = nvg__v4set1(0.5f), eps = nvg__v4set1(0.000001f);
+		NVGv4 one = nvg__v4set1(1.0f), maxScale = nvg__v4set1(600.0f);
+		NVGv4 minLimit = nvg__v4set1(1.01f), viw = nvg__v4set1(iw);
+		float vdmx[4], vdmy[4], vdmr2[4], vcross[4], vlimit[4];
+		int k;
+		for (; i+4 <= count; i += 4) {
+			struct NVGpoint* p = &pts[i-1];	// p[k] is previous point, p[k+1] is current.
+			NVGv4 dx0 = nvg__v4set(p[0].dx, p[1].dx, p[2].dx, p[3].dx);
+			NVGv4 dy0 = nvg__v4set(p[0].dy, p[1].dy, p[2].dy, p[3].dy);
+			NVGv4 len0 = nvg__v4set(p[0].len, p[1].len, p[2].len, p[3].len);
+			NVGv4 dx1 = nvg__v4set(p[1].dx, p[2].dx, p[3].dx, p[4].dx);
+			NVGv4 dy1 = nvg__v4set(p[1].dy, p[2].dy, p[3].dy, p[4].dy);
+			NVGv4 len1 = nvg__v4set(p[1].len, p[2].len, p[3].len, p[4].len);
+			NVGv4 dmx = nvg__v4mul(nvg__v4add(dy0, dy1), half);
+			NVGv4 dmy = nvg__v4mul(nvg__v4add(nvg__v4neg(dx0), nvg__v4neg(dx1)), half);
+			NVGv4 dmr2 = nvg__v4add(nvg__v4mul(dmx,dmx), nvg__v4mul(dmy,dmy));
+			NVGv4 m = nvg__v4gt(dmr2, eps);
+			NVGv4 scale = nvg__v4min(nvg__v4div(one, dmr2), maxScale);
+			dmx = nvg__v4sel(m, nvg__v4mul(dmx, scale), dmx);
+			dmy = nvg__v4sel(m, nvg__v4mul(dmy, scale), dmy);
+			nvg__v4get(dmx, vdmx);
+			nvg__v4get(dmy, vdmy);
+			nvg__v4get(dmr2, vdmr2);
+			nvg__v4get(nvg__v4sub(nvg__v4mul(dx1, dy0), nvg__v4mul(dx0, dy1)), vcross);
+			nvg__v4get(nvg__v4max(minLimit, nvg__v4mul(nvg__v4min(len0, len1), viw)), vlimit);
+			for (k = 0; k < 4; k++) {
+				p[k+1].dmx = vdmx[k];
+				p[k+1].dmy = vdmy[k];
+				nvg__setJoinFlags(&p[k+1], vdmr2[k], vcross[k], vlimit[k], lineJoin, miterLimit, nleft, nbevel);
+			}
+		}
+	}
+#endif
+	for (; i < count; i++)
+		nvg__calcJoin(&pts[i-1], &pts[i], iw, lineJoin, miterLimit, nleft, nbevel);
+}
+
 static int nvg__expandStrokeAndFill(struct NVGcontext* ctx, int feats, float w, int lineCap, int lineJoin, float miterLimit)
 {
 	struct NVGpathCache* cache = ctx->cache;
@@ -1383,54 +1801,7 @@ static int nvg__expandStrokeAndFill(struct NVGcontext* ctx, int feats, float w,
 		path->nbevel = 0;
 		nleft = 0;
 
-		p0 = &pts[path->count-1];
-		p1 = &pts[0];
-		for (j = 0; j < path->count; j++) {
-			float dlx0, dly0, dlx1, dly1, dmr2, cross, limit;
-			dlx0 = p0->dy;
-			dly0 = -p0->dx;
-			dlx1 = p1->dy;
-			dly1 = -p1->dx;
-			// Calculate extrusions
-			p1->dmx = (dlx0 + dlx1) * 0.5f;
-			p1->dmy = (dly0 + dly1) * 0.5f;
-			dmr2 = p1->dmx*p1->dmx + p1->dmy*p1->dmy;
-			if (dmr2 > 0.000001f) {
-				float scale = 1.0f / dmr2;
-				if (scale > 600.0f) {
-					scale = 600.0f;
-				}
-				p1->dmx *= scale;
-				p1->dmy *= scale;
-			}
-
-			// Clear flags, but keep the corner.
-			p1->flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
-
-			// Keep track of left turns.
-			cross = p1->dx * p0->dy - p0->dx * p1->dy;
-			if (cross > 0.0f) {
-				nleft++;
-				p1->flags |= NVG_PT_LEFT;
-			}
-
-			// Calculate if we should use bevel or miter for inner join.
-			limit = nvg__maxf(1.01f, nvg__minf(p0->len, p1->len) * iw);
-			if ((dmr2 * limit*limit) < 1.0f)
-				p1->flags |= NVG_PR_INNERBEVEL;
-
-			// Check to see if the corner needs to be beveled.
-			if (p1->flags & NVG_PT_CORNER) {
-				if ((dmr2 * miterLimit*miterLimit) < 1.0f || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND) {
-					p1->flags |= NVG_PT_BEVEL;
-				}
-			}
-
-			if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
-				path->nbevel++;
-
-			p0 = p1++;
-		}
+		nvg__calcJoins(pts, path->count, iw, lineJoin, miterLimit, &nleft, &path->nbevel);
 
 		path->convex = (nleft == path->count) ? 1 : 0;
 	}
@@ -1938,6 +2309,256 @@ void nvgStroke(struct NVGcontext* ctx)
 	}
 }
 
+// Cached paths
+static int nvg__xformEquals(const float* a, const float* b)
+{
+	return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3] && a[4] == b[4] && a[5] == b[5];
+}
+
+struct NVGcachedPath* nvgCreatePath(struct NVGcontext* ctx)
+{
+	struct NVGstate* state = nvg__getState(ctx);
+	struct NVGcachedPath* path = (struct NVGcachedPath*)malloc(sizeof(struct NVGcachedPath));
+	if (path == NULL) goto error;
+	memset(path, 0, sizeof(struct NVGcachedPath));
+
+	if (ctx->ncommands > 0) {
+		path->commands = (float*)malloc(sizeof(float)*ctx->ncommands);
+		if (path->commands == NULL) goto error;
+		memcpy(path->commands, ctx->commands, sizeof(float)*ctx->ncommands);
+		path->ncommands = ctx->ncommands;
+	}
+	memcpy(path->xform, state->xform, sizeof(float)*6);
+
+	return path;
+error:
+	nvgDeletePath(ctx, path);
+	return NULL;
+}
+
+void nvgDeletePath(struct NVGcontext* ctx, struct NVGcachedPath* path)
+{
+	NVG_NOTUSED(ctx);
+	if (path == NULL) return;
+	if (path->commands != NULL) free(path->commands);
+	if (path->points != NULL) free(path->points);
+	if (path->paths != NULL) free(path->paths);
+	if (path->fill.paths != NULL) free(path->fill.paths);
+	if (path->fill.verts != NULL) free(path->fill.verts);
+	if (path->stroke.paths != NULL) free(path->stroke.paths);
+	if (path->stroke.verts != NULL) free(path->stroke.verts);
+	free(path);
+}
+
+// Flattens the path again if the transform or tessellation tolerance has changed.
+// Returns 1 if the path cache holds the flattened points afterwards.
+static int nvg__updateCachedPath(struct NVGcontext* ctx, struct NVGcachedPath* path)
+{
+	struct NVGstate* state = nvg__getState(ctx);
+	struct NVGpathCache* cache = ctx->cache;
+	float t[6];
+
+	if (path->flatValid && path->flatTessTol == ctx->tessTol && nvg__xformEquals(path->flatXform, state->xform))
+		return 0;
+
+	if (path->ncommands > ctx->ccommands) {
+		ctx->ccommands = path->ncommands;
+		ctx->commands = (float*)realloc(ctx->commands, ctx->ccommands*sizeof(float));
+		if (ctx->commands == NULL) goto error;
+	}
+	if (path->ncommands > 0)
+		memcpy(ctx->commands, path->commands, sizeof(float)*path->ncommands);
+	ctx->ncommands = path->ncommands;
+
+	// Move the captured commands from the capture transform to the current one.
+	if (!nvg__xformEquals(path->xform, state->xform)) {
+		nvgTransformInverse(t, path->xform);
+		nvgTransformMultiply(t, state->xform);
+		nvg__transformCommands(ctx->commands, ctx->ncommands, t);
+	}
+
+	nvg__clearPathCache(ctx);
+	nvg__flattenPaths(ctx);
+
+	if (cache->npoints > 0) {
+		path->points = (struct NVGpoint*)realloc(path->points, sizeof(struct NVGpoint)*cache->npoints);
+		if (path->points == NULL) goto error;
+		memcpy(path->points, cache->points, sizeof(struct NVGpoint)*cache->npoints);
+	}
+	path->npoints = cache->npoints;
+	if (cache->npaths > 0) {
+		path->paths = (struct NVGpath*)realloc(path->paths, sizeof(struct NVGpath)*cache->npaths);
+		if (path->paths == NULL) goto error;
+		memcpy(path->paths, cache->paths, sizeof(struct NVGpath)*cache->npaths);
+		path->fill.paths = (struct NVGpath*)realloc(path->fill.paths, sizeof(struct NVGpath)*cache->npaths);
+		path->stroke.paths = (struct NVGpath*)realloc(path->stroke.paths, sizeof(struct NVGpath)*cache->npaths);
+		if (path->fill.paths == NULL || path->stroke.paths == NULL) goto error;
+	}
+	path->npaths = cache->npaths;
+	memcpy(path->bounds, cache->bounds, sizeof(float)*4);
+
+	memcpy(path->flatXform, state->xform, sizeof(float)*6);
+	path->flatTessTol = ctx->tessTol;
+	path->flatValid = 1;
+	path->fill.valid = 0;
+	path->stroke.valid = 0;
+
+	return 1;
+
+error:
+	path->flatValid = 0;
+	path->npoints = 0;
+	path->npaths = 0;
+	return 0;
+}
+
+static void nvg__expandCachedPath(struct NVGcontext* ctx, struct NVGcachedPath* path, int loaded,
+								  struct NVGcachedExpand* exp, int feats, float w, int lineCap, int lineJoin, float miterLimit)
+{
+	struct NVGpathCache* cache = ctx->cache;
+	int i, nverts;
+
+	if (!loaded) {
+		// Restore the flattened points, the expansion modifies them.
+		if (path->npoints > cache->cpoints) {
+			cache->cpoints = path->npoints;
+			cache->points = (struct NVGpoint*)realloc(cache->points, sizeof(struct NVGpoint)*cache->cpoints);
+			if (cache->points == NULL) goto error;
+		}
+		if (path->npaths > cache->cpaths) {
+			cache->cpaths = path->npaths;
+			cache->paths = (struct NVGpath*)realloc(cache->paths, sizeof(struct NVGpath)*cache->cpaths);
+			if (cache->paths == NULL) goto error;
+		}
+		if (path->npoints > 0)
+			memcpy(cache->points, path->points, sizeof(struct NVGpoint)*path->npoints);
+		if (path->npaths > 0)
+			memcpy(cache->paths, path->paths, sizeof(struct NVGpath)*path->npaths);
+		cache->npoints = path->npoints;
+		cache->npaths = path->npaths;
+	}
+
+	if (!nvg__expandStrokeAndFill(ctx, feats, w, lineCap, lineJoin, miterLimit))
+		goto error;
+
+	// Fill and stroke vertices of each path are laid out back to back.
+	nverts = 0;
+	for (i = 0; i < path->npaths; i++) {
+		const struct NVGpath* src = &cache->paths[i];
+		if (src->fill != NULL) nverts = nvg__maxi(nverts, (int)(src->fill - cache->verts) + src->nfill);
+		if (src->stroke != NULL) nverts = nvg__maxi(nverts, (int)(src->stroke - cache->verts) + src->nstroke);
+	}
+
+	if (nverts > exp->cverts) {
+		exp->cverts = nverts;
+		exp->verts = (struct NVGvertex*)realloc(exp->verts, sizeof(struct NVGvertex)*exp->cverts);
+		if (exp->verts == NULL) goto error;
+	}
+	if (nverts > 0)
+		memcpy(exp->verts, cache->verts, sizeof(struct NVGvertex)*nverts);
+	exp->nverts = nverts;
+
+	// Point the copied paths to the cached vertices.
+	for (i = 0; i < path->npaths; i++) {
+		struct NVGpath* dst = &exp->paths[i];
+		*dst = cache->paths[i];
+		if (dst->fill != NULL) dst->fill = exp->verts + (dst->fill - cache->verts);
+		if (dst->stroke != NULL) dst->stroke = exp->verts + (dst->stroke - cache->verts);
+	}
+
+	exp->w = w;
+	exp->lineCap = lineCap;
+	exp->lineJoin = lineJoin;
+	exp->miterLimit = miterLimit;
+	exp->valid = 1;
+	return;
+
+error:
+	exp->valid = 0;
+}
+
+void nvgFillPath(struct NVGcontext* ctx, struct NVGcachedPath* path)
+{
+	struct NVGstate* state = nvg__getState(ctx);
+	struct NVGcachedExpand* fill = &path->fill;
+	const struct NVGpath* p;
+	int i, loaded;
+
+	loaded = nvg__updateCachedPath(ctx, path);
+	if (!path->flatValid) goto done;
+
+	if (ctx->params.edgeAntiAlias) {
+		if (!fill->valid || fill->w != ctx->fringeWidth)
+			nvg__expandCachedPath(ctx, path, loaded, fill, NVG_FILL|NVG_STROKE, ctx->fringeWidth, NVG_BUTT, NVG_MITER, 3.6f);
+	} else {
+		if (!fill->valid)
+			nvg__expandCachedPath(ctx, path, loaded, fill, NVG_FILL, 0.0f, NVG_BUTT, NVG_MITER, 1.2f);
+	}
+	if (!fill->valid) goto done;
+
+	ctx->params.renderFill(ctx->params.userPtr, &state->fill, &state->scissor, ctx->fringeWidth,
+						   path->bounds, fill->paths, path->npaths);
+
+	// Count triangles
+	for (i = 0; i < path->npaths; i++) {
+		p = &fill->paths[i];
+		ctx->fillTriCount += p->nfill-2;
+		ctx->fillTriCount += p->nstroke-2;
+		ctx->drawCallCount += 2;
+	}
+
+done:
+	// The current path may have been used for tessellation, start from scratch.
+	nvgBeginPath(ctx);
+}
+
+void nvgStrokePath(struct NVGcontext* ctx, struct NVGcachedPath* path)
+{
+	struct NVGstate* state = nvg__getState(ctx);
+	struct NVGcachedExpand* stroke = &path->stroke;
+	float scale = nvg__getAverageScale(state->xform);
+	float strokeWidth = nvg__clampf(state->strokeWidth * scale, 0.0f, 20.0f);
+	struct NVGpaint strokePaint = state->stroke;
+	const struct NVGpath* p;
+	float w;
+	int i, loaded;
+
+	if (strokeWidth < ctx->fringeWidth) {
+		// If the stroke width is less than pixel size, use alpha to emulate coverate.
+		// Since coverage is area, scale by alpha*alpha.
+		float alpha = nvg__clampf(strokeWidth / ctx->fringeWidth, 0.0f, 1.0f);
+		strokePaint.innerColor.a *= alpha*alpha;
+		strokePaint.outerColor.a *= alpha*alpha;
+		strokeWidth = ctx->fringeWidth;
+	}
+
+	loaded = nvg__updateCachedPath(ctx, path);
+	if (!path->flatValid) goto done;
+
+	if (ctx->params.edgeAntiAlias)
+		w = strokeWidth*0.5f + ctx->fringeWidth*0.5f;
+	else
+		w = strokeWidth*0.5f;
+	if (!stroke->valid || stroke->w != w || stroke->lineCap != state->lineCap ||
+		stroke->lineJoin != state->lineJoin || stroke->miterLimit != state->miterLimit)
+		nvg__expandCachedPath(ctx, path, loaded, stroke, NVG_STROKE|NVG_CAPS, w, state->lineCap, state->lineJoin, state->miterLimit);
+	if (!stroke->valid) goto done;
+
+	ctx->params.renderStroke(ctx->params.userPtr, &strokePaint, &state->scissor, ctx->fringeWidth,
+							 strokeWidth, stroke->paths, path->npaths);
+
+	// Count triangles
+	for (i = 0; i < path->npaths; i++) {
+		p = &stroke->paths[i];
+		ctx->strokeTriCount += p->nstroke-2;
+		ctx->drawCallCount++;
+	}
+
+done:
+	// The current path may have been used for tessellation, start from scratch.
+	nvgBeginPath(ctx);
+}
+
 // Add fonts
 int nvgCreateFont(struct NVGcontext* ctx, const char* name, const char* path)
 {
@@ -2008,18 +2629,133 @@ static float nvg__getFontScale(struct NVGstate* state)
 	return nvg__minf(nvg__quantize(nvg__getAverageScale(state->xform), 0.01f), 4.0f);
 }
 
+static unsigned int nvg__hashText(const char* str, int n)
+{
+	// FNV-1a
+	unsigned int h = 2166136261u;
+	int i;
+	for (i = 0; i < n; i++) {
+		h ^= (unsigned char)str[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+// Returns glyph quads of the string using the current font state.
+// Repeated strings are served from the run cache, new ones are laid out and rasterized through fontstash.
+static struct NVGtextRun* nvg__getTextRun(struct NVGcontext* ctx, int font, float size, float spacing, float blur, int align,
+										  const char* string, const char* end)
+{
+	struct NVGtextCache* cache = ctx->textCache;
+	struct NVGtextRun* set;
+	struct NVGtextRun* run = NULL;
+	struct FONStextIter iter;
+	struct FONSquad q;
+	int i, j, nstr = (int)(end - string);
+	unsigned int hash = nvg__hashText(string, nstr);
+	int gen = fonsGetAtlasGeneration(ctx->fs);
+
+	// Cached quads point to the old atlas layout.
+	if (cache->atlasGeneration != gen) {
+		for (i = 0; i < NVG_TEXT_CACHE_SETS*NVG_TEXT_CACHE_WAYS; i++)
+			cache->runs[i].used = 0;
+		cache->atlasGeneration = gen;
+	}
+
+	set = &cache->runs[(hash & (NVG_TEXT_CACHE_SETS-1)) * NVG_TEXT_CACHE_WAYS];
+	for (i = 0; i < NVG_TEXT_CACHE_WAYS; i++) {
+		struct NVGtextRun* r = &set[i];
+		if (r->used != 0 && r->hash == hash && r->nstr == nstr && r->font == font && r->align == align &&
+			r->size == size && r->spacing == spacing && r->blur == blur && memcmp(r->str, string, nstr) == 0) {
+			r->used = cache->stamp;
+			// Keep the pages of the run from being evicted this frame.
+			for (j = 0; j < FONS_MAX_PAGES; j++) {
+				if (r->pages & (1u << j))
+					fonsTouchPage(ctx->fs, j);
+			}
+			return r;
+		}
+	}
+
+	// Evict least recently used run in the set.
+	run = &set[0];
+	for (i = 1; i < NVG_TEXT_CACHE_WAYS; i++) {
+		if (set[i].used < run->used)
+			run = &set[i];
+	}
+	run->used = 0;
+
+	if (nstr > run->cstr) {
+		run->cstr = nstr;
+		run->str = (char*)realloc(run->str, run->cstr);
+		if (run->str == NULL) {
+			run->cstr = 0;
+			return NULL;
+		}
+	}
+	// Each glyph takes at least one byte.
+	if (nstr > run->cglyphs) {
+		run->cglyphs = nstr;
+		run->glyphs = (struct NVGtextGlyph*)realloc(run->glyphs, sizeof(struct NVGtextGlyph)*run->cglyphs);
+		if (run->glyphs == NULL) {
+			run->cglyphs = 0;
+			return NULL;
+		}
+	}
+	if (nstr > 0)
+		memcpy(run->str, string, nstr);
+	run->nstr = nstr;
+	run->hash = hash;
+	run->font = font;
+	run->align = align;
+	run->size = size;
+	run->spacing = spacing;
+	run->blur = blur;
+	run->nglyphs = 0;
+	run->pages = 0;
+
+	// Lay out the glyphs from origin, so that the quads come out as integer offsets which
+	// can be snapped against any start position the same way fontstash does.
+	fonsTextIterInit(ctx->fs, &iter, 0, 0, string, end, FONS_GLYPH_BITMAP_REQUIRED);
+	run->alignx = iter.x;
+	run->aligny = iter.y;
+	iter.x = iter.nextx = 0;
+	iter.y = iter.nexty = 0;
+	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
+		struct NVGtextGlyph* g;
+		if (iter.prevGlyphIndex == -1 || run->nglyphs >= run->cglyphs) continue;
+		g = &run->glyphs[run->nglyphs++];
+		g->x = q.x0;
+		g->y = q.y0;
+		g->w = q.x1 - q.x0;
+		g->h = q.y1 - q.y0;
+		g->s0 = q.s0;
+		g->t0 = q.t0;
+		g->s1 = q.s1;
+		g->t1 = q.t1;
+		g->page = iter.page;
+		run->pages |= 1u << iter.page;
+	}
+	run->lastx = iter.x;
+
+	// Rasterizing the glyphs may have reset the atlas.
+	if (fonsGetAtlasGeneration(ctx->fs) != gen)
+		return run;
+
+	run->used = cache->stamp;
+	return run;
+}
+
 float nvgText(struct NVGcontext* ctx, float x, float y, const char* string, const char* end)
 {
 	struct NVGstate* state = nvg__getState(ctx);
 	struct NVGpaint paint;
-	struct FONStextIter iter;
-	struct FONSquad q;
+	struct NVGtextRun* run;
 	struct NVGvertex* verts;
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
-	int dirty[4];
-	int cverts = 0;
-	int nverts = 0;
+	float sx, sy;
+	int i, page, nverts;
 
 	if (end == NULL)
 		end = string + strlen(string);
@@ -2032,52 +2768,60 @@ float nvgText(struct NVGcontext* ctx, float x, float y, const char* string, cons
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
-	cverts = nvg__maxi(2, (int)(end - string)) * 6; // conservative estimate.
-	verts = nvg__allocTempVerts(ctx, cverts);
-	if (verts == NULL) return x;
-
-	fonsTextIterInit(ctx->fs, &iter, x*scale, y*scale, string, end);
-	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
-		// Trasnform corners.
-		float c[4*2];
-		nvgTransformPoint(&c[0],&c[1], state->xform, q.x0*invscale, q.y0*invscale);
-		nvgTransformPoint(&c[2],&c[3], state->xform, q.x1*invscale, q.y0*invscale);
-		nvgTransformPoint(&c[4],&c[5], state->xform, q.x1*invscale, q.y1*invscale);
-		nvgTransformPoint(&c[6],&c[7], state->xform, q.x0*invscale, q.y1*invscale);
-		// Create triangles
-		if (nverts+6 <= cverts) {
-			nvg__vset(&verts[nverts], c[0], c[1], q.s0, q.t0); nverts++;
-			nvg__vset(&verts[nverts], c[4], c[5], q.s1, q.t1); nverts++;
-			nvg__vset(&verts[nverts], c[2], c[3], q.s1, q.t0); nverts++;
-			nvg__vset(&verts[nverts], c[0], c[1], q.s0, q.t0); nverts++;
-			nvg__vset(&verts[nverts], c[6], c[7], q.s0, q.t1); nverts++;
-			nvg__vset(&verts[nverts], c[4], c[5], q.s1, q.t1); nverts++;
+	run = nvg__getTextRun(ctx, state->fontId, state->fontSize*scale, state->letterSpacing*scale, state->fontBlur*scale,
+						  state->textAlign, string, end);
+	if (run == NULL) return x;
+
+	// Back-ends which render immediately need the glyphs right away,
+	// buffered ones get the whole frame's glyphs uploaded in nvgEndFrame().
+	if (!ctx->params.bufferedRender)
+		nvg__flushTextTexture(ctx);
+
+	sx = x*scale + run->alignx;
+	sy = y*scale + run->aligny;
+
+	// One batch per atlas page, usually there is just one.
+	for (page = 0; page < FONS_MAX_PAGES; page++) {
+		if ((run->pages & (1u << page)) == 0) continue;
+
+		verts = nvg__allocTempVerts(ctx, run->nglyphs * 6);
+		if (verts == NULL) return x;
+
+		nverts = 0;
+		for (i = 0; i < run->nglyphs; i++) {
+			const struct NVGtextGlyph* g = &run->glyphs[i];
+			// Snap to pixel grid like fontstash does, and trasnform corners.
+			float x0, y0, x1, y1;
+			float c[4*2];
+			if (g->page != page) continue;
+			x0 = (float)(int)(sx + g->x);
+			y0 = (float)(int)(sy + g->y);
+			x1 = x0 + g->w;
+			y1 = y0 + g->h;
+			nvgTransformPoint(&c[0],&c[1], state->xform, x0*invscale, y0*invscale);
+			nvgTransformPoint(&c[2],&c[3], state->xform, x1*invscale, y0*invscale);
+			nvgTransformPoint(&c[4],&c[5], state->xform, x1*invscale, y1*invscale);
+			nvgTransformPoint(&c[6],&c[7], state->xform, x0*invscale, y1*invscale);
+			// Create triangles
+			nvg__vset(&verts[nverts], c[0], c[1], g->s0, g->t0); nverts++;
+			nvg__vset(&verts[nverts], c[4], c[5], g->s1, g->t1); nverts++;
+			nvg__vset(&verts[nverts], c[2], c[3], g->s1, g->t0); nverts++;
+			nvg__vset(&verts[nverts], c[0], c[1], g->s0, g->t0); nverts++;
+			nvg__vset(&verts[nverts], c[6], c[7], g->s0, g->t1); nverts++;
+			nvg__vset(&verts[nverts], c[4], c[5], g->s1, g->t1); nverts++;
 		}
-	}
-
-	// TODO: add back-end bit to do this just once per frame. 
-	if (fonsValidateTexture(ctx->fs, dirty)) {
-		// Update texture
-		if (ctx->fontImage != 0) {
-			int iw, ih;
-			const unsigned char* data = fonsGetTextureData(ctx->fs, &iw, &ih);
-			int x = dirty[0];
-			int y = dirty[1];
-			int w = dirty[2] - dirty[0];
-			int h = dirty[3] - dirty[1];
-			ctx->params.renderUpdateTexture(ctx->params.userPtr, ctx->fontImage, x,y, w,h, data);
-		}
-	}
 
-	// Render triangles.
-	paint = state->fill;
-	paint.image = ctx->fontImage;
-	ctx->params.renderTriangles(ctx->params.userPtr, &paint, &state->scissor, verts, nverts);
+		// Render triangles.
+		paint = state->fill;
+		paint.image = nvg__fontImage(ctx, page);
+		if (paint.image == 0) continue;
+		ctx->params.renderTriangles(ctx->params.userPtr, &paint, &state->scissor, verts, nverts);
 
-	ctx->drawCallCount++;
-	ctx->textTriCount += nverts/3;
+		ctx->drawCallCount++;
+		ctx->textTriCount += nverts/3;
+	}
 
-	return iter.x;
+	return sx + run->lastx;
 }
 
 void nvgTextBox(struct NVGcontext* ctx, float x, float y, float breakRowWidth, const char* string, const char* end)
@@ -2136,7 +2880,7 @@ int nvgTextGlyphPositions(struct NVGcontext* ctx, float x, float y, const char*
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
-	fonsTextIterInit(ctx->fs, &iter, x*scale, y*scale, string, end);
+	fonsTextIterInit(ctx->fs, &iter, x*scale, y*scale, string, end, FONS_GLYPH_BITMAP_OPTIONAL);
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
 		positions[npos].str = iter.str;
 		positions[npos].x = iter.x * invscale;
@@ -2195,7 +2939,7 @@ int nvgTextBreakLines(struct NVGcontext* ctx, const char* string, const char* en
 
 	breakRowWidth *= scale;
 
-	fonsTextIterInit(ctx->fs, &iter, 0, 0, string, end);
+	fonsTextIterInit(ctx->fs, &iter, 0, 0, string, end, FONS_GLYPH_BITMAP_OPTIONAL);
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
 		switch (iter.codepoint) {
 			case 9:			// \t
@@ -2347,6 +3091,42 @@ int nvgTextBreakLines(struct NVGcontext* ctx, const char* string, const char* en
 	return nrows;
 }
 
+void nvgTextPrepare(struct NVGcontext* ctx, const char* string, const char* end)
+{
+	struct NVGstate* state = nvg__getState(ctx);
+	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
+
+	if (end == NULL)
+		end = string + strlen(string);
+
+	if (state->fontId == FONS_INVALID) return;
+
+	fonsSetSize(ctx->fs, state->fontSize*scale);
+	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
+	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetAlign(ctx->fs, state->textAlign);
+	fonsSetFont(ctx->fs, state->fontId);
+
+	// Laying out the run rasterizes the glyphs into the atlas.
+	nvg__getTextRun(ctx, state->fontId, state->fontSize*scale, state->letterSpacing*scale, state->fontBlur*scale,
+					state->textAlign, string, end);
+}
+
+void nvgFlushTextTexture(struct NVGcontext* ctx)
+{
+	nvg__flushTextTexture(ctx);
+}
+
+int nvgFontWorkers(struct NVGcontext* ctx, int threads)
+{
+	return fonsStartWorkers(ctx->fs, threads);
+}
+
+void nvgWaitTextPrepare(struct NVGcontext* ctx)
+{
+	fonsWaitGlyphs(ctx->fs);
+}
+
 float nvgTextBounds(struct NVGcontext* ctx, float x, float y, const char* string, const char* end, float* bounds)
 {
 	struct NVGstate* state = nvg__getState(ctx);
@@ -121,6 +121,20 @@ void nvgBeginFrame(struct NVGcontext* ctx, int windowWidth, int windowHeight, fl
 // Ends drawing flushing remaining render state.
 void nvgEndFrame(struct NVGcontext* ctx);
 
+struct NVGframeStats {
+	int drawCalls;
+	int fillTris;
+	int strokeTris;
+	int textTris;
+	int atlasUploads;		// Number of font atlas texture updates.
+	int atlasUploadBytes;	// Number of bytes passed to font atlas texture updates.
+	int renderDrawCalls;	// Number of draw calls the back-end issued in its last flush, 0 if it does not count them.
+};
+
+// Returns statistics of the frame since last call to nvgBeginFrame().
+// Call after nvgEndFrame() to include the font atlas upload done at the end of the frame.
+void nvgFrameStats(struct NVGcontext* ctx, struct NVGframeStats* stats);
+
 //
 // Color utils
 //
@@ -430,6 +444,36 @@ void nvgFill(struct NVGcontext* ctx);
 // Fills the current path with current stroke style.
 void nvgStroke(struct NVGcontext* ctx);
 
+//
+// Cached paths
+//
+// Static geometry such as panel backgrounds and icons can be captured once into a cached path.
+// The flattened points and the fill and stroke vertices are kept with the path, and are only
+// rebuilt when the transform, device pixel ratio, or stroke width, caps and joins change.
+//
+//		nvgBeginPath(vg);
+//		nvgRoundedRect(vg, 0,0, 100,30, 5);
+//		panel = nvgCreatePath(vg);
+//		...
+//		nvgFillPath(vg, panel);
+//
+// The path should be defined using the transform which is current when nvgCreatePath() is called,
+// later draws may use any transform. Drawing a cached path clears the current path.
+
+struct NVGcachedPath;
+
+// Captures the current path into a cached path. Returns NULL on failure.
+struct NVGcachedPath* nvgCreatePath(struct NVGcontext* ctx);
+
+// Deletes cached path.
+void nvgDeletePath(struct NVGcontext* ctx, struct NVGcachedPath* path);
+
+// Fills cached path with current fill style.
+void nvgFillPath(struct NVGcontext* ctx, struct NVGcachedPath* path);
+
+// Strokes cached path with current stroke style.
+void nvgStrokePath(struct NVGcontext* ctx, struct NVGcachedPath* path);
+
 
 //
 // Text
@@ -523,6 +567,23 @@ int nvgTextGlyphPositions(struct NVGcontext* ctx, float x, float y, const char*
 // Measured values are returned in local coordinate space.
 void nvgTextMetrics(struct NVGcontext* ctx, float* ascender, float* descender, float* lineh);
 
+// Rasterizes the glyphs of the string using current text style into the font atlas without drawing anything.
+// Can be used to stage the glyphs of the next frame ahead of time.
+void nvgTextPrepare(struct NVGcontext* ctx, const char* string, const char* end);
+
+// Uploads pending font atlas changes to the texture. With buffered back-ends the atlas is updated
+// once in nvgEndFrame(), this can be called after nvgTextPrepare() to upload the staged glyphs earlier.
+void nvgFlushTextTexture(struct NVGcontext* ctx);
+
+// Starts worker threads which rasterize new glyphs in the background. Text using glyphs which
+// are not ready yet is drawn without them, the glyphs appear within a frame or two.
+// Returns number of started workers, 0 if not supported.
+int nvgFontWorkers(struct NVGcontext* ctx, int threads);
+
+// Waits until the glyphs queued for the workers, e.g. by nvgTextPrepare(), are rasterized into the atlas.
+// Glyph sets can be prewarmed at startup by preparing them on the workers and waiting once.
+void nvgWaitTextPrepare(struct NVGcontext* ctx);
+
 // Breaks the specified text into lines. If end is specified only the sub-string will be used.
 // White space is stripped at the beginning of the rows, the text is split at word boundaries or when new-line characters are encountered.
 // Words longer than the max width are slit at nearest character (i.e. no hyphenation).
@@ -563,6 +624,7 @@ struct NVGparams {
 	void* userPtr;
 	int atlasWidth, atlasHeight;
 	int edgeAntiAlias;
+	int bufferedRender;	// Set if draw calls are buffered until renderFlush(), allows texture updates to be done once per frame.
 	int (*renderCreate)(void* uptr);
 	int (*renderCreateTexture)(void* uptr, int type, int w, int h, const unsigned char* data);
 	int (*renderDeleteTexture)(void* uptr, int image);
@@ -570,6 +632,7 @@ struct NVGparams {
 	int (*renderGetTextureSize)(void* uptr, int image, int* w, int* h);
 	void (*renderViewport)(void* uptr, int width, int height, int alphaBlend);
 	void (*renderFlush)(void* uptr, int alphaBlend);
+	int (*renderGetDrawCount)(void* uptr);	// Optional, number of draw calls in the last renderFlush().
 	void (*renderFill)(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe, const float* bounds, const struct NVGpath* paths, int npaths);
 	void (*renderStroke)(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe, float strokeWidth, const struct NVGpath* paths, int npaths);
 	void (*renderTriangles)(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, const struct NVGvertex* verts, int nverts);
@@ -580,6 +643,9 @@ struct NVGparams {
 struct NVGcontext* nvgCreateInternal(struct NVGparams* params);
 void nvgDeleteInternal(struct NVGcontext* ctx);
 
+// Returns the parameters the context was created with, used by back-ends to get back to their user pointer.
+struct NVGparams* nvgInternalParams(struct NVGcontext* ctx);
+
 // Debug function to dump cached path data.
 void nvgDebugDumpPathCache(struct NVGcontext* ctx);
 
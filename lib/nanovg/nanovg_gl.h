@@ -31,12 +31,25 @@ extern "C" {
 #  define NANOVG_GL3 1
 #  define NANOVG_GL_IMPLEMENTATION 1
 #  define NANOVG_GL_USE_UNIFORMBUFFER 1
+#  ifndef NANOVG_GL_NO_INDICES
+#    define NANOVG_GL_USE_INDICES 1
+#  endif
 #elif defined NANOVG_GLES2_IMPLEMENTATION
 #  define NANOVG_GLES2 1
 #  define NANOVG_GL_IMPLEMENTATION 1
 #elif defined NANOVG_GLES3_IMPLEMENTATION
 #  define NANOVG_GLES3 1
 #  define NANOVG_GL_IMPLEMENTATION 1
+#  ifndef NANOVG_GL_NO_INDICES
+#    define NANOVG_GL_USE_INDICES 1
+#  endif
+#endif
+
+// Stream vertex and uniform data through persistently mapped buffers when
+// the GL headers know about ARB_buffer_storage. Used only if the context
+// supports it, else the buffers are orphaned and updated each frame.
+#if defined NANOVG_GL3 && defined GL_MAP_PERSISTENT_BIT && !defined NANOVG_GL_NO_PERSISTENT_MAP
+#  define NANOVG_GL_USE_PERSISTENT_MAP 1
 #endif
 	
 
@@ -141,6 +154,8 @@ struct GLNVGcall {
 	int pathCount;
 	int triangleOffset;
 	int triangleCount;
+	int indexOffset;
+	int indexCount;
 	int uniformOffset;
 };
 
@@ -166,6 +181,23 @@ struct GLNVGfragUniforms {
    int type;
 };
 
+// Number of frames worth of data in the stream buffers, so that CPU can
+// write new frame while GPU is still reading the previous ones.
+#define GLNVG_RING_SECTIONS 3
+
+struct GLNVGring {
+	GLuint buf;
+	GLenum target;
+	int size;		// Size of one section in bytes.
+	int align;
+	int section;
+	int persistent;
+	unsigned char* mapped;
+#if NANOVG_GL_USE_PERSISTENT_MAP
+	GLsync fences[GLNVG_RING_SECTIONS];
+#endif
+};
+
 struct GLNVGcontext {
 	struct GLNVGshader shader;
 	struct GLNVGtexture* textures;
@@ -173,16 +205,25 @@ struct GLNVGcontext {
 	int ntextures;
 	int ctextures;
 	int textureId;
-	GLuint vertBuf;
+	struct GLNVGring vertRing;
 #if defined NANOVG_GL3
 	GLuint vertArr;
 #endif
 #if NANOVG_GL_USE_UNIFORMBUFFER
 	GLuint viewBuf;
-	GLuint fragBuf;
+	struct GLNVGring fragRing;
+#endif
+#if NANOVG_GL_USE_INDICES
+	struct GLNVGring indexRing;
 #endif
 	int fragSize;
 	int edgeAntiAlias;
+	int boundUniformOffset;
+	int boundImage;
+	int drawCount;		// Number of glDraw* calls in the last flush.
+	int vertBase;
+	int fragBase;
+	int indexBase;
 
 	// Per frame buffers
 	struct GLNVGcall* calls;
@@ -197,6 +238,9 @@ struct GLNVGcontext {
 	unsigned char* uniforms;
 	int cuniforms;
 	int nuniforms;
+	GLuint* indices;
+	int cindices;
+	int nindices;
 };
 
 
@@ -364,10 +408,159 @@ static void glnvg__getUniforms(struct GLNVGshader* shader)
 #endif
 }
 
+#if NANOVG_GL_USE_PERSISTENT_MAP
+static int glnvg__hasBufferStorage()
+{
+	GLint major = 0, minor = 0, n = 0, i;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if (major > 4 || (major == 4 && minor >= 4))
+		return 1;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &n);
+	for (i = 0; i < n; i++) {
+		const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (ext != NULL && strcmp(ext, "GL_ARB_buffer_storage") == 0)
+			return 1;
+	}
+	return 0;
+}
+#endif
+
+static int glnvg__maxi(int a, int b) { return a > b ? a : b; }
+
+static void glnvg__initRing(struct GLNVGring* ring, GLenum target, int align, int persistent)
+{
+	memset(ring, 0, sizeof(*ring));
+	ring->target = target;
+	ring->align = align;
+	ring->persistent = persistent;
+	glGenBuffers(1, &ring->buf);
+}
+
+static void glnvg__deleteRing(struct GLNVGring* ring)
+{
+#if NANOVG_GL_USE_PERSISTENT_MAP
+	int i;
+	for (i = 0; i < GLNVG_RING_SECTIONS; i++) {
+		if (ring->fences[i] != NULL)
+			glDeleteSync(ring->fences[i]);
+		ring->fences[i] = NULL;
+	}
+#endif
+	// Deleting the buffer also unmaps it.
+	if (ring->buf != 0)
+		glDeleteBuffers(1, &ring->buf);
+	ring->buf = 0;
+	ring->mapped = NULL;
+}
+
+static void glnvg__resetRing(struct GLNVGring* ring, int persistent)
+{
+	GLenum target = ring->target;
+	int align = ring->align;
+	glnvg__deleteRing(ring);
+	glnvg__initRing(ring, target, align, persistent);
+}
+
+static unsigned char* glnvg__ringPtr(struct GLNVGring* ring)
+{
+	return ring->mapped != NULL ? ring->mapped + ring->section * ring->size : NULL;
+}
+
+// Makes sure that current section can hold 'bytes'. Persistent buffers are
+// immutable, so growing them creates new storage, the first 'keep' bytes of
+// current section are copied over.
+static int glnvg__reserveRing(struct GLNVGring* ring, int bytes, int keep)
+{
+	int size;
+	if (bytes <= ring->size)
+		return 1;
+	size = glnvg__maxi(bytes, ring->size * 2);
+	size = (size + ring->align-1) / ring->align * ring->align;
+
+#if NANOVG_GL_USE_PERSISTENT_MAP
+	if (ring->persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLuint buf = 0;
+		unsigned char* mapped = NULL;
+
+		// Use a neutral target, so that user's vertex array state is not touched.
+		glGenBuffers(1, &buf);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buf);
+		glBufferStorage(GL_COPY_WRITE_BUFFER, (GLsizeiptr)size * GLNVG_RING_SECTIONS, NULL, flags);
+		mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)size * GLNVG_RING_SECTIONS, flags);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		if (mapped == NULL) {
+			glDeleteBuffers(1, &buf);
+			return 0;
+		}
+		if (keep > 0)
+			memcpy(mapped, glnvg__ringPtr(ring), keep);
+
+		// GL keeps the old storage alive until pending draws are done.
+		glnvg__deleteRing(ring);
+		ring->buf = buf;
+		ring->mapped = mapped;
+		ring->section = 0;
+	}
+#else
+	NVG_NOTUSED(keep);
+#endif
+	ring->size = size;
+	return 1;
+}
+
+// Uploads data for the frame to current section and binds the buffer.
+// Returns offset of the data within the buffer.
+static int glnvg__uploadRing(struct GLNVGring* ring, const void* data, int bytes)
+{
+	unsigned char* dst;
+	if (!glnvg__reserveRing(ring, bytes, 0)) {
+		// Could not map, fall back to updating the buffer.
+		glnvg__resetRing(ring, 0);
+		glnvg__reserveRing(ring, bytes, 0);
+	}
+	glBindBuffer(ring->target, ring->buf);
+	dst = glnvg__ringPtr(ring);
+	if (dst != NULL) {
+		if (dst != data && bytes > 0)
+			memcpy(dst, data, bytes);
+		return ring->section * ring->size;
+	}
+	// Orphan the previous storage, the size stays the same from frame to
+	// frame so that the driver can recycle the allocations.
+	glBufferData(ring->target, ring->size, NULL, GL_STREAM_DRAW);
+	if (bytes > 0)
+		glBufferSubData(ring->target, 0, bytes, data);
+	return 0;
+}
+
+// Marks current section used by the submitted draws and moves to next one,
+// waiting for the GPU to finish with it, if needed.
+static void glnvg__advanceRing(struct GLNVGring* ring)
+{
+#if NANOVG_GL_USE_PERSISTENT_MAP
+	GLsync fence;
+	if (ring->mapped == NULL)
+		return;
+	ring->fences[ring->section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	ring->section = (ring->section+1) % GLNVG_RING_SECTIONS;
+	fence = ring->fences[ring->section];
+	if (fence != NULL) {
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+			;
+		glDeleteSync(fence);
+		ring->fences[ring->section] = NULL;
+	}
+#else
+	NVG_NOTUSED(ring);
+#endif
+}
+
 static int glnvg__renderCreate(void* uptr)
 {
 	struct GLNVGcontext* gl = (struct GLNVGcontext*)uptr;
-	int align = 4;
+	int align = 4, persistent = 0;
 
 	// TODO: mediump float may not be enough for GLES2 in iOS.
 	// see the following discussion: https://github.com/memononen/nanovg/issues/46
@@ -552,17 +745,25 @@ static int glnvg__renderCreate(void* uptr)
 #if defined NANOVG_GL3
 	glGenVertexArrays(1, &gl->vertArr);
 #endif
-	glGenBuffers(1, &gl->vertBuf);
+#if NANOVG_GL_USE_PERSISTENT_MAP
+	persistent = glnvg__hasBufferStorage();
+#endif
+	glnvg__initRing(&gl->vertRing, GL_ARRAY_BUFFER, sizeof(struct NVGvertex), persistent);
+#if NANOVG_GL_USE_INDICES
+	glnvg__initRing(&gl->indexRing, GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint), persistent);
+#endif
 
 #if NANOVG_GL_USE_UNIFORMBUFFER
 	// Create UBOs
 	glUniformBlockBinding(gl->shader.prog, gl->shader.loc[GLNVG_LOC_VIEW], GLNVG_VIEW_BINDING);
 	glGenBuffers(1, &gl->viewBuf); 
 	glUniformBlockBinding(gl->shader.prog, gl->shader.loc[GLNVG_LOC_FRAG], GLNVG_FRAG_BINDING);
-	glGenBuffers(1, &gl->fragBuf); 
 	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
 #endif
 	gl->fragSize = sizeof(struct GLNVGfragUniforms) + align - sizeof(struct GLNVGfragUniforms) % align;
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	glnvg__initRing(&gl->fragRing, GL_UNIFORM_BUFFER, gl->fragSize, persistent);
+#endif
 
 	glnvg__checkError("create done");
 
@@ -762,8 +963,14 @@ static void glnvg__mat3(float* dst, float* src)
 
 static void glnvg__setUniforms(struct GLNVGcontext* gl, int uniformOffset, int image)
 {
+	// Consecutive calls with same paint share the uniforms, skip rebinding.
+	if (uniformOffset == gl->boundUniformOffset && image == gl->boundImage)
+		return;
+	gl->boundUniformOffset = uniformOffset;
+	gl->boundImage = image;
+
 #if NANOVG_GL_USE_UNIFORMBUFFER
-	glBindBufferRange(GL_UNIFORM_BUFFER, GLNVG_FRAG_BINDING, gl->fragBuf, uniformOffset, sizeof(struct GLNVGfragUniforms));
+	glBindBufferRange(GL_UNIFORM_BUFFER, GLNVG_FRAG_BINDING, gl->fragRing.buf, gl->fragBase + uniformOffset, sizeof(struct GLNVGfragUniforms));
 #else
 	struct GLNVGfragUniforms* frag = nvg__fragUniformPtr(gl, uniformOffset);
 	float tmp[9]; // Maybe there's a way to get rid of this...
@@ -822,6 +1029,7 @@ static void glnvg__fill(struct GLNVGcontext* gl, struct GLNVGcall* call)
 	for (i = 0; i < npaths; i++)
 		glDrawArrays(GL_TRIANGLE_FAN, paths[i].fillOffset, paths[i].fillCount);
 	glEnable(GL_CULL_FACE);
+	gl->drawCount += npaths;
 
 	// Draw aliased off-pixels
 	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
@@ -836,16 +1044,37 @@ static void glnvg__fill(struct GLNVGcontext* gl, struct GLNVGcall* call)
 		// Draw fringes
 		for (i = 0; i < npaths; i++)
 			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		gl->drawCount += npaths;
 	}
 
 	// Draw fill
 	glStencilFunc(GL_NOTEQUAL, 0x0, 0xff);
 	glStencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
 	glDrawArrays(GL_TRIANGLES, call->triangleOffset, call->triangleCount);
+	gl->drawCount++;
 
 	glDisable(GL_STENCIL_TEST);
 }
 
+#if NANOVG_GL_USE_INDICES
+static int glnvg__canMerge(const struct GLNVGcall* a, const struct GLNVGcall* b)
+{
+	// Stencil fills need their own state changes, everything else is plain
+	// triangles and can be drawn together as long as the paint is the same.
+	if (a->type == GLNVG_FILL || b->type == GLNVG_FILL)
+		return 0;
+	return a->uniformOffset == b->uniformOffset && a->image == b->image;
+}
+
+static void glnvg__elements(struct GLNVGcontext* gl, struct GLNVGcall* call, int count)
+{
+	glnvg__setUniforms(gl, call->uniformOffset, call->image);
+	glnvg__checkError("elements fill");
+
+	glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (const GLvoid*)(gl->indexBase + call->indexOffset * sizeof(GLuint)));
+	gl->drawCount++;
+}
+#else
 static void glnvg__convexFill(struct GLNVGcontext* gl, struct GLNVGcall* call)
 {
 	struct GLNVGpath* paths = &gl->paths[call->pathOffset];
@@ -856,10 +1085,12 @@ static void glnvg__convexFill(struct GLNVGcontext* gl, struct GLNVGcall* call)
 
 	for (i = 0; i < npaths; i++)
 		glDrawArrays(GL_TRIANGLE_FAN, paths[i].fillOffset, paths[i].fillCount);
+	gl->drawCount += npaths;
 	if (gl->edgeAntiAlias) {
 		// Draw fringes
 		for (i = 0; i < npaths; i++)
 			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		gl->drawCount += npaths;
 	}
 }
 
@@ -874,6 +1105,7 @@ static void glnvg__stroke(struct GLNVGcontext* gl, struct GLNVGcall* call)
 	// Draw Strokes
 	for (i = 0; i < npaths; i++)
 		glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+	gl->drawCount += npaths;
 }
 
 static void glnvg__triangles(struct GLNVGcontext* gl, struct GLNVGcall* call)
@@ -882,13 +1114,17 @@ static void glnvg__triangles(struct GLNVGcontext* gl, struct GLNVGcall* call)
 	glnvg__checkError("triangles fill");
 
 	glDrawArrays(GL_TRIANGLES, call->triangleOffset, call->triangleCount);
+	gl->drawCount++;
 }
+#endif
 
 static void glnvg__renderFlush(void* uptr, int alphaBlend)
 {
 	struct GLNVGcontext* gl = (struct GLNVGcontext*)uptr;
 	int i;
 
+	gl->drawCount = 0;
+
 	if (gl->ncalls > 0) {
 
 		// Setup require GL state.
@@ -908,24 +1144,27 @@ static void glnvg__renderFlush(void* uptr, int alphaBlend)
 		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 		glStencilFunc(GL_ALWAYS, 0, 0xffffffff);
 		glActiveTexture(GL_TEXTURE0);
+		gl->boundUniformOffset = -1;
+		gl->boundImage = -1;
 
 #if NANOVG_GL_USE_UNIFORMBUFFER
 		// Upload ubo for frag shaders
-		glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf);
-		glBufferData(GL_UNIFORM_BUFFER, gl->nuniforms * gl->fragSize, gl->uniforms, GL_STREAM_DRAW);
+		gl->fragBase = glnvg__uploadRing(&gl->fragRing, gl->uniforms, gl->nuniforms * gl->fragSize);
 #endif
 
-		// Upload vertex data
+		// Upload vertex data, with persistent mapping it is already in place.
 #if defined NANOVG_GL3
 		glBindVertexArray(gl->vertArr);
 #endif
-		glBindBuffer(GL_ARRAY_BUFFER, gl->vertBuf);
-		glBufferData(GL_ARRAY_BUFFER, gl->nverts * sizeof(struct NVGvertex), gl->verts, GL_STREAM_DRAW);
+		gl->vertBase = glnvg__uploadRing(&gl->vertRing, gl->verts, gl->nverts * sizeof(struct NVGvertex));
 		glEnableVertexAttribArray(0);
 		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(struct NVGvertex), (const GLvoid*)(size_t)0);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(struct NVGvertex), (const GLvoid*)(0 + 2*sizeof(float)));
-		
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(struct NVGvertex), (const GLvoid*)(size_t)gl->vertBase);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(struct NVGvertex), (const GLvoid*)(gl->vertBase + 2*sizeof(float)));
+#if NANOVG_GL_USE_INDICES
+		gl->indexBase = glnvg__uploadRing(&gl->indexRing, gl->indices, gl->nindices * sizeof(GLuint));
+#endif
+
 #if NANOVG_GL_USE_UNIFORMBUFFER
 		// once per frame set ubo for view
 		glBindBuffer(GL_UNIFORM_BUFFER, gl->viewBuf);
@@ -933,7 +1172,7 @@ static void glnvg__renderFlush(void* uptr, int alphaBlend)
 		glBufferData(GL_UNIFORM_BUFFER, sizeof(gl->view), gl->view, GL_STREAM_DRAW);
 		glBindBufferBase(GL_UNIFORM_BUFFER, GLNVG_VIEW_BINDING, gl->viewBuf);
 
-		glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf);
+		glBindBuffer(GL_UNIFORM_BUFFER, gl->fragRing.buf);
 #else
 		glUniform1i(gl->shader.loc[GLNVG_LOC_TEX], 0);
 		glUniform2fv(gl->shader.loc[GLNVG_LOC_VIEWSIZE], 1, gl->view);
@@ -941,6 +1180,19 @@ static void glnvg__renderFlush(void* uptr, int alphaBlend)
 
 		for (i = 0; i < gl->ncalls; i++) {
 			struct GLNVGcall* call = &gl->calls[i];
+#if NANOVG_GL_USE_INDICES
+			if (call->type == GLNVG_FILL) {
+				glnvg__fill(gl, call);
+			} else {
+				// Index ranges of consecutive calls are adjacent, draw runs
+				// of calls with same paint in one go. Order is unchanged.
+				int count = call->indexCount;
+				while (i+1 < gl->ncalls && glnvg__canMerge(call, &gl->calls[i+1]))
+					count += gl->calls[++i].indexCount;
+				if (count > 0)
+					glnvg__elements(gl, call, count);
+			}
+#else
 			if (call->type == GLNVG_FILL)
 				glnvg__fill(gl, call);
 			else if (call->type == GLNVG_CONVEXFILL)
@@ -949,15 +1201,30 @@ static void glnvg__renderFlush(void* uptr, int alphaBlend)
 				glnvg__stroke(gl, call);
 			else if (call->type == GLNVG_TRIANGLES)
 				glnvg__triangles(gl, call);
+#endif
 		}
 
 		glDisableVertexAttribArray(0);
 		glDisableVertexAttribArray(1);
 #if defined NANOVG_GL3
 		glBindVertexArray(0);
+#endif
+#if NANOVG_GL_USE_INDICES
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 #endif
 		glUseProgram(0);
 		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glnvg__advanceRing(&gl->vertRing);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+		glnvg__advanceRing(&gl->fragRing);
+#endif
+#if NANOVG_GL_USE_INDICES
+		glnvg__advanceRing(&gl->indexRing);
+#endif
+		// Next frame writes its vertices directly to the next section.
+		if (gl->vertRing.mapped != NULL)
+			gl->verts = (struct NVGvertex*)glnvg__ringPtr(&gl->vertRing);
 	}
 
 	// Reset calls
@@ -965,6 +1232,13 @@ static void glnvg__renderFlush(void* uptr, int alphaBlend)
 	gl->npaths = 0;
 	gl->ncalls = 0;
 	gl->nuniforms = 0;
+	gl->nindices = 0;
+}
+
+static int glnvg__renderGetDrawCount(void* uptr)
+{
+	struct GLNVGcontext* gl = (struct GLNVGcontext*)uptr;
+	return gl->drawCount;
 }
 
 static int glnvg__maxVertCount(const struct NVGpath* paths, int npaths)
@@ -977,8 +1251,6 @@ static int glnvg__maxVertCount(const struct NVGpath* paths, int npaths)
 	return count;
 }
 
-static int glnvg__maxi(int a, int b) { return a > b ? a : b; }
-
 static struct GLNVGcall* glnvg__allocCall(struct GLNVGcontext* gl)
 {
 	struct GLNVGcall* ret = NULL;
@@ -1007,8 +1279,25 @@ static int glnvg__allocVerts(struct GLNVGcontext* gl, int n)
 {
 	int ret = 0;
 	if (gl->nverts+n > gl->cverts) {
-		gl->cverts = gl->cverts == 0 ? glnvg__maxi(n, 256) : gl->cverts * 2;
-		gl->verts = (struct NVGvertex*)realloc(gl->verts, sizeof(struct NVGvertex) * gl->cverts);
+		struct NVGvertex* verts = NULL;
+		int cverts = gl->cverts == 0 ? glnvg__maxi(n, 256) : glnvg__maxi(gl->nverts+n, gl->cverts * 2);
+		if (gl->vertRing.persistent) {
+			// Write vertices directly to the GPU visible buffer.
+			if (glnvg__reserveRing(&gl->vertRing, cverts * sizeof(struct NVGvertex), gl->nverts * sizeof(struct NVGvertex))) {
+				verts = (struct NVGvertex*)glnvg__ringPtr(&gl->vertRing);
+				cverts = gl->vertRing.size / sizeof(struct NVGvertex);
+			} else {
+				// Could not map, continue with client memory.
+				verts = (struct NVGvertex*)malloc(sizeof(struct NVGvertex) * cverts);
+				if (verts != NULL && gl->nverts > 0)
+					memcpy(verts, gl->verts, sizeof(struct NVGvertex) * gl->nverts);
+				glnvg__resetRing(&gl->vertRing, 0);
+			}
+		} else {
+			verts = (struct NVGvertex*)realloc(gl->verts, sizeof(struct NVGvertex) * cverts);
+		}
+		gl->verts = verts;
+		gl->cverts = cverts;
 	}
 	ret = gl->nverts;
 	gl->nverts += n;
@@ -1032,6 +1321,97 @@ static struct GLNVGfragUniforms* nvg__fragUniformPtr(struct GLNVGcontext* gl, in
 	return (struct GLNVGfragUniforms*)&gl->uniforms[i];
 }
 
+static int glnvg__dedupFragUniforms(struct GLNVGcontext* gl, int offset)
+{
+	// If the uniforms just allocated at 'offset' match the previous ones,
+	// release them and return the offset of the previous, else 'offset'.
+	int prev = offset - gl->fragSize;
+	if (prev < 0 || offset != (gl->nuniforms-1) * gl->fragSize)
+		return offset;
+	if (memcmp(nvg__fragUniformPtr(gl, prev), nvg__fragUniformPtr(gl, offset), sizeof(struct GLNVGfragUniforms)) != 0)
+		return offset;
+	gl->nuniforms--;
+	return prev;
+}
+
+#if NANOVG_GL_USE_INDICES
+static int glnvg__allocIndices(struct GLNVGcontext* gl, int n)
+{
+	int ret = 0;
+	if (gl->nindices+n > gl->cindices) {
+		gl->cindices = gl->cindices == 0 ? glnvg__maxi(n, 1024) : glnvg__maxi(gl->nindices+n, gl->cindices * 2);
+		gl->indices = (GLuint*)realloc(gl->indices, sizeof(GLuint) * gl->cindices);
+	}
+	ret = gl->nindices;
+	gl->nindices += n;
+	return ret;
+}
+
+static int glnvg__triCount(int n) { return n > 2 ? n-2 : 0; }
+
+// Fans and strips are converted to triangle lists with the same vertex
+// order GL would use, so that winding and rasterization stay identical.
+static GLuint* glnvg__fanIndices(GLuint* dst, int offset, int count)
+{
+	int i;
+	for (i = 2; i < count; i++) {
+		*dst++ = (GLuint)offset;
+		*dst++ = (GLuint)(offset+i-1);
+		*dst++ = (GLuint)(offset+i);
+	}
+	return dst;
+}
+
+static GLuint* glnvg__stripIndices(GLuint* dst, int offset, int count)
+{
+	int i;
+	for (i = 2; i < count; i++) {
+		if (i & 1) {
+			*dst++ = (GLuint)(offset+i-1);
+			*dst++ = (GLuint)(offset+i-2);
+		} else {
+			*dst++ = (GLuint)(offset+i-2);
+			*dst++ = (GLuint)(offset+i-1);
+		}
+		*dst++ = (GLuint)(offset+i);
+	}
+	return dst;
+}
+
+static void glnvg__listIndices(struct GLNVGcontext* gl, struct GLNVGcall* call)
+{
+	int i;
+	call->indexOffset = glnvg__allocIndices(gl, call->triangleCount);
+	call->indexCount = call->triangleCount;
+	for (i = 0; i < call->triangleCount; i++)
+		gl->indices[call->indexOffset + i] = (GLuint)(call->triangleOffset + i);
+}
+
+static void glnvg__pathIndices(struct GLNVGcontext* gl, struct GLNVGcall* call, int fans, int strips)
+{
+	struct GLNVGpath* paths = &gl->paths[call->pathOffset];
+	int i, n = 0;
+	GLuint* dst;
+
+	for (i = 0; i < call->pathCount; i++) {
+		if (fans) n += glnvg__triCount(paths[i].fillCount);
+		if (strips) n += glnvg__triCount(paths[i].strokeCount);
+	}
+	call->indexOffset = glnvg__allocIndices(gl, n*3);
+	call->indexCount = n*3;
+
+	dst = &gl->indices[call->indexOffset];
+	if (fans) {
+		for (i = 0; i < call->pathCount; i++)
+			dst = glnvg__fanIndices(dst, paths[i].fillOffset, paths[i].fillCount);
+	}
+	if (strips) {
+		for (i = 0; i < call->pathCount; i++)
+			dst = glnvg__stripIndices(dst, paths[i].strokeOffset, paths[i].strokeCount);
+	}
+}
+#endif
+
 static void glnvg__vset(struct NVGvertex* vtx, float x, float y, float u, float v)
 {
 	vtx->x = x;
@@ -1104,6 +1484,10 @@ static void glnvg__renderFill(void* uptr, struct NVGpaint* paint, struct NVGscis
 		call->uniformOffset = glnvg__allocFragUniforms(gl, 1);
 		// Fill shader
 		glnvg__convertPaint(gl, nvg__fragUniformPtr(gl, call->uniformOffset), paint, scissor, fringe, fringe);
+		call->uniformOffset = glnvg__dedupFragUniforms(gl, call->uniformOffset);
+#if NANOVG_GL_USE_INDICES
+		glnvg__pathIndices(gl, call, 1, gl->edgeAntiAlias);
+#endif
 	}
 }
 
@@ -1138,6 +1522,10 @@ static void glnvg__renderStroke(void* uptr, struct NVGpaint* paint, struct NVGsc
 	// Fill shader
 	call->uniformOffset = glnvg__allocFragUniforms(gl, 1);
 	glnvg__convertPaint(gl, nvg__fragUniformPtr(gl, call->uniformOffset), paint, scissor, strokeWidth, fringe);
+	call->uniformOffset = glnvg__dedupFragUniforms(gl, call->uniformOffset);
+#if NANOVG_GL_USE_INDICES
+	glnvg__pathIndices(gl, call, 0, 1);
+#endif
 }
 
 static void glnvg__renderTriangles(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor,
@@ -1160,6 +1548,10 @@ static void glnvg__renderTriangles(void* uptr, struct NVGpaint* paint, struct NV
 	frag = nvg__fragUniformPtr(gl, call->uniformOffset);
 	glnvg__convertPaint(gl, frag, paint, scissor, 1.0f, 1.0f);
 	frag->type = NSVG_SHADER_IMG;
+	call->uniformOffset = glnvg__dedupFragUniforms(gl, call->uniformOffset);
+#if NANOVG_GL_USE_INDICES
+	glnvg__listIndices(gl, call);
+#endif
 }
 
 static void glnvg__renderDelete(void* uptr)
@@ -1174,14 +1566,17 @@ static void glnvg__renderDelete(void* uptr)
 #if NANOVG_GL_USE_UNIFORMBUFFER
 	if (gl->viewBuf != 0)
 		glDeleteBuffers(1, &gl->viewBuf); 
-	if (gl->fragBuf != 0)
-		glDeleteBuffers(1, &gl->fragBuf);
+	glnvg__deleteRing(&gl->fragRing);
 #endif
 	if (gl->vertArr != 0)
 		glDeleteVertexArrays(1, &gl->vertArr);
 #endif
-	if (gl->vertBuf != 0)
-		glDeleteBuffers(1, &gl->vertBuf);
+	if (gl->vertRing.mapped == NULL)
+		free(gl->verts);
+	glnvg__deleteRing(&gl->vertRing);
+#if NANOVG_GL_USE_INDICES
+	glnvg__deleteRing(&gl->indexRing);
+#endif
 
 	for (i = 0; i < gl->ntextures; i++) {
 		if (gl->textures[i].tex != 0)
@@ -1189,6 +1584,11 @@ static void glnvg__renderDelete(void* uptr)
 	}
 	free(gl->textures);
 
+	free(gl->calls);
+	free(gl->paths);
+	free(gl->uniforms);
+	free(gl->indices);
+
 	free(gl);
 }
 
@@ -1217,6 +1617,7 @@ struct NVGcontext* nvgCreateGLES3(int atlasw, int atlash, int edgeaa)
 	params.renderGetTextureSize = glnvg__renderGetTextureSize;
 	params.renderViewport = glnvg__renderViewport;
 	params.renderFlush = glnvg__renderFlush;
+	params.renderGetDrawCount = glnvg__renderGetDrawCount;
 	params.renderFill = glnvg__renderFill;
 	params.renderStroke = glnvg__renderStroke;
 	params.renderTriangles = glnvg__renderTriangles;
@@ -1225,6 +1626,7 @@ struct NVGcontext* nvgCreateGLES3(int atlasw, int atlash, int edgeaa)
 	params.atlasWidth = atlasw;
 	params.atlasHeight = atlash;
 	params.edgeAntiAlias = edgeaa;
+	params.bufferedRender = 1;
 
 	gl->edgeAntiAlias = edgeaa;
 
@@ -0,0 +1,687 @@
+//
+// Copyright (c) 2009-2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+#ifndef NANOVG_REC_H
+#define NANOVG_REC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Recording back-end, writes every render call into a binary stream which
+// can later be replayed into any other back-end.
+// Recorded are texture create/update/delete calls, viewports, fills and strokes
+// with their vertices, triangle batches, paints and scissors. Each renderFlush()
+// ends a frame. The stream uses the byte order of the recording machine.
+//
+// The recorder can forward the calls to the back-end of another context,
+// so that production frames can be captured while they are rendered:
+//
+//		glvg = nvgCreateGL2(512, 512, NVG_ANTIALIAS);
+//		vg = nvgCreateRec("capture.nvgr", 512, 512, 1, glvg);
+//		... draw using vg ...
+//		nvgDeleteRec(vg);
+//		nvgDeleteGL2(glvg);
+//
+// And later:
+//
+//		vg = nvgCreateSW(512, 512, 1, 4);
+//		nvgReplayRec(vg, "capture.nvgr", frameDone, NULL);
+
+// Creates new recording context writing to 'filename'. If 'forward' is not NULL,
+// the render calls are passed on to its back-end too, and 'forward' must outlive the recorder.
+struct NVGcontext* nvgCreateRec(const char* filename, int atlasw, int atlash, int edgeaa, struct NVGcontext* forward);
+void nvgDeleteRec(struct NVGcontext* ctx);
+
+// Replays recorded stream into the back-end of 'target'. 'frameCallback' (can be NULL) is called
+// after each frame has been flushed. Returns number of frames replayed, or -1 on error.
+int nvgReplayRec(struct NVGcontext* target, const char* filename, void (*frameCallback)(void* uptr, int frame), void* uptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#ifdef NANOVG_REC_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "nanovg.h"
+
+#define RECNVG_MAGIC 0x5247564e	// 'NVGR'
+#define RECNVG_VERSION 1
+
+// Every record starts with the op, all values are 32 bits and
+// byte data is padded to 4 bytes so that vertices can be used in place on replay.
+enum RECNVGop {
+	RECNVG_CREATE_TEXTURE = 1,
+	RECNVG_DELETE_TEXTURE,
+	RECNVG_UPDATE_TEXTURE,
+	RECNVG_VIEWPORT,
+	RECNVG_FLUSH,
+	RECNVG_FILL,
+	RECNVG_STROKE,
+	RECNVG_TRIANGLES,
+};
+
+struct RECNVGtexture {
+	int id;
+	int width, height;
+	int type;
+	int image;				// Replay only, texture created in the target back-end.
+	unsigned char* data;	// Replay only, back-ends expect the whole image on update.
+};
+
+struct RECNVGcontext {
+	FILE* fp;
+	int error;
+	struct NVGparams forward;
+	int hasForward;
+	struct RECNVGtexture* textures;
+	int ntextures;
+	int ctextures;
+	int textureId;
+};
+
+static int recnvg__bpp(int type)
+{
+	return type == NVG_TEXTURE_RGBA ? 4 : 1;
+}
+
+static struct RECNVGtexture* recnvg__addTexture(struct RECNVGtexture** textures, int* ntextures, int* ctextures)
+{
+	struct RECNVGtexture* tex = NULL;
+	int i;
+
+	for (i = 0; i < *ntextures; i++) {
+		if ((*textures)[i].id == 0) {
+			tex = &(*textures)[i];
+			break;
+		}
+	}
+	if (tex == NULL) {
+		if (*ntextures+1 > *ctextures) {
+			struct RECNVGtexture* ntex;
+			int cap = (*ctextures == 0) ? 4 : *ctextures*2;
+			ntex = (struct RECNVGtexture*)realloc(*textures, sizeof(struct RECNVGtexture)*cap);
+			if (ntex == NULL) return NULL;
+			*textures = ntex;
+			*ctextures = cap;
+		}
+		tex = &(*textures)[(*ntextures)++];
+	}
+	memset(tex, 0, sizeof(*tex));
+	return tex;
+}
+
+static struct RECNVGtexture* recnvg__findTexture(struct RECNVGtexture* textures, int ntextures, int id)
+{
+	int i;
+	if (id == 0) return NULL;	// Free slot.
+	for (i = 0; i < ntextures; i++)
+		if (textures[i].id == id)
+			return &textures[i];
+	return NULL;
+}
+
+//
+// Recording
+//
+
+static void recnvg__write(struct RECNVGcontext* rec, const void* data, int size)
+{
+	static const unsigned char pad[4] = {0,0,0,0};
+	if (rec->error || size == 0) return;
+	if (fwrite(data, size, 1, rec->fp) != 1) rec->error = 1;
+	if ((size & 3) != 0 && fwrite(pad, 4 - (size & 3), 1, rec->fp) != 1) rec->error = 1;
+}
+
+static void recnvg__writeInt(struct RECNVGcontext* rec, int v)
+{
+	recnvg__write(rec, &v, sizeof(int));
+}
+
+static void recnvg__writeFloat(struct RECNVGcontext* rec, float v)
+{
+	recnvg__write(rec, &v, sizeof(float));
+}
+
+static void recnvg__writePaint(struct RECNVGcontext* rec, const struct NVGpaint* paint, const struct NVGscissor* scissor)
+{
+	recnvg__write(rec, paint->xform, sizeof(float)*6);
+	recnvg__write(rec, paint->extent, sizeof(float)*2);
+	recnvg__writeFloat(rec, paint->radius);
+	recnvg__writeFloat(rec, paint->feather);
+	recnvg__write(rec, paint->innerColor.rgba, sizeof(float)*4);
+	recnvg__write(rec, paint->outerColor.rgba, sizeof(float)*4);
+	recnvg__writeInt(rec, paint->image);
+	recnvg__writeInt(rec, paint->repeat);
+	recnvg__write(rec, scissor->xform, sizeof(float)*6);
+	recnvg__write(rec, scissor->extent, sizeof(float)*2);
+}
+
+static void recnvg__writePaths(struct RECNVGcontext* rec, const struct NVGpath* paths, int npaths, int fill)
+{
+	int i;
+	recnvg__writeInt(rec, npaths);
+	for (i = 0; i < npaths; i++) {
+		const struct NVGpath* path = &paths[i];
+		int nfill = fill ? path->nfill : 0;
+		recnvg__writeInt(rec, nfill);
+		recnvg__writeInt(rec, path->nstroke);
+		recnvg__writeInt(rec, path->closed);
+		recnvg__writeInt(rec, path->nbevel);
+		recnvg__writeInt(rec, path->winding);
+		recnvg__writeInt(rec, path->convex);
+		recnvg__write(rec, path->fill, sizeof(struct NVGvertex)*nfill);
+		recnvg__write(rec, path->stroke, sizeof(struct NVGvertex)*path->nstroke);
+	}
+}
+
+static int recnvg__renderCreate(void* uptr)
+{
+	// The forwarded back-end was created with its own context.
+	NVG_NOTUSED(uptr);
+	return 1;
+}
+
+static int recnvg__renderCreateTexture(void* uptr, int type, int w, int h, const unsigned char* data)
+{
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)uptr;
+	struct RECNVGtexture* tex;
+	int id;
+
+	if (rec->hasForward)
+		id = rec->forward.renderCreateTexture(rec->forward.userPtr, type, w, h, data);
+	else
+		id = ++rec->textureId;
+	if (id == 0) return 0;
+
+	tex = recnvg__addTexture(&rec->textures, &rec->ntextures, &rec->ctextures);
+	if (tex == NULL) return 0;
+	tex->id = id;
+	tex->width = w;
+	tex->height = h;
+	tex->type = type;
+
+	recnvg__writeInt(rec, RECNVG_CREATE_TEXTURE);
+	recnvg__writeInt(rec, id);
+	recnvg__writeInt(rec, type);
+	recnvg__writeInt(rec, w);
+	recnvg__writeInt(rec, h);
+	recnvg__writeInt(rec, data != NULL);
+	if (data != NULL)
+		recnvg__write(rec, data, w*h*recnvg__bpp(type));
+
+	return id;
+}
+
+static int recnvg__renderDeleteTexture(void* uptr, int image)
+{
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)uptr;
+	struct RECNVGtexture* tex = recnvg__findTexture(rec->textures, rec->ntextures, image);
+	if (tex == NULL) return 0;
+	tex->id = 0;
+
+	recnvg__writeInt(rec, RECNVG_DELETE_TEXTURE);
+	recnvg__writeInt(rec, image);
+
+	if (rec->hasForward)
+		return rec->forward.renderDeleteTexture(rec->forward.userPtr, image);
+	return 1;
+}
+
+static int recnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)uptr;
+	struct RECNVGtexture* tex = recnvg__findTexture(rec->textures, rec->ntextures, image);
+	int i, bpp;
+	if (tex == NULL) return 0;
+	bpp = recnvg__bpp(tex->type);
+
+	// Only the updated rectangle is stored.
+	recnvg__writeInt(rec, RECNVG_UPDATE_TEXTURE);
+	recnvg__writeInt(rec, image);
+	recnvg__writeInt(rec, x);
+	recnvg__writeInt(rec, y);
+	recnvg__writeInt(rec, w);
+	recnvg__writeInt(rec, h);
+	if (!rec->error) {
+		static const unsigned char pad[4] = {0,0,0,0};
+		for (i = y; i < y+h; i++)
+			if (fwrite(&data[(i*tex->width + x)*bpp], w*bpp, 1, rec->fp) != 1) rec->error = 1;
+		if (((w*h*bpp) & 3) != 0 && fwrite(pad, 4 - ((w*h*bpp) & 3), 1, rec->fp) != 1) rec->error = 1;
+	}
+
+	if (rec->hasForward)
+		return rec->forward.renderUpdateTexture(rec->forward.userPtr, image, x, y, w, h, data);
+	return 1;
+}
+
+static int recnvg__renderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)uptr;
+	struct RECNVGtexture* tex = recnvg__findTexture(rec->textures, rec->ntextures, image);
+	if (rec->hasForward)
+		return rec->forward.renderGetTextureSize(rec->forward.userPtr, image, w, h);
+	if (tex == NULL) return 0;
+	*w = tex->width;
+	*h = tex->height;
+	return 1;
+}
+
+static void recnvg__renderViewport(void* uptr, int width, int height, int alphaBlend)
+{
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)uptr;
+	recnvg__writeInt(rec, RECNVG_VIEWPORT);
+	recnvg__writeInt(rec, width);
+	recnvg__writeInt(rec, height);
+	recnvg__writeInt(rec, alphaBlend);
+	if (rec->hasForward)
+		rec->forward.renderViewport(rec->forward.userPtr, width, height, alphaBlend);
+}
+
+static void recnvg__renderFlush(void* uptr, int alphaBlend)
+{
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)uptr;
+	recnvg__writeInt(rec, RECNVG_FLUSH);
+	recnvg__writeInt(rec, alphaBlend);
+	if (rec->hasForward)
+		rec->forward.renderFlush(rec->forward.userPtr, alphaBlend);
+}
+
+static int recnvg__renderGetDrawCount(void* uptr)
+{
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)uptr;
+	if (rec->hasForward && rec->forward.renderGetDrawCount != NULL)
+		return rec->forward.renderGetDrawCount(rec->forward.userPtr);
+	return 0;
+}
+
+static void recnvg__renderFill(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe,
+							   const float* bounds, const struct NVGpath* paths, int npaths)
+{
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)uptr;
+	recnvg__writeInt(rec, RECNVG_FILL);
+	recnvg__writePaint(rec, paint, scissor);
+	recnvg__writeFloat(rec, fringe);
+	recnvg__write(rec, bounds, sizeof(float)*4);
+	recnvg__writePaths(rec, paths, npaths, 1);
+	if (rec->hasForward)
+		rec->forward.renderFill(rec->forward.userPtr, paint, scissor, fringe, bounds, paths, npaths);
+}
+
+static void recnvg__renderStroke(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe,
+								 float strokeWidth, const struct NVGpath* paths, int npaths)
+{
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)uptr;
+	recnvg__writeInt(rec, RECNVG_STROKE);
+	recnvg__writePaint(rec, paint, scissor);
+	recnvg__writeFloat(rec, fringe);
+	recnvg__writeFloat(rec, strokeWidth);
+	recnvg__writePaths(rec, paths, npaths, 0);
+	if (rec->hasForward)
+		rec->forward.renderStroke(rec->forward.userPtr, paint, scissor, fringe, strokeWidth, paths, npaths);
+}
+
+static void recnvg__renderTriangles(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor,
+									const struct NVGvertex* verts, int nverts)
+{
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)uptr;
+	recnvg__writeInt(rec, RECNVG_TRIANGLES);
+	recnvg__writePaint(rec, paint, scissor);
+	recnvg__writeInt(rec, nverts);
+	recnvg__write(rec, verts, sizeof(struct NVGvertex)*nverts);
+	if (rec->hasForward)
+		rec->forward.renderTriangles(rec->forward.userPtr, paint, scissor, verts, nverts);
+}
+
+static void recnvg__renderDelete(void* uptr)
+{
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)uptr;
+	if (rec == NULL) return;
+	if (rec->fp != NULL) {
+		if (rec->error)
+			printf("Failed to write nanovg recording.\n");
+		fclose(rec->fp);
+	}
+	free(rec->textures);
+	free(rec);
+}
+
+struct NVGcontext* nvgCreateRec(const char* filename, int atlasw, int atlash, int edgeaa, struct NVGcontext* forward)
+{
+	struct NVGparams params;
+	struct NVGcontext* ctx = NULL;
+	struct RECNVGcontext* rec = (struct RECNVGcontext*)malloc(sizeof(struct RECNVGcontext));
+	if (rec == NULL) goto error;
+	memset(rec, 0, sizeof(struct RECNVGcontext));
+
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = recnvg__renderCreate;
+	params.renderCreateTexture = recnvg__renderCreateTexture;
+	params.renderDeleteTexture = recnvg__renderDeleteTexture;
+	params.renderUpdateTexture = recnvg__renderUpdateTexture;
+	params.renderGetTextureSize = recnvg__renderGetTextureSize;
+	params.renderViewport = recnvg__renderViewport;
+	params.renderFlush = recnvg__renderFlush;
+	params.renderGetDrawCount = recnvg__renderGetDrawCount;
+	params.renderFill = recnvg__renderFill;
+	params.renderStroke = recnvg__renderStroke;
+	params.renderTriangles = recnvg__renderTriangles;
+	params.userPtr = rec;
+	params.atlasWidth = atlasw;
+	params.atlasHeight = atlash;
+	params.edgeAntiAlias = edgeaa;
+	params.bufferedRender = 1;
+
+	if (forward != NULL) {
+		rec->forward = *nvgInternalParams(forward);
+		rec->hasForward = 1;
+		params.bufferedRender = rec->forward.bufferedRender;
+	}
+
+	rec->fp = fopen(filename, "wb");
+	if (rec->fp == NULL) goto error;
+	recnvg__writeInt(rec, RECNVG_MAGIC);
+	recnvg__writeInt(rec, RECNVG_VERSION);
+	recnvg__writeInt(rec, atlasw);
+	recnvg__writeInt(rec, atlash);
+	recnvg__writeInt(rec, edgeaa);
+
+	// The back-end is deleted by nvgDeleteInternal() only after the context is created,
+	// nvgCreateInternal() may fail before it has a context to delete it with.
+	ctx = nvgCreateInternal(&params);
+	if (ctx == NULL) goto error;
+	nvgInternalParams(ctx)->renderDelete = recnvg__renderDelete;
+
+	return ctx;
+
+error:
+	recnvg__renderDelete(rec);
+	return NULL;
+}
+
+void nvgDeleteRec(struct NVGcontext* ctx)
+{
+	nvgDeleteInternal(ctx);
+}
+
+//
+// Replay
+//
+
+struct RECNVGreader {
+	const int* data;
+	int pos, size;	// In 32 bit words.
+	int error;
+};
+
+static const int* recnvg__read(struct RECNVGreader* r, int bytes)
+{
+	const int* ptr = &r->data[r->pos];
+	int words = (bytes + 3) / 4;
+	if (r->error || bytes < 0 || words > r->size - r->pos) {
+		r->error = 1;
+		return NULL;
+	}
+	r->pos += words;
+	return ptr;
+}
+
+// The count comes from the file, it is checked against the data left before it is multiplied.
+static const int* recnvg__readArray(struct RECNVGreader* r, int count, int size)
+{
+	if (r->error || count < 0 || (long long)count > (long long)(r->size - r->pos) * 4 / size) {
+		r->error = 1;
+		return NULL;
+	}
+	return recnvg__read(r, count * size);
+}
+
+// Returns size of the image in bytes, or -1 if the size does not fit in an int.
+static int recnvg__imageSize(int w, int h, int bpp)
+{
+	if (w <= 0 || h <= 0 || w > 0x7fffffff / bpp / h) return -1;
+	return w * h * bpp;
+}
+
+static int recnvg__readInt(struct RECNVGreader* r)
+{
+	const int* v = recnvg__read(r, sizeof(int));
+	return v != NULL ? *v : 0;
+}
+
+static float recnvg__readFloat(struct RECNVGreader* r)
+{
+	const float* v = (const float*)recnvg__read(r, sizeof(float));
+	return v != NULL ? *v : 0.0f;
+}
+
+static void recnvg__readFloats(struct RECNVGreader* r, float* dst, int n)
+{
+	const int* v = recnvg__read(r, sizeof(float)*n);
+	if (v != NULL) memcpy(dst, v, sizeof(float)*n);
+}
+
+static void recnvg__readPaint(struct RECNVGreader* r, struct NVGpaint* paint, struct NVGscissor* scissor,
+							  struct RECNVGtexture* textures, int ntextures)
+{
+	struct RECNVGtexture* tex;
+	recnvg__readFloats(r, paint->xform, 6);
+	recnvg__readFloats(r, paint->extent, 2);
+	paint->radius = recnvg__readFloat(r);
+	paint->feather = recnvg__readFloat(r);
+	recnvg__readFloats(r, paint->innerColor.rgba, 4);
+	recnvg__readFloats(r, paint->outerColor.rgba, 4);
+	paint->image = recnvg__readInt(r);
+	paint->repeat = recnvg__readInt(r);
+	recnvg__readFloats(r, scissor->xform, 6);
+	recnvg__readFloats(r, scissor->extent, 2);
+
+	// Map recorded image to the one created on replay.
+	if (paint->image != 0) {
+		tex = recnvg__findTexture(textures, ntextures, paint->image);
+		paint->image = tex != NULL ? tex->image : 0;
+	}
+}
+
+static struct NVGpath* recnvg__readPaths(struct RECNVGreader* r, struct NVGpath** paths, int* cpaths, int* npaths)
+{
+	int i, n = recnvg__readInt(r);
+	// Each path has at least 6 values.
+	if (r->error || n < 0 || n > (r->size - r->pos) / 6) return NULL;
+	if (n > *cpaths) {
+		struct NVGpath* p = (struct NVGpath*)realloc(*paths, sizeof(struct NVGpath)*n);
+		if (p == NULL) return NULL;
+		*paths = p;
+		*cpaths = n;
+	}
+	for (i = 0; i < n; i++) {
+		struct NVGpath* path = &(*paths)[i];
+		memset(path, 0, sizeof(*path));
+		path->nfill = recnvg__readInt(r);
+		path->nstroke = recnvg__readInt(r);
+		path->closed = (unsigned char)recnvg__readInt(r);
+		path->nbevel = recnvg__readInt(r);
+		path->winding = recnvg__readInt(r);
+		path->convex = recnvg__readInt(r);
+		path->fill = (struct NVGvertex*)recnvg__readArray(r, path->nfill, sizeof(struct NVGvertex));
+		path->stroke = (struct NVGvertex*)recnvg__readArray(r, path->nstroke, sizeof(struct NVGvertex));
+		if (r->error) return NULL;
+	}
+	*npaths = n;
+	return *paths;
+}
+
+int nvgReplayRec(struct NVGcontext* target, const char* filename, void (*frameCallback)(void* uptr, int frame), void* uptr)
+{
+	struct NVGparams* params = nvgInternalParams(target);
+	struct RECNVGreader r;
+	struct RECNVGtexture* textures = NULL;
+	struct RECNVGtexture* tex;
+	struct NVGpath* paths = NULL;
+	struct NVGpaint paint;
+	struct NVGscissor scissor;
+	FILE* fp = NULL;
+	int* data = NULL;
+	int ntextures = 0, ctextures = 0, cpaths = 0, npaths = 0;
+	int i, size, frames = 0;
+
+	memset(&r, 0, sizeof(r));
+	memset(&paint, 0, sizeof(paint));
+
+	fp = fopen(filename, "rb");
+	if (fp == NULL) goto error;
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if (size < 0 || size > 0x7fffffff - 4) goto error;
+	data = (int*)malloc(size + 4);
+	if (data == NULL) goto error;
+	if (fread(data, 1, size, fp) != (size_t)size) goto error;
+	fclose(fp);
+	fp = NULL;
+
+	r.data = data;
+	r.size = size / 4;
+
+	if (recnvg__readInt(&r) != RECNVG_MAGIC) goto error;
+	if (recnvg__readInt(&r) != RECNVG_VERSION) goto error;
+	recnvg__read(&r, sizeof(int)*3);	// Atlas size and edge AA, informative only.
+
+	while (r.pos < r.size && !r.error) {
+		int op = recnvg__readInt(&r);
+		if (op == RECNVG_CREATE_TEXTURE) {
+			int id = recnvg__readInt(&r);
+			int type = recnvg__readInt(&r);
+			int w = recnvg__readInt(&r);
+			int h = recnvg__readInt(&r);
+			int hasData = recnvg__readInt(&r);
+			int imgSize = recnvg__imageSize(w, h, recnvg__bpp(type));
+			const unsigned char* img = NULL;
+			if (r.error || imgSize < 0) goto error;
+			if (hasData)
+				img = (const unsigned char*)recnvg__readArray(&r, imgSize, 1);
+			if (r.error) goto error;
+			tex = recnvg__addTexture(&textures, &ntextures, &ctextures);
+			if (tex == NULL) goto error;
+			tex->id = id;
+			tex->type = type;
+			tex->data = (unsigned char*)malloc(imgSize);
+			if (tex->data == NULL) goto error;
+			if (img != NULL)
+				memcpy(tex->data, img, imgSize);
+			else
+				memset(tex->data, 0, imgSize);
+			tex->width = w;
+			tex->height = h;
+			tex->image = params->renderCreateTexture(params->userPtr, type, w, h, img);
+		} else if (op == RECNVG_DELETE_TEXTURE) {
+			tex = recnvg__findTexture(textures, ntextures, recnvg__readInt(&r));
+			if (tex != NULL) {
+				params->renderDeleteTexture(params->userPtr, tex->image);
+				free(tex->data);
+				tex->data = NULL;
+				tex->id = 0;
+			}
+		} else if (op == RECNVG_UPDATE_TEXTURE) {
+			int id = recnvg__readInt(&r);
+			int x = recnvg__readInt(&r);
+			int y = recnvg__readInt(&r);
+			int w = recnvg__readInt(&r);
+			int h = recnvg__readInt(&r);
+			const unsigned char* rect;
+			int bpp;
+			tex = recnvg__findTexture(textures, ntextures, id);
+			if (tex == NULL || r.error || w < 0 || h < 0) goto error;
+			// The rect is checked against the texture first, which bounds w*h*bpp.
+			if (x < 0 || y < 0 || w > tex->width - x || h > tex->height - y) goto error;
+			bpp = recnvg__bpp(tex->type);
+			rect = (const unsigned char*)recnvg__readArray(&r, w*h, bpp);
+			if (rect == NULL) goto error;
+			for (i = 0; i < h; i++)
+				memcpy(&tex->data[((y+i)*tex->width + x)*bpp], &rect[i*w*bpp], w*bpp);
+			params->renderUpdateTexture(params->userPtr, tex->image, x, y, w, h, tex->data);
+		} else if (op == RECNVG_VIEWPORT) {
+			int w = recnvg__readInt(&r);
+			int h = recnvg__readInt(&r);
+			int alphaBlend = recnvg__readInt(&r);
+			if (r.error) goto error;
+			params->renderViewport(params->userPtr, w, h, alphaBlend);
+		} else if (op == RECNVG_FLUSH) {
+			int alphaBlend = recnvg__readInt(&r);
+			if (r.error) goto error;
+			params->renderFlush(params->userPtr, alphaBlend);
+			if (frameCallback != NULL)
+				frameCallback(uptr, frames);
+			frames++;
+		} else if (op == RECNVG_FILL) {
+			float fringe, bounds[4];
+			recnvg__readPaint(&r, &paint, &scissor, textures, ntextures);
+			fringe = recnvg__readFloat(&r);
+			recnvg__readFloats(&r, bounds, 4);
+			if (recnvg__readPaths(&r, &paths, &cpaths, &npaths) == NULL) goto error;
+			params->renderFill(params->userPtr, &paint, &scissor, fringe, bounds, paths, npaths);
+		} else if (op == RECNVG_STROKE) {
+			float fringe, strokeWidth;
+			recnvg__readPaint(&r, &paint, &scissor, textures, ntextures);
+			fringe = recnvg__readFloat(&r);
+			strokeWidth = recnvg__readFloat(&r);
+			if (recnvg__readPaths(&r, &paths, &cpaths, &npaths) == NULL) goto error;
+			params->renderStroke(params->userPtr, &paint, &scissor, fringe, strokeWidth, paths, npaths);
+		} else if (op == RECNVG_TRIANGLES) {
+			const struct NVGvertex* verts;
+			int nverts;
+			recnvg__readPaint(&r, &paint, &scissor, textures, ntextures);
+			nverts = recnvg__readInt(&r);
+			verts = (const struct NVGvertex*)recnvg__readArray(&r, nverts, sizeof(struct NVGvertex));
+			if (verts == NULL) goto error;
+			params->renderTriangles(params->userPtr, &paint, &scissor, verts, nverts);
+		} else {
+			goto error;
+		}
+	}
+	if (r.error) goto error;
+
+	for (i = 0; i < ntextures; i++) {
+		if (textures[i].id == 0) continue;
+		params->renderDeleteTexture(params->userPtr, textures[i].image);
+		free(textures[i].data);
+	}
+	free(textures);
+	free(paths);
+	free(data);
+
+	return frames;
+
+error:
+	if (fp != NULL) fclose(fp);
+	for (i = 0; i < ntextures; i++) {
+		if (textures[i].id == 0) continue;
+		params->renderDeleteTexture(params->userPtr, textures[i].image);
+		free(textures[i].data);
+	}
+	free(textures);
+	free(paths);
+	free(data);
+	return -1;
+}
+
+#endif
@@ -0,0 +1,1276 @@
+//
+// Copyright (c) 2009-2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+#ifndef NANOVG_SW_H
+#define NANOVG_SW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Software back-end, rasterizes into a caller provided RGBA buffer.
+// The screen is split into tiles, calls are binned per tile and the tiles
+// are rasterized in parallel. Anti-aliasing uses the same fringe geometry
+// and coverage math as the GL back-end.
+//
+//		#define NANOVG_SW_IMPLEMENTATION
+//		#include "nanovg_sw.h"
+//		...
+//		vg = nvgCreateSW(512, 512, 1, 8);
+//		nvgSetTargetSW(vg, pixels, width, height, width*4);
+//		nvgBeginFrame(vg, width, height, 1.0f, NVG_STRAIGHT_ALPHA);
+//		...
+//		nvgEndFrame(vg);
+
+// Creates new software renderer using specified number of threads, 0 or 1 renders on the calling thread only.
+struct NVGcontext* nvgCreateSW(int atlasw, int atlash, int edgeaa, int threads);
+void nvgDeleteSW(struct NVGcontext* ctx);
+
+// Sets the RGBA buffer to render to. Rows are 'stride' bytes apart.
+// The view passed to nvgBeginFrame() is scaled to cover the whole buffer.
+void nvgSetTargetSW(struct NVGcontext* ctx, unsigned char* rgba, int width, int height, int stride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#ifdef NANOVG_SW_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "nanovg.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define SWNVG_TILE_SIZE 64
+#define SWNVG_MAX_THREADS 64
+
+enum SWNVGcallType {
+	SWNVG_FILL,
+	SWNVG_CONVEXFILL,
+	SWNVG_STROKE,
+	SWNVG_TRIANGLES,
+};
+
+enum SWNVGshaderType {
+	SWNVG_SHADER_FILLGRAD,
+	SWNVG_SHADER_FILLIMG,
+	SWNVG_SHADER_IMG = 3,
+};
+
+// What to do with the pixels covered by a triangle.
+enum SWNVGrasterMode {
+	SWNVG_RASTER_STENCIL,		// Winding into stencil, front faces increment, back faces decrement.
+	SWNVG_RASTER_SHADE,			// Shade and blend.
+	SWNVG_RASTER_SHADE_OUTSIDE,	// Shade where stencil is zero (fill fringes).
+	SWNVG_RASTER_SHADE_INSIDE,	// Shade where stencil is non-zero and clear stencil (fill cover).
+};
+
+struct SWNVGtexture {
+	int id;
+	int width, height;
+	int type;
+	unsigned char* data;
+};
+
+// Same values as the GL back-end fragment uniforms.
+struct SWNVGpaint {
+	float scissorMat[6];
+	float paintMat[6];
+	struct NVGcolor innerCol;
+	struct NVGcolor outerCol;
+	float scissorExt[2];
+	float scissorScale[2];
+	float extent[2];
+	float radius;
+	float feather;
+	float strokeMult;
+	int type;
+	int image;
+	int scissor;
+	int solid;
+};
+
+struct SWNVGcall {
+	int type;
+	int pathOffset;
+	int pathCount;
+	int triangleOffset;
+	int triangleCount;
+	int paint;
+	int bounds[4];	// Covered pixels, max exclusive.
+};
+
+struct SWNVGpath {
+	int fillOffset;
+	int fillCount;
+	int strokeOffset;
+	int strokeCount;
+};
+
+struct SWNVGbin {
+	int* calls;
+	int ncalls;
+	int ccalls;
+};
+
+struct SWNVGcontext;
+
+struct SWNVGworker {
+	struct SWNVGcontext* sw;
+	// Tiles still to do, begin in high and end in low 32 bits.
+	// The owner takes tiles from the front, others steal from the back.
+	volatile long long range;
+	unsigned char stencil[SWNVG_TILE_SIZE*SWNVG_TILE_SIZE];
+#ifdef _WIN32
+	HANDLE thread;
+#else
+	pthread_t thread;
+#endif
+};
+
+struct SWNVGcontext {
+	struct SWNVGtexture* textures;
+	int ntextures;
+	int ctextures;
+	int textureId;
+	float view[2];
+	int edgeAntiAlias;
+	int alphaBlend;
+
+	// Target
+	unsigned char* pixels;
+	int width, height, stride;
+	float scale[2];
+	float invScale[2];
+
+	// Per frame buffers
+	struct SWNVGcall* calls;
+	int ccalls;
+	int ncalls;
+	struct SWNVGpath* paths;
+	int cpaths;
+	int npaths;
+	struct NVGvertex* verts;
+	int cverts;
+	int nverts;
+	struct SWNVGpaint* paints;
+	int cpaints;
+	int npaints;
+
+	// Tiles
+	struct SWNVGbin* bins;
+	int tilesx, tilesy;
+	int cbins;
+
+	// Workers, worker 0 is the calling thread.
+	struct SWNVGworker workers[SWNVG_MAX_THREADS];
+	int nworkers;
+	int frame;
+	int done;
+	int quit;
+#ifdef _WIN32
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE start;
+	CONDITION_VARIABLE finish;
+#else
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t finish;
+#endif
+};
+
+static int swnvg__maxi(int a, int b) { return a > b ? a : b; }
+static int swnvg__mini(int a, int b) { return a < b ? a : b; }
+static float swnvg__minf(float a, float b) { return a < b ? a : b; }
+static float swnvg__maxf(float a, float b) { return a > b ? a : b; }
+static float swnvg__clampf(float a, float mn, float mx) { return a < mn ? mn : (a > mx ? mx : a); }
+
+static int swnvg__cas(volatile long long* ptr, long long oldval, long long newval)
+{
+#ifdef _WIN32
+	return InterlockedCompareExchange64(ptr, newval, oldval) == oldval;
+#else
+	return __sync_bool_compare_and_swap(ptr, oldval, newval);
+#endif
+}
+
+static long long swnvg__load(volatile long long* ptr)
+{
+#ifdef _WIN32
+	return InterlockedCompareExchange64(ptr, 0, 0);
+#else
+	return __sync_fetch_and_or(ptr, 0);
+#endif
+}
+
+static long long swnvg__packRange(int begin, int end)
+{
+	return ((long long)begin << 32) | (long long)(unsigned int)end;
+}
+
+static struct SWNVGtexture* swnvg__allocTexture(struct SWNVGcontext* sw)
+{
+	struct SWNVGtexture* tex = NULL;
+	int i;
+
+	for (i = 0; i < sw->ntextures; i++) {
+		if (sw->textures[i].id == 0) {
+			tex = &sw->textures[i];
+			break;
+		}
+	}
+	if (tex == NULL) {
+		if (sw->ntextures+1 > sw->ctextures) {
+			sw->ctextures = (sw->ctextures == 0) ? 2 : sw->ctextures*2;
+			sw->textures = (struct SWNVGtexture*)realloc(sw->textures, sizeof(struct SWNVGtexture)*sw->ctextures);
+			if (sw->textures == NULL) return NULL;
+		}
+		tex = &sw->textures[sw->ntextures++];
+	}
+
+	memset(tex, 0, sizeof(*tex));
+	tex->id = ++sw->textureId;
+
+	return tex;
+}
+
+static struct SWNVGtexture* swnvg__findTexture(struct SWNVGcontext* sw, int id)
+{
+	int i;
+	for (i = 0; i < sw->ntextures; i++)
+		if (sw->textures[i].id == id)
+			return &sw->textures[i];
+	return NULL;
+}
+
+static int swnvg__renderCreate(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+	return 1;
+}
+
+static int swnvg__renderCreateTexture(void* uptr, int type, int w, int h, const unsigned char* data)
+{
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)uptr;
+	struct SWNVGtexture* tex = swnvg__allocTexture(sw);
+	int bpp = type == NVG_TEXTURE_RGBA ? 4 : 1;
+
+	if (tex == NULL) return 0;
+	tex->width = w;
+	tex->height = h;
+	tex->type = type;
+	tex->data = (unsigned char*)malloc(w*h*bpp);
+	if (tex->data == NULL) {
+		tex->id = 0;
+		return 0;
+	}
+	if (data != NULL)
+		memcpy(tex->data, data, w*h*bpp);
+	else
+		memset(tex->data, 0, w*h*bpp);
+
+	return tex->id;
+}
+
+static int swnvg__renderDeleteTexture(void* uptr, int image)
+{
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)uptr;
+	struct SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	if (tex == NULL) return 0;
+	free(tex->data);
+	memset(tex, 0, sizeof(*tex));
+	return 1;
+}
+
+static int swnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)uptr;
+	struct SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	int i, bpp;
+
+	if (tex == NULL) return 0;
+	bpp = tex->type == NVG_TEXTURE_RGBA ? 4 : 1;
+
+	// Data points to the whole image, like with the GL back-end.
+	for (i = y; i < y+h; i++)
+		memcpy(&tex->data[(i*tex->width + x)*bpp], &data[(i*tex->width + x)*bpp], w*bpp);
+
+	return 1;
+}
+
+static int swnvg__renderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)uptr;
+	struct SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	if (tex == NULL) return 0;
+	*w = tex->width;
+	*h = tex->height;
+	return 1;
+}
+
+static void swnvg__updateScale(struct SWNVGcontext* sw)
+{
+	sw->scale[0] = sw->view[0] > 0 ? sw->width / sw->view[0] : 1.0f;
+	sw->scale[1] = sw->view[1] > 0 ? sw->height / sw->view[1] : 1.0f;
+	sw->invScale[0] = 1.0f / sw->scale[0];
+	sw->invScale[1] = 1.0f / sw->scale[1];
+}
+
+static void swnvg__renderViewport(void* uptr, int width, int height, int alphaBlend)
+{
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)uptr;
+	sw->view[0] = (float)width;
+	sw->view[1] = (float)height;
+	sw->alphaBlend = alphaBlend;
+	swnvg__updateScale(sw);
+}
+
+static int swnvg__convertPaint(struct SWNVGcontext* sw, struct SWNVGpaint* frag, struct NVGpaint* paint,
+							   struct NVGscissor* scissor, float width, float fringe)
+{
+	memset(frag, 0, sizeof(*frag));
+
+	frag->innerCol = paint->innerColor;
+	frag->outerCol = paint->outerColor;
+
+	nvgTransformInverse(frag->paintMat, paint->xform);
+
+	if (scissor->extent[0] < 0.5f || scissor->extent[1] < 0.5f) {
+		frag->scissor = 0;
+	} else {
+		frag->scissor = 1;
+		nvgTransformInverse(frag->scissorMat, scissor->xform);
+		frag->scissorExt[0] = scissor->extent[0];
+		frag->scissorExt[1] = scissor->extent[1];
+		frag->scissorScale[0] = sqrtf(scissor->xform[0]*scissor->xform[0] + scissor->xform[2]*scissor->xform[2]) / fringe;
+		frag->scissorScale[1] = sqrtf(scissor->xform[1]*scissor->xform[1] + scissor->xform[3]*scissor->xform[3]) / fringe;
+	}
+	memcpy(frag->extent, paint->extent, sizeof(frag->extent));
+	frag->strokeMult = (width*0.5f + fringe*0.5f) / fringe;
+
+	if (paint->image != 0) {
+		if (swnvg__findTexture(sw, paint->image) == NULL) return 0;
+		frag->type = SWNVG_SHADER_FILLIMG;
+		frag->image = paint->image;
+	} else {
+		frag->type = SWNVG_SHADER_FILLGRAD;
+		frag->radius = paint->radius;
+		frag->feather = paint->feather;
+		frag->solid = memcmp(&frag->innerCol, &frag->outerCol, sizeof(struct NVGcolor)) == 0;
+	}
+	return 1;
+}
+
+static struct SWNVGcall* swnvg__allocCall(struct SWNVGcontext* sw)
+{
+	struct SWNVGcall* ret = NULL;
+	if (sw->ncalls+1 > sw->ccalls) {
+		sw->ccalls = sw->ccalls == 0 ? 32 : sw->ccalls * 2;
+		sw->calls = (struct SWNVGcall*)realloc(sw->calls, sizeof(struct SWNVGcall) * sw->ccalls);
+	}
+	ret = &sw->calls[sw->ncalls++];
+	memset(ret, 0, sizeof(struct SWNVGcall));
+	return ret;
+}
+
+static int swnvg__allocPaths(struct SWNVGcontext* sw, int n)
+{
+	int ret = 0;
+	if (sw->npaths+n > sw->cpaths) {
+		sw->cpaths = swnvg__maxi(sw->npaths+n, sw->cpaths == 0 ? 32 : sw->cpaths * 2);
+		sw->paths = (struct SWNVGpath*)realloc(sw->paths, sizeof(struct SWNVGpath) * sw->cpaths);
+	}
+	ret = sw->npaths;
+	sw->npaths += n;
+	return ret;
+}
+
+static int swnvg__allocVerts(struct SWNVGcontext* sw, int n)
+{
+	int ret = 0;
+	if (sw->nverts+n > sw->cverts) {
+		sw->cverts = swnvg__maxi(sw->nverts+n, sw->cverts == 0 ? 256 : sw->cverts * 2);
+		sw->verts = (struct NVGvertex*)realloc(sw->verts, sizeof(struct NVGvertex) * sw->cverts);
+	}
+	ret = sw->nverts;
+	sw->nverts += n;
+	return ret;
+}
+
+static int swnvg__allocPaint(struct SWNVGcontext* sw)
+{
+	if (sw->npaints+1 > sw->cpaints) {
+		sw->cpaints = sw->cpaints == 0 ? 32 : sw->cpaints * 2;
+		sw->paints = (struct SWNVGpaint*)realloc(sw->paints, sizeof(struct SWNVGpaint) * sw->cpaints);
+	}
+	return sw->npaints++;
+}
+
+static void swnvg__vset(struct NVGvertex* vtx, float x, float y, float u, float v)
+{
+	vtx->x = x;
+	vtx->y = y;
+	vtx->u = u;
+	vtx->v = v;
+}
+
+// Calculates the pixels a call can touch, limited by the scissor.
+static void swnvg__callBounds(struct SWNVGcontext* sw, struct SWNVGcall* call, struct NVGscissor* scissor,
+							  const struct NVGvertex* verts, int nverts)
+{
+	float minx = 1e6f, miny = 1e6f, maxx = -1e6f, maxy = -1e6f;
+	int i;
+
+	for (i = 0; i < nverts; i++) {
+		minx = swnvg__minf(minx, verts[i].x);
+		miny = swnvg__minf(miny, verts[i].y);
+		maxx = swnvg__maxf(maxx, verts[i].x);
+		maxy = swnvg__maxf(maxy, verts[i].y);
+	}
+
+	if (scissor->extent[0] >= 0.5f && scissor->extent[1] >= 0.5f) {
+		// Bounding box of the scissor rect, plus the one pixel soft edge.
+		const float* t = scissor->xform;
+		float ex = fabsf(t[0])*scissor->extent[0] + fabsf(t[2])*scissor->extent[1] + 1.0f;
+		float ey = fabsf(t[1])*scissor->extent[0] + fabsf(t[3])*scissor->extent[1] + 1.0f;
+		minx = swnvg__maxf(minx, t[4] - ex);
+		miny = swnvg__maxf(miny, t[5] - ey);
+		maxx = swnvg__minf(maxx, t[4] + ex);
+		maxy = swnvg__minf(maxy, t[5] + ey);
+	}
+
+	call->bounds[0] = swnvg__maxi(0, (int)floorf(minx * sw->scale[0]));
+	call->bounds[1] = swnvg__maxi(0, (int)floorf(miny * sw->scale[1]));
+	call->bounds[2] = swnvg__mini(sw->width, (int)ceilf(maxx * sw->scale[0]) + 1);
+	call->bounds[3] = swnvg__mini(sw->height, (int)ceilf(maxy * sw->scale[1]) + 1);
+}
+
+static void swnvg__renderFill(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe,
+							  const float* bounds, const struct NVGpath* paths, int npaths)
+{
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)uptr;
+	struct SWNVGcall* call = swnvg__allocCall(sw);
+	struct NVGvertex* quad;
+	int i, maxverts, offset, first;
+
+	call->type = SWNVG_FILL;
+	call->pathOffset = swnvg__allocPaths(sw, npaths);
+	call->pathCount = npaths;
+
+	if (npaths == 1 && paths[0].convex)
+		call->type = SWNVG_CONVEXFILL;
+
+	// Allocate vertices for all the paths.
+	maxverts = 6;
+	for (i = 0; i < npaths; i++)
+		maxverts += paths[i].nfill + paths[i].nstroke;
+	offset = first = swnvg__allocVerts(sw, maxverts);
+
+	for (i = 0; i < npaths; i++) {
+		struct SWNVGpath* copy = &sw->paths[call->pathOffset + i];
+		const struct NVGpath* path = &paths[i];
+		memset(copy, 0, sizeof(struct SWNVGpath));
+		if (path->nfill > 0) {
+			copy->fillOffset = offset;
+			copy->fillCount = path->nfill;
+			memcpy(&sw->verts[offset], path->fill, sizeof(struct NVGvertex) * path->nfill);
+			offset += path->nfill;
+		}
+		if (path->nstroke > 0) {
+			copy->strokeOffset = offset;
+			copy->strokeCount = path->nstroke;
+			memcpy(&sw->verts[offset], path->stroke, sizeof(struct NVGvertex) * path->nstroke);
+			offset += path->nstroke;
+		}
+	}
+
+	// Quad
+	call->triangleOffset = offset;
+	call->triangleCount = 6;
+	quad = &sw->verts[call->triangleOffset];
+	swnvg__vset(&quad[0], bounds[0], bounds[3], 0.5f, 1.0f);
+	swnvg__vset(&quad[1], bounds[2], bounds[3], 0.5f, 1.0f);
+	swnvg__vset(&quad[2], bounds[2], bounds[1], 0.5f, 1.0f);
+
+	swnvg__vset(&quad[3], bounds[0], bounds[3], 0.5f, 1.0f);
+	swnvg__vset(&quad[4], bounds[2], bounds[1], 0.5f, 1.0f);
+	swnvg__vset(&quad[5], bounds[0], bounds[1], 0.5f, 1.0f);
+
+	swnvg__callBounds(sw, call, scissor, &sw->verts[first], offset + 6 - first);
+
+	call->paint = swnvg__allocPaint(sw);
+	if (!swnvg__convertPaint(sw, &sw->paints[call->paint], paint, scissor, fringe, fringe))
+		sw->ncalls--;
+}
+
+static void swnvg__renderStroke(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor, float fringe,
+								float strokeWidth, const struct NVGpath* paths, int npaths)
+{
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)uptr;
+	struct SWNVGcall* call = swnvg__allocCall(sw);
+	int i, maxverts, offset, first;
+
+	call->type = SWNVG_STROKE;
+	call->pathOffset = swnvg__allocPaths(sw, npaths);
+	call->pathCount = npaths;
+
+	// Allocate vertices for all the paths.
+	maxverts = 0;
+	for (i = 0; i < npaths; i++)
+		maxverts += paths[i].nstroke;
+	offset = first = swnvg__allocVerts(sw, maxverts);
+
+	for (i = 0; i < npaths; i++) {
+		struct SWNVGpath* copy = &sw->paths[call->pathOffset + i];
+		const struct NVGpath* path = &paths[i];
+		memset(copy, 0, sizeof(struct SWNVGpath));
+		if (path->nstroke) {
+			copy->strokeOffset = offset;
+			copy->strokeCount = path->nstroke;
+			memcpy(&sw->verts[offset], path->stroke, sizeof(struct NVGvertex) * path->nstroke);
+			offset += path->nstroke;
+		}
+	}
+
+	swnvg__callBounds(sw, call, scissor, &sw->verts[first], offset - first);
+
+	call->paint = swnvg__allocPaint(sw);
+	if (!swnvg__convertPaint(sw, &sw->paints[call->paint], paint, scissor, strokeWidth, fringe))
+		sw->ncalls--;
+}
+
+static void swnvg__renderTriangles(void* uptr, struct NVGpaint* paint, struct NVGscissor* scissor,
+								   const struct NVGvertex* verts, int nverts)
+{
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)uptr;
+	struct SWNVGcall* call = swnvg__allocCall(sw);
+	struct SWNVGpaint* frag;
+
+	call->type = SWNVG_TRIANGLES;
+
+	// Allocate vertices for all the paths.
+	call->triangleOffset = swnvg__allocVerts(sw, nverts);
+	call->triangleCount = nverts;
+	memcpy(&sw->verts[call->triangleOffset], verts, sizeof(struct NVGvertex) * nverts);
+
+	swnvg__callBounds(sw, call, scissor, verts, nverts);
+
+	call->paint = swnvg__allocPaint(sw);
+	frag = &sw->paints[call->paint];
+	if (!swnvg__convertPaint(sw, frag, paint, scissor, 1.0f, 1.0f)) {
+		sw->ncalls--;
+		return;
+	}
+	frag->type = SWNVG_SHADER_IMG;
+}
+
+//
+// Rasterization
+//
+
+struct SWNVGraster {
+	struct SWNVGcontext* sw;
+	const struct SWNVGpaint* paint;
+	const struct SWNVGtexture* tex;
+	unsigned char* stencil;
+	int clip[4];	// Tile rect, max exclusive.
+};
+
+static float swnvg__sdroundrect(float px, float py, float ex, float ey, float rad)
+{
+	float dx = fabsf(px) - (ex - rad);
+	float dy = fabsf(py) - (ey - rad);
+	float mx = swnvg__maxf(dx, 0.0f), my = swnvg__maxf(dy, 0.0f);
+	return swnvg__minf(swnvg__maxf(dx, dy), 0.0f) + sqrtf(mx*mx + my*my) - rad;
+}
+
+// Bilinear sample with repeat wrapping, like the default GL sampler state.
+static void swnvg__sample(const struct SWNVGtexture* tex, float s, float t, float* col)
+{
+	float x = s * tex->width - 0.5f;
+	float y = t * tex->height - 0.5f;
+	float fx = floorf(x), fy = floorf(y);
+	float ax = x - fx, ay = y - fy;
+	int x0 = (int)fx % tex->width, y0 = (int)fy % tex->height;
+	int x1, y1, i;
+	if (x0 < 0) x0 += tex->width;
+	if (y0 < 0) y0 += tex->height;
+	x1 = x0+1 < tex->width ? x0+1 : 0;
+	y1 = y0+1 < tex->height ? y0+1 : 0;
+
+	if (tex->type == NVG_TEXTURE_RGBA) {
+		const unsigned char* p00 = &tex->data[(y0*tex->width + x0)*4];
+		const unsigned char* p10 = &tex->data[(y0*tex->width + x1)*4];
+		const unsigned char* p01 = &tex->data[(y1*tex->width + x0)*4];
+		const unsigned char* p11 = &tex->data[(y1*tex->width + x1)*4];
+		for (i = 0; i < 4; i++) {
+			float a = p00[i] + (p10[i] - p00[i]) * ax;
+			float b = p01[i] + (p11[i] - p01[i]) * ax;
+			col[i] = (a + (b - a) * ay) * (1.0f/255.0f);
+		}
+	} else {
+		const unsigned char* d = tex->data;
+		float a = d[y0*tex->width + x0] + (d[y0*tex->width + x1] - d[y0*tex->width + x0]) * ax;
+		float b = d[y1*tex->width + x0] + (d[y1*tex->width + x1] - d[y1*tex->width + x0]) * ax;
+		col[0] = col[1] = col[2] = 1.0f;
+		col[3] = (a + (b - a) * ay) * (1.0f/255.0f);
+	}
+}
+
+// Fragment shader of the GL back-end.
+static void swnvg__shade(struct SWNVGraster* r, int px, int py, float u, float v)
+{
+	const struct SWNVGpaint* p = r->paint;
+	struct SWNVGcontext* sw = r->sw;
+	unsigned char* dst = &sw->pixels[py*sw->stride + px*4];
+	float x = (px + 0.5f) * sw->invScale[0];
+	float y = (py + 0.5f) * sw->invScale[1];
+	float col[4], alpha = 1.0f, ia;
+	int i;
+
+	if (p->scissor) {
+		const float* t = p->scissorMat;
+		float scx = 0.5f - (fabsf(t[0]*x + t[2]*y + t[4]) - p->scissorExt[0]) * p->scissorScale[0];
+		float scy = 0.5f - (fabsf(t[1]*x + t[3]*y + t[5]) - p->scissorExt[1]) * p->scissorScale[1];
+		alpha = swnvg__clampf(scx, 0.0f, 1.0f) * swnvg__clampf(scy, 0.0f, 1.0f);
+		if (alpha <= 0.0f) return;
+	}
+
+	if (p->type == SWNVG_SHADER_IMG) {
+		swnvg__sample(r->tex, u, v, col);
+		for (i = 0; i < 4; i++)
+			col[i] *= p->innerCol.rgba[i];
+		col[3] *= alpha;
+	} else {
+		if (sw->edgeAntiAlias)
+			alpha *= swnvg__minf(1.0f, (1.0f - fabsf(u*2.0f - 1.0f)) * p->strokeMult) * swnvg__minf(1.0f, v);
+		if (p->type == SWNVG_SHADER_FILLGRAD) {
+			if (p->solid) {
+				memcpy(col, p->innerCol.rgba, sizeof(col));
+			} else {
+				const float* t = p->paintMat;
+				float ptx = t[0]*x + t[2]*y + t[4];
+				float pty = t[1]*x + t[3]*y + t[5];
+				float d = swnvg__clampf((swnvg__sdroundrect(ptx, pty, p->extent[0], p->extent[1], p->radius) + p->feather*0.5f) / p->feather, 0.0f, 1.0f);
+				for (i = 0; i < 4; i++)
+					col[i] = p->innerCol.rgba[i] + (p->outerCol.rgba[i] - p->innerCol.rgba[i]) * d;
+			}
+		} else {
+			const float* t = p->paintMat;
+			float ptx = (t[0]*x + t[2]*y + t[4]) / p->extent[0];
+			float pty = (t[1]*x + t[3]*y + t[5]) / p->extent[1];
+			swnvg__sample(r->tex, ptx, pty, col);
+		}
+		col[3] *= alpha;
+	}
+
+	if (col[3] <= 0.0f) return;
+
+	// Blend, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+	ia = 1.0f - col[3];
+	for (i = 0; i < 3; i++)
+		dst[i] = (unsigned char)(swnvg__clampf(col[i]*col[3]*255.0f + dst[i]*ia, 0.0f, 255.0f) + 0.5f);
+	if (sw->alphaBlend == NVG_PREMULTIPLIED_ALPHA)
+		dst[3] = (unsigned char)(swnvg__clampf(col[3]*255.0f + dst[3]*ia, 0.0f, 255.0f) + 0.5f);
+	else
+		dst[3] = (unsigned char)(swnvg__clampf(col[3]*col[3]*255.0f + dst[3]*ia, 0.0f, 255.0f) + 0.5f);
+}
+
+// Solid color without scissor is constant over a triangle whose corners have the same
+// anti-aliasing coverage, like fill interiors and cover quads. Computes the blend terms
+// of swnvg__shade() once, so that the spans can skip the shader. Returns 0 if not solid.
+static int swnvg__solidColor(const struct SWNVGraster* r, const struct NVGvertex* v0, const struct NVGvertex* v1,
+							 const struct NVGvertex* v2, float* src, float* ia)
+{
+	const struct SWNVGpaint* p = r->paint;
+	float alpha = 1.0f, a;
+	int i;
+
+	if (p->type != SWNVG_SHADER_FILLGRAD || !p->solid || p->scissor) return 0;
+	if (r->sw->edgeAntiAlias) {
+		if (v0->u != v1->u || v0->u != v2->u || v0->v != v1->v || v0->v != v2->v) return 0;
+		alpha = swnvg__minf(1.0f, (1.0f - fabsf(v0->u*2.0f - 1.0f)) * p->strokeMult) * swnvg__minf(1.0f, v0->v);
+	}
+
+	a = p->innerCol.rgba[3] * alpha;
+	for (i = 0; i < 3; i++)
+		src[i] = p->innerCol.rgba[i]*a*255.0f;
+	if (r->sw->alphaBlend == NVG_PREMULTIPLIED_ALPHA)
+		src[3] = a*255.0f;
+	else
+		src[3] = a*a*255.0f;
+	*ia = a > 0.0f ? 1.0f - a : -1.0f;	// Negative when there is nothing to blend.
+	return 1;
+}
+
+// Vertices are snapped to 1/256 pixel so that the edge functions are exact and
+// the pixels on an edge shared by two triangles are drawn exactly once.
+#define SWNVG_SUBPIXEL_ONE 256
+#define SWNVG_MAX_COORD 32768.0f
+
+static long long swnvg__snap(float v)
+{
+	// Written so that NaN clamps too.
+	if (!(v > -SWNVG_MAX_COORD)) v = -SWNVG_MAX_COORD;
+	else if (v > SWNVG_MAX_COORD) v = SWNVG_MAX_COORD;
+	return (long long)floorf(v * SWNVG_SUBPIXEL_ONE + 0.5f);
+}
+
+// Top-left fill rule, pixels exactly on an edge belong to one triangle only.
+static int swnvg__topLeft(long long dx, long long dy)
+{
+	return dy > 0 || (dy == 0 && dx < 0);
+}
+
+// Narrows the span of pixels [*k0,*k1] where the edge value e + k*step is not negative.
+static void swnvg__edgeSpan(long long e, long long step, int* k0, int* k1)
+{
+	if (step < 0) {
+		if (e < 0) *k1 = -1;
+		else if (e / -step < *k1) *k1 = (int)(e / -step);
+	} else if (e < 0) {
+		if (step == 0) *k1 = -1;
+		else {
+			// The first inside pixel can be far past the span, keep it within int.
+			long long k = (-e + step - 1) / step;
+			if (k > *k1) *k1 = -1;
+			else if (k > *k0) *k0 = (int)k;
+		}
+	}
+}
+
+// Rasterizes a triangle within the clip rect, pixels are sampled at their centers like GL does.
+static void swnvg__triangle(struct SWNVGraster* r, const struct NVGvertex* v0, const struct NVGvertex* v1,
+							const struct NVGvertex* v2, int mode, int cull)
+{
+	struct SWNVGcontext* sw = r->sw;
+	const struct NVGvertex* tmp;
+	long long x0, y0, x1, y1, x2, y2, area, t, cx, cy;
+	long long e0r, e1r, e2r, e0, e1, e2, sx0, sx1, sx2, sy0, sy1, sy2;
+	float fminx, fminy, fmaxx, fmaxy, iarea, src[4], ia = 0.0f;
+	unsigned char opaque[4];
+	int front, minx, miny, maxx, maxy, px, py, k0, k1, i, solid = 0;
+
+	x0 = swnvg__snap(v0->x * sw->scale[0]); y0 = swnvg__snap(v0->y * sw->scale[1]);
+	x1 = swnvg__snap(v1->x * sw->scale[0]); y1 = swnvg__snap(v1->y * sw->scale[1]);
+	x2 = swnvg__snap(v2->x * sw->scale[0]); y2 = swnvg__snap(v2->y * sw->scale[1]);
+
+	area = (x1-x0)*(y2-y0) - (x2-x0)*(y1-y0);
+	if (area == 0) return;
+	// GL flips y, so negative area here is counter clockwise, front facing triangle.
+	front = area < 0;
+	if (cull && !front) return;
+	if (area < 0) {
+		tmp = v1; v1 = v2; v2 = tmp;
+		t = x1; x1 = x2; x2 = t;
+		t = y1; y1 = y2; y2 = t;
+		area = -area;
+	}
+	iarea = 1.0f / (float)area;
+
+	// Conservative pixel bounds, the spans below are exact.
+	fminx = swnvg__minf((float)x0, swnvg__minf((float)x1, (float)x2)) / SWNVG_SUBPIXEL_ONE;
+	fminy = swnvg__minf((float)y0, swnvg__minf((float)y1, (float)y2)) / SWNVG_SUBPIXEL_ONE;
+	fmaxx = swnvg__maxf((float)x0, swnvg__maxf((float)x1, (float)x2)) / SWNVG_SUBPIXEL_ONE;
+	fmaxy = swnvg__maxf((float)y0, swnvg__maxf((float)y1, (float)y2)) / SWNVG_SUBPIXEL_ONE;
+	minx = swnvg__maxi(r->clip[0], (int)floorf(fminx - 0.5f));
+	miny = swnvg__maxi(r->clip[1], (int)floorf(fminy - 0.5f));
+	maxx = swnvg__mini(r->clip[2]-1, (int)ceilf(fmaxx - 0.5f));
+	maxy = swnvg__mini(r->clip[3]-1, (int)ceilf(fmaxy - 0.5f));
+	if (minx > maxx || miny > maxy) return;
+
+	// Edge function steps per pixel, e0 is opposite to v0 and so on.
+	sx0 = -(y2-y1) * SWNVG_SUBPIXEL_ONE; sy0 = (x2-x1) * SWNVG_SUBPIXEL_ONE;
+	sx1 = -(y0-y2) * SWNVG_SUBPIXEL_ONE; sy1 = (x0-x2) * SWNVG_SUBPIXEL_ONE;
+	sx2 = -(y1-y0) * SWNVG_SUBPIXEL_ONE; sy2 = (x1-x0) * SWNVG_SUBPIXEL_ONE;
+
+	// Edge functions at the first pixel center, biased so that zero is inside only on top-left edges.
+	cx = (long long)minx * SWNVG_SUBPIXEL_ONE + SWNVG_SUBPIXEL_ONE/2;
+	cy = (long long)miny * SWNVG_SUBPIXEL_ONE + SWNVG_SUBPIXEL_ONE/2;
+	e0r = (x2-x1)*(cy-y1) - (y2-y1)*(cx-x1) - (swnvg__topLeft(x2-x1, y2-y1) ? 0 : 1);
+	e1r = (x0-x2)*(cy-y2) - (y0-y2)*(cx-x2) - (swnvg__topLeft(x0-x2, y0-y2) ? 0 : 1);
+	e2r = (x1-x0)*(cy-y0) - (y1-y0)*(cx-x0) - (swnvg__topLeft(x1-x0, y1-y0) ? 0 : 1);
+
+	if (mode != SWNVG_RASTER_STENCIL && swnvg__solidColor(r, v0, v1, v2, src, &ia)) {
+		solid = 1;
+		for (i = 0; i < 4; i++)
+			opaque[i] = (unsigned char)(swnvg__clampf(src[i], 0.0f, 255.0f) + 0.5f);
+	}
+
+	for (py = miny; py <= maxy; py++, e0r += sy0, e1r += sy1, e2r += sy2) {
+		unsigned char* st = &r->stencil[(py - r->clip[1])*SWNVG_TILE_SIZE - r->clip[0]];
+		k0 = 0;
+		k1 = maxx - minx;
+		swnvg__edgeSpan(e0r, sx0, &k0, &k1);
+		swnvg__edgeSpan(e1r, sx1, &k0, &k1);
+		swnvg__edgeSpan(e2r, sx2, &k0, &k1);
+		if (k0 > k1) continue;
+
+		if (mode == SWNVG_RASTER_STENCIL) {
+			unsigned char inc = front ? 1 : 255;
+			for (px = minx+k0; px <= minx+k1; px++)
+				st[px] += inc;
+			continue;
+		}
+
+		if (solid) {
+			// Blend of swnvg__shade() with the color terms computed once.
+			unsigned char* dst = &sw->pixels[py*sw->stride + (minx+k0)*4];
+			for (px = minx+k0; px <= minx+k1; px++, dst += 4) {
+				if (mode == SWNVG_RASTER_SHADE_OUTSIDE && st[px] != 0) continue;
+				if (mode == SWNVG_RASTER_SHADE_INSIDE) {
+					if (st[px] == 0) continue;
+					st[px] = 0;
+				}
+				if (ia == 0.0f) {
+					memcpy(dst, opaque, 4);
+				} else if (ia > 0.0f) {
+					for (i = 0; i < 4; i++)
+						dst[i] = (unsigned char)(swnvg__clampf(src[i] + dst[i]*ia, 0.0f, 255.0f) + 0.5f);
+				}
+			}
+			continue;
+		}
+
+		e0 = e0r + k0*sx0;
+		e1 = e1r + k0*sx1;
+		e2 = e2r + k0*sx2;
+		for (px = minx+k0; px <= minx+k1; px++, e0 += sx0, e1 += sx1, e2 += sx2) {
+			float w0, w1, w2;
+			if (mode == SWNVG_RASTER_SHADE_OUTSIDE && st[px] != 0) continue;	// Inside fill, covered later.
+			if (mode == SWNVG_RASTER_SHADE_INSIDE) {
+				if (st[px] == 0) continue;	// Outside fill.
+				st[px] = 0;
+			}
+			w0 = (float)e0 * iarea;
+			w1 = (float)e1 * iarea;
+			w2 = (float)e2 * iarea;
+			swnvg__shade(r, px, py, w0*v0->u + w1*v1->u + w2*v2->u, w0*v0->v + w1*v1->v + w2*v2->v);
+		}
+	}
+}
+
+static void swnvg__fan(struct SWNVGraster* r, const struct NVGvertex* verts, int count, int mode, int cull)
+{
+	int i;
+	for (i = 2; i < count; i++)
+		swnvg__triangle(r, &verts[0], &verts[i-1], &verts[i], mode, cull);
+}
+
+static void swnvg__strip(struct SWNVGraster* r, const struct NVGvertex* verts, int count, int mode, int cull)
+{
+	int i;
+	for (i = 2; i < count; i++) {
+		// Every other triangle is reversed to keep the winding consistent.
+		if (i & 1)
+			swnvg__triangle(r, &verts[i-1], &verts[i-2], &verts[i], mode, cull);
+		else
+			swnvg__triangle(r, &verts[i-2], &verts[i-1], &verts[i], mode, cull);
+	}
+}
+
+static void swnvg__drawCall(struct SWNVGraster* r, const struct SWNVGcall* call)
+{
+	struct SWNVGcontext* sw = r->sw;
+	const struct SWNVGpath* paths = &sw->paths[call->pathOffset];
+	const struct NVGvertex* verts = sw->verts;
+	int i;
+
+	r->paint = &sw->paints[call->paint];
+	r->tex = r->paint->image != 0 ? swnvg__findTexture(sw, r->paint->image) : NULL;
+	if (r->paint->type != SWNVG_SHADER_FILLGRAD && r->tex == NULL)
+		return;
+
+	if (call->type == SWNVG_FILL) {
+		for (i = 0; i < call->pathCount; i++)
+			swnvg__fan(r, &verts[paths[i].fillOffset], paths[i].fillCount, SWNVG_RASTER_STENCIL, 0);
+		if (sw->edgeAntiAlias) {
+			for (i = 0; i < call->pathCount; i++)
+				swnvg__strip(r, &verts[paths[i].strokeOffset], paths[i].strokeCount, SWNVG_RASTER_SHADE_OUTSIDE, 1);
+		}
+		swnvg__triangle(r, &verts[call->triangleOffset+0], &verts[call->triangleOffset+1], &verts[call->triangleOffset+2], SWNVG_RASTER_SHADE_INSIDE, 1);
+		swnvg__triangle(r, &verts[call->triangleOffset+3], &verts[call->triangleOffset+4], &verts[call->triangleOffset+5], SWNVG_RASTER_SHADE_INSIDE, 1);
+		// The cover quad clears the stencil, but a pixel on the quad edge may still be set.
+		for (i = r->clip[1]; i < r->clip[3]; i++)
+			memset(&r->stencil[(i - r->clip[1])*SWNVG_TILE_SIZE], 0, r->clip[2] - r->clip[0]);
+	} else if (call->type == SWNVG_CONVEXFILL) {
+		for (i = 0; i < call->pathCount; i++)
+			swnvg__fan(r, &verts[paths[i].fillOffset], paths[i].fillCount, SWNVG_RASTER_SHADE, 1);
+		if (sw->edgeAntiAlias) {
+			for (i = 0; i < call->pathCount; i++)
+				swnvg__strip(r, &verts[paths[i].strokeOffset], paths[i].strokeCount, SWNVG_RASTER_SHADE, 1);
+		}
+	} else if (call->type == SWNVG_STROKE) {
+		for (i = 0; i < call->pathCount; i++)
+			swnvg__strip(r, &verts[paths[i].strokeOffset], paths[i].strokeCount, SWNVG_RASTER_SHADE, 1);
+	} else if (call->type == SWNVG_TRIANGLES) {
+		for (i = 0; i+2 < call->triangleCount; i += 3) {
+			const struct NVGvertex* v = &verts[call->triangleOffset + i];
+			swnvg__triangle(r, &v[0], &v[1], &v[2], SWNVG_RASTER_SHADE, 1);
+		}
+	}
+}
+
+static void swnvg__drawTile(struct SWNVGcontext* sw, struct SWNVGworker* worker, int tile)
+{
+	struct SWNVGbin* bin = &sw->bins[tile];
+	struct SWNVGraster r;
+	int i, tx = tile % sw->tilesx, ty = tile / sw->tilesx;
+
+	r.sw = sw;
+	r.stencil = worker->stencil;
+	r.clip[0] = tx * SWNVG_TILE_SIZE;
+	r.clip[1] = ty * SWNVG_TILE_SIZE;
+	r.clip[2] = swnvg__mini(sw->width, r.clip[0] + SWNVG_TILE_SIZE);
+	r.clip[3] = swnvg__mini(sw->height, r.clip[1] + SWNVG_TILE_SIZE);
+
+	for (i = 0; i < bin->ncalls; i++) {
+		const struct SWNVGcall* call = &sw->calls[bin->calls[i]];
+		// Only the part of the call inside the tile is drawn.
+		r.clip[0] = swnvg__maxi(tx * SWNVG_TILE_SIZE, call->bounds[0]);
+		r.clip[1] = swnvg__maxi(ty * SWNVG_TILE_SIZE, call->bounds[1]);
+		r.clip[2] = swnvg__mini(swnvg__mini(sw->width, (tx+1) * SWNVG_TILE_SIZE), call->bounds[2]);
+		r.clip[3] = swnvg__mini(swnvg__mini(sw->height, (ty+1) * SWNVG_TILE_SIZE), call->bounds[3]);
+		r.stencil = &worker->stencil[(r.clip[1] - ty*SWNVG_TILE_SIZE)*SWNVG_TILE_SIZE + (r.clip[0] - tx*SWNVG_TILE_SIZE)];
+		swnvg__drawCall(&r, call);
+	}
+}
+
+// Takes next tile from own range, or steals one from the back of the other workers' ranges.
+static int swnvg__nextTile(struct SWNVGcontext* sw, int index)
+{
+	int i, begin, end;
+	long long range;
+
+	for (;;) {
+		range = swnvg__load(&sw->workers[index].range);
+		begin = (int)(range >> 32);
+		end = (int)(range & 0xffffffff);
+		if (begin >= end) break;
+		if (swnvg__cas(&sw->workers[index].range, range, swnvg__packRange(begin+1, end)))
+			return begin;
+	}
+
+	for (i = 1; i < sw->nworkers; i++) {
+		struct SWNVGworker* victim = &sw->workers[(index + i) % sw->nworkers];
+		for (;;) {
+			range = swnvg__load(&victim->range);
+			begin = (int)(range >> 32);
+			end = (int)(range & 0xffffffff);
+			if (begin >= end) break;
+			if (swnvg__cas(&victim->range, range, swnvg__packRange(begin, end-1)))
+				return end-1;
+		}
+	}
+
+	return -1;
+}
+
+static void swnvg__work(struct SWNVGcontext* sw, int index)
+{
+	int tile;
+	while ((tile = swnvg__nextTile(sw, index)) != -1)
+		swnvg__drawTile(sw, &sw->workers[index], tile);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI swnvg__workerThread(LPVOID arg)
+#else
+static void* swnvg__workerThread(void* arg)
+#endif
+{
+	struct SWNVGworker* worker = (struct SWNVGworker*)arg;
+	struct SWNVGcontext* sw = worker->sw;
+	int index = (int)(worker - sw->workers);
+	int frame = 0, quit = 0;
+
+	for (;;) {
+#ifdef _WIN32
+		EnterCriticalSection(&sw->lock);
+		while (sw->frame == frame && !sw->quit)
+			SleepConditionVariableCS(&sw->start, &sw->lock, INFINITE);
+		frame = sw->frame;
+		quit = sw->quit;
+		LeaveCriticalSection(&sw->lock);
+#else
+		pthread_mutex_lock(&sw->lock);
+		while (sw->frame == frame && !sw->quit)
+			pthread_cond_wait(&sw->start, &sw->lock);
+		frame = sw->frame;
+		quit = sw->quit;
+		pthread_mutex_unlock(&sw->lock);
+#endif
+		if (quit) break;
+
+		swnvg__work(sw, index);
+
+#ifdef _WIN32
+		EnterCriticalSection(&sw->lock);
+		sw->done++;
+		WakeConditionVariable(&sw->finish);
+		LeaveCriticalSection(&sw->lock);
+#else
+		pthread_mutex_lock(&sw->lock);
+		sw->done++;
+		pthread_cond_signal(&sw->finish);
+		pthread_mutex_unlock(&sw->lock);
+#endif
+	}
+
+	return 0;
+}
+
+static void swnvg__binCalls(struct SWNVGcontext* sw)
+{
+	int i, x, y, ntiles;
+
+	sw->tilesx = (sw->width + SWNVG_TILE_SIZE-1) / SWNVG_TILE_SIZE;
+	sw->tilesy = (sw->height + SWNVG_TILE_SIZE-1) / SWNVG_TILE_SIZE;
+	ntiles = sw->tilesx * sw->tilesy;
+	if (ntiles > sw->cbins) {
+		sw->bins = (struct SWNVGbin*)realloc(sw->bins, sizeof(struct SWNVGbin) * ntiles);
+		memset(&sw->bins[sw->cbins], 0, sizeof(struct SWNVGbin) * (ntiles - sw->cbins));
+		sw->cbins = ntiles;
+	}
+	for (i = 0; i < ntiles; i++)
+		sw->bins[i].ncalls = 0;
+
+	for (i = 0; i < sw->ncalls; i++) {
+		const struct SWNVGcall* call = &sw->calls[i];
+		int x0, y0, x1, y1;
+		if (call->bounds[0] >= call->bounds[2] || call->bounds[1] >= call->bounds[3]) continue;
+		x0 = call->bounds[0] / SWNVG_TILE_SIZE;
+		y0 = call->bounds[1] / SWNVG_TILE_SIZE;
+		x1 = (call->bounds[2]-1) / SWNVG_TILE_SIZE;
+		y1 = (call->bounds[3]-1) / SWNVG_TILE_SIZE;
+		for (y = y0; y <= y1; y++) {
+			for (x = x0; x <= x1; x++) {
+				struct SWNVGbin* bin = &sw->bins[y*sw->tilesx + x];
+				if (bin->ncalls+1 > bin->ccalls) {
+					bin->ccalls = bin->ccalls == 0 ? 64 : bin->ccalls*2;
+					bin->calls = (int*)realloc(bin->calls, sizeof(int) * bin->ccalls);
+				}
+				bin->calls[bin->ncalls++] = i;
+			}
+		}
+	}
+}
+
+static void swnvg__renderFlush(void* uptr, int alphaBlend)
+{
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)uptr;
+	int i, ntiles, per;
+
+	sw->alphaBlend = alphaBlend;
+
+	if (sw->ncalls > 0 && sw->pixels != NULL && sw->view[0] > 0 && sw->view[1] > 0) {
+		swnvg__binCalls(sw);
+
+		// Split the tiles evenly, idle workers steal from the busy ones.
+		ntiles = sw->tilesx * sw->tilesy;
+		per = (ntiles + sw->nworkers-1) / sw->nworkers;
+		for (i = 0; i < sw->nworkers; i++)
+			sw->workers[i].range = swnvg__packRange(swnvg__mini(ntiles, i*per), swnvg__mini(ntiles, (i+1)*per));
+
+		if (sw->nworkers > 1) {
+#ifdef _WIN32
+			EnterCriticalSection(&sw->lock);
+			sw->done = 0;
+			sw->frame++;
+			WakeAllConditionVariable(&sw->start);
+			LeaveCriticalSection(&sw->lock);
+#else
+			pthread_mutex_lock(&sw->lock);
+			sw->done = 0;
+			sw->frame++;
+			pthread_cond_broadcast(&sw->start);
+			pthread_mutex_unlock(&sw->lock);
+#endif
+		}
+
+		swnvg__work(sw, 0);
+
+		if (sw->nworkers > 1) {
+#ifdef _WIN32
+			EnterCriticalSection(&sw->lock);
+			while (sw->done < sw->nworkers-1)
+				SleepConditionVariableCS(&sw->finish, &sw->lock, INFINITE);
+			LeaveCriticalSection(&sw->lock);
+#else
+			pthread_mutex_lock(&sw->lock);
+			while (sw->done < sw->nworkers-1)
+				pthread_cond_wait(&sw->finish, &sw->lock);
+			pthread_mutex_unlock(&sw->lock);
+#endif
+		}
+	}
+
+	// Reset calls
+	sw->nverts = 0;
+	sw->npaths = 0;
+	sw->ncalls = 0;
+	sw->npaints = 0;
+}
+
+static void swnvg__renderDelete(void* uptr)
+{
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)uptr;
+	int i;
+	if (sw == NULL) return;
+
+	if (sw->nworkers > 1) {
+#ifdef _WIN32
+		EnterCriticalSection(&sw->lock);
+		sw->quit = 1;
+		WakeAllConditionVariable(&sw->start);
+		LeaveCriticalSection(&sw->lock);
+		for (i = 1; i < sw->nworkers; i++) {
+			WaitForSingleObject(sw->workers[i].thread, INFINITE);
+			CloseHandle(sw->workers[i].thread);
+		}
+		DeleteCriticalSection(&sw->lock);
+#else
+		pthread_mutex_lock(&sw->lock);
+		sw->quit = 1;
+		pthread_cond_broadcast(&sw->start);
+		pthread_mutex_unlock(&sw->lock);
+		for (i = 1; i < sw->nworkers; i++)
+			pthread_join(sw->workers[i].thread, NULL);
+		pthread_mutex_destroy(&sw->lock);
+		pthread_cond_destroy(&sw->start);
+		pthread_cond_destroy(&sw->finish);
+#endif
+	}
+
+	for (i = 0; i < sw->ntextures; i++)
+		free(sw->textures[i].data);
+	free(sw->textures);
+	for (i = 0; i < sw->cbins; i++)
+		free(sw->bins[i].calls);
+	free(sw->bins);
+	free(sw->calls);
+	free(sw->paths);
+	free(sw->verts);
+	free(sw->paints);
+
+	free(sw);
+}
+
+struct NVGcontext* nvgCreateSW(int atlasw, int atlash, int edgeaa, int threads)
+{
+	struct NVGparams params;
+	struct NVGcontext* ctx = NULL;
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)malloc(sizeof(struct SWNVGcontext));
+	int i;
+	if (sw == NULL) goto error;
+	memset(sw, 0, sizeof(struct SWNVGcontext));
+
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = swnvg__renderCreate;
+	params.renderCreateTexture = swnvg__renderCreateTexture;
+	params.renderDeleteTexture = swnvg__renderDeleteTexture;
+	params.renderUpdateTexture = swnvg__renderUpdateTexture;
+	params.renderGetTextureSize = swnvg__renderGetTextureSize;
+	params.renderViewport = swnvg__renderViewport;
+	params.renderFlush = swnvg__renderFlush;
+	params.renderFill = swnvg__renderFill;
+	params.renderStroke = swnvg__renderStroke;
+	params.renderTriangles = swnvg__renderTriangles;
+	params.userPtr = sw;
+	params.atlasWidth = atlasw;
+	params.atlasHeight = atlash;
+	params.edgeAntiAlias = edgeaa;
+	params.bufferedRender = 1;
+
+	sw->edgeAntiAlias = edgeaa;
+
+	// Start workers
+	sw->nworkers = swnvg__maxi(1, swnvg__mini(threads, SWNVG_MAX_THREADS));
+	for (i = 0; i < sw->nworkers; i++)
+		sw->workers[i].sw = sw;
+	if (sw->nworkers > 1) {
+#ifdef _WIN32
+		InitializeCriticalSection(&sw->lock);
+		InitializeConditionVariable(&sw->start);
+		InitializeConditionVariable(&sw->finish);
+#else
+		pthread_mutex_init(&sw->lock, NULL);
+		pthread_cond_init(&sw->start, NULL);
+		pthread_cond_init(&sw->finish, NULL);
+#endif
+		for (i = 1; i < sw->nworkers; i++) {
+#ifdef _WIN32
+			sw->workers[i].thread = CreateThread(NULL, 0, swnvg__workerThread, &sw->workers[i], 0, NULL);
+			if (sw->workers[i].thread == NULL) break;
+#else
+			if (pthread_create(&sw->workers[i].thread, NULL, swnvg__workerThread, &sw->workers[i]) != 0) break;
+#endif
+		}
+		// Run with the threads we got.
+		if (i < sw->nworkers) {
+			sw->nworkers = i;
+			if (sw->nworkers == 1) {
+#ifdef _WIN32
+				DeleteCriticalSection(&sw->lock);
+#else
+				pthread_mutex_destroy(&sw->lock);
+				pthread_cond_destroy(&sw->start);
+				pthread_cond_destroy(&sw->finish);
+#endif
+			}
+		}
+	}
+
+	// The back-end is deleted by nvgDeleteInternal() only after the context is created,
+	// nvgCreateInternal() may fail before it has a context to delete it with.
+	ctx = nvgCreateInternal(&params);
+	if (ctx == NULL) goto error;
+	nvgInternalParams(ctx)->renderDelete = swnvg__renderDelete;
+
+	return ctx;
+
+error:
+	swnvg__renderDelete(sw);
+	return NULL;
+}
+
+void nvgDeleteSW(struct NVGcontext* ctx)
+{
+	nvgDeleteInternal(ctx);
+}
+
+void nvgSetTargetSW(struct NVGcontext* ctx, unsigned char* rgba, int width, int height, int stride)
+{
+	struct SWNVGcontext* sw = (struct SWNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	sw->pixels = rgba;
+	sw->width = width;
+	sw->height = height;
+	sw->stride = stride;
+	swnvg__updateScale(sw);
+}
+
+#endif
@@ -80,3 +80,223 @@ solution "mgui"
 		configuration "Release"
 			defines { "NDEBUG" }
 			flags { "Optimize", "ExtraWarnings"}    
+
+	project "bench3"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/bench3.c", "src/milli2.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "src", "lib/nanovg", "lib/nanosvg" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "m", "rt", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}    
+
+	project "uic"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/uic.c", "src/milli.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "src", "lib/nanovg", "lib/nanosvg" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "m", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	project "swbench"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/swbench.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "lib/nanovg" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "m", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	project "nvgreplay"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/nvgreplay.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "lib/nanovg" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "m", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	project "tessbench"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/tessbench.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "lib/nanovg" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "m", "rt", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	project "simdcheck"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/simdcheck.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "lib/nanovg" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "m", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	project "simdcheck_scalar"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/simdcheck.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "lib/nanovg" }
+		defines { "NVG_NO_SIMD" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "m", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	project "glbench"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/swbench.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "lib/nanovg" }
+		defines { "SWBENCH_GL" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "EGL", "GL", "m", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	project "glbench_nomerge"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/swbench.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "lib/nanovg" }
+		defines { "SWBENCH_GL", "NANOVG_GL_NO_INDICES" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "EGL", "GL", "m", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	project "glbench_orphan"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/swbench.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "lib/nanovg" }
+		defines { "SWBENCH_GL", "NANOVG_GL_NO_PERSISTENT_MAP" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "EGL", "GL", "m", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	project "millicheck"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/millicheck.c", "src/milli.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "src", "lib/nanovg", "lib/nanosvg" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "m", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
+
+	project "mguicheck"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/mguicheck.c", "src/mgui.c", "lib/nanovg/nanovg.c", "lib/nanovg/stb_image.c" }
+		includedirs { "src", "lib/nanovg", "lib/nanosvg" }
+		targetdir("build")
+	 
+		configuration { "linux" }
+			 links { "m", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
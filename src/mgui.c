@@ -284,6 +284,7 @@ static void deleteIcons()
 #define MG_MAX_PANELS 100
 #define MG_MAX_TAGS 100
 #define MG_STATE_POOL_SIZE 4096
+#define MG_INPUT_QUEUE_SIZE 256
 
 struct MGstateHeader {
 	unsigned int id;
@@ -295,9 +296,26 @@ struct MGidRange {
 	unsigned int base, count;
 };
 
+enum MGinputEventType {
+	MG_INPUT_MOVE,
+	MG_INPUT_PRESS,
+	MG_INPUT_RELEASE,
+	MG_INPUT_KEY,
+};
+
+struct MGinputEvent {
+	int type;
+	double time;
+	float mx, my;
+	struct MGkeyPress key;
+};
+
 struct MGcontext
 {
 	struct MGinputState input;
+	struct MGinputEvent inputQueue[MG_INPUT_QUEUE_SIZE];
+	int inputHead, inputCount;
+	int inputButtonDown;	// Button state after the last queued event.
 	float startmx, startmy;
 	float deltamx, deltamy;
 	int moved;
@@ -1241,16 +1259,164 @@ void mgTerminate()
 	deleteIcons();
 }
 
+// Makes room in the full queue by removing one mouse move. The earlier of two consecutive
+// moves goes first since the later one overrides it, otherwise the oldest move is removed.
+// Presses, releases and keys are never removed.
+static int dropInputMove()
+{
+	struct MGinputEvent* q = context.inputQueue;
+	int i, idx = -1;
+	for (i = 0; i < context.inputCount; i++) {
+		int cur = (context.inputHead + i) % MG_INPUT_QUEUE_SIZE;
+		int next = (cur+1) % MG_INPUT_QUEUE_SIZE;
+		if (q[cur].type != MG_INPUT_MOVE) continue;
+		if (idx == -1)
+			idx = i;
+		if (i+1 < context.inputCount && q[next].type == MG_INPUT_MOVE) {
+			idx = i;
+			break;
+		}
+	}
+	if (idx == -1) return 0;
+	for (i = idx; i+1 < context.inputCount; i++)
+		q[(context.inputHead + i) % MG_INPUT_QUEUE_SIZE] = q[(context.inputHead + i+1) % MG_INPUT_QUEUE_SIZE];
+	context.inputCount--;
+	return 1;
+}
+
+static struct MGinputEvent* pushInputEvent(int type, double time)
+{
+	struct MGinputEvent* e;
+	if (context.inputCount >= MG_INPUT_QUEUE_SIZE && !dropInputMove()) return NULL;
+	e = &context.inputQueue[(context.inputHead + context.inputCount) % MG_INPUT_QUEUE_SIZE];
+	context.inputCount++;
+	memset(e, 0, sizeof(*e));
+	e->type = type;
+	e->time = time;
+	return e;
+}
+
+int mgPushMouseMove(double time, float mx, float my)
+{
+	struct MGinputEvent* e = NULL;
+	// Consecutive moves are merged while no button is down, then only the latest position matters.
+	// Drags keep every move.
+	if (context.inputCount > 0 && !context.inputButtonDown) {
+		e = &context.inputQueue[(context.inputHead + context.inputCount-1) % MG_INPUT_QUEUE_SIZE];
+		if (e->type != MG_INPUT_MOVE)
+			e = NULL;
+	}
+	if (e == NULL)
+		e = pushInputEvent(MG_INPUT_MOVE, time);
+	if (e == NULL) return 0;
+	e->time = time;
+	e->mx = mx;
+	e->my = my;
+	return 1;
+}
+
+int mgPushMouseButton(double time, float mx, float my, int pressed)
+{
+	struct MGinputEvent* e = pushInputEvent(pressed ? MG_INPUT_PRESS : MG_INPUT_RELEASE, time);
+	if (e == NULL) return 0;
+	e->mx = mx;
+	e->my = my;
+	context.inputButtonDown = pressed;
+	return 1;
+}
+
+int mgPushKey(double time, int type, int code, int mods)
+{
+	struct MGinputEvent* e = pushInputEvent(MG_INPUT_KEY, time);
+	if (e == NULL) return 0;
+	e->key.type = type;
+	e->key.code = code;
+	e->key.mods = mods;
+	return 1;
+}
+
+// Moves queued events into the input state of one frame. A frame can see only one mouse
+// position, so the frame ends at the first event which would change the outcome of an
+// already consumed press or release. The rest of the events are left for the next frames.
+static void consumeInputEvents(struct MGinputState* input)
+{
+	int buttons = 0;
+	while (context.inputCount > 0) {
+		struct MGinputEvent* e = &context.inputQueue[context.inputHead];
+		if (e->type == MG_INPUT_MOVE) {
+			if (buttons != 0) break;
+			input->mx = e->mx;
+			input->my = e->my;
+		} else if (e->type == MG_INPUT_PRESS) {
+			// Keys are sent after press, which may change focus.
+			if (buttons != 0 || input->nkeys > 0) break;
+			input->mx = e->mx;
+			input->my = e->my;
+			input->mbut |= MG_MOUSE_PRESSED;
+			buttons |= MG_MOUSE_PRESSED;
+		} else if (e->type == MG_INPUT_RELEASE) {
+			// Press and release are allowed in same frame if the mouse did not move between.
+			if (buttons & MG_MOUSE_RELEASED) break;
+			if ((buttons & MG_MOUSE_PRESSED) && (e->mx != input->mx || e->my != input->my)) break;
+			input->mx = e->mx;
+			input->my = e->my;
+			input->mbut |= MG_MOUSE_RELEASED;
+			buttons |= MG_MOUSE_RELEASED;
+		} else if (e->type == MG_INPUT_KEY) {
+			if (input->nkeys >= MG_MAX_INPUTKEYS) break;
+			input->keys[input->nkeys++] = e->key;
+		}
+		context.inputHead = (context.inputHead+1) % MG_INPUT_QUEUE_SIZE;
+		context.inputCount--;
+	}
+}
+
+// Rasterizes the glyphs used by the widgets up front, so that the first frames do not hitch.
+// With font workers the sets are rasterized in parallel.
+static void prewarmGlyphs(struct NVGcontext* vg)
+{
+	static const int sizes[] = { TEXT_SIZE, LABEL_SIZE };
+	char glyphs[128];
+	int i, n = 0;
+
+	for (i = ' '; i <= '~'; i++)
+		glyphs[n++] = (char)i;
+	glyphs[n] = '\0';
+
+	nvgSave(vg);
+	nvgFontFace(vg, "sans");
+	for (i = 0; i < (int)(sizeof(sizes)/sizeof(sizes[0])); i++) {
+		nvgFontSize(vg, sizes[i]);
+		nvgTextPrepare(vg, glyphs, NULL);
+	}
+	nvgRestore(vg);
+	nvgWaitTextPrepare(vg);
+}
+
 void mgFrameBegin(struct NVGcontext* vg, int width, int height, struct MGinputState* input, float dt)
 {
-	context.moved = absf(context.input.mx - input->mx) > 0.01f || absf(context.input.my - input->my) > 0.01f;
-	memcpy(&context.input, input, sizeof(*input));
+	struct MGinputState frameInput;
+
+	// Without input state, the mouse stays where the last queued event left it.
+	if (input != NULL) {
+		memcpy(&frameInput, input, sizeof(frameInput));
+	} else {
+		memset(&frameInput, 0, sizeof(frameInput));
+		frameInput.mx = context.input.mx;
+		frameInput.my = context.input.my;
+	}
+	consumeInputEvents(&frameInput);
+
+	context.moved = absf(context.input.mx - frameInput.mx) > 0.01f || absf(context.input.my - frameInput.my) > 0.01f;
+	memcpy(&context.input, &frameInput, sizeof(frameInput));
 
 	context.width = width;
 	context.height = height;
 
 	context.dt = dt;
 
+	if (context.vg != vg)
+		prewarmGlyphs(vg);
 	context.vg = vg;
 
 	context.boxStackCount = 0;
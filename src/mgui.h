@@ -253,9 +253,19 @@ struct MGinputState
 	int nkeys;	
 };
 
+// Input state can be NULL when all input is pushed to the event queue.
 void mgFrameBegin(struct NVGcontext* vg, int width, int height, struct MGinputState* input, float dt);
 void mgFrameEnd();
 
+// Queues timestamped input events, mgFrameBegin() consumes them in order. Each frame takes events
+// until one would be merged with an earlier press or release, the rest are left for the next frames.
+// Consecutive mouse moves are merged while no button is down. When the queue is full, mouse moves
+// are dropped to make room for the new event. Returns 0 if the queue is full of buttons and keys.
+// The time is only used to order the events, it is not passed on to the widgets.
+int mgPushMouseMove(double time, float mx, float my);
+int mgPushMouseButton(double time, float mx, float my, int pressed);
+int mgPushKey(double time, int type, int code, int mods);
+
 int mgCreateIcon(const char* name, const char* filename);
 
 unsigned int mgPanelBegin(int dir, float x, float y, int zidx, struct MGopt* opts);
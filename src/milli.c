@@ -5,6 +5,12 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include "nanosvg.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
 
 
 static int mini(int a, int b) { return a < b ? a : b; }
@@ -183,6 +189,302 @@ static void drawIcon(struct NVGcontext* vg, struct MIrect* rect, struct NSVGimag
 }
 
 
+// Cells and vars are allocated from fixed size slabs, and ids, var names and keys
+// are interned into a string pool, so that building a large tree takes only a few
+// allocations. Interned strings are reference counted and released with the cells,
+// a string chunk is freed when none of its strings are used. Param keys and var names
+// have atoms and stay until miTerminate().
+#define MI_MAX_SLABS 8
+#define MI_SLAB_ITEMS 256
+#define MI_STRING_CHUNK_SIZE 4096
+
+struct MIslabChunk {
+	struct MIslabChunk* next;
+};
+
+struct MIslab {
+	int itemSize;
+	struct MIslabChunk* chunks;
+	void* freeList;
+};
+
+struct MIstringChunk {
+	struct MIstringChunk* next;
+	int size, cap;
+	int live;	// Number of strings in the chunk which are still in the table.
+};
+
+struct MIstring {
+	const char* str;
+	struct MIstringChunk* chunk;
+	int refs;
+	int atom;	// Small index given to strings used as param keys, or -1. Strings with atom are never released.
+};
+
+static struct MIslab slabs[MI_MAX_SLABS];
+static int slabCount = 0;
+static int varSlab = -1;
+
+static struct MIstringChunk* stringChunks = NULL;
+static struct MIstring* stringTable = NULL;
+static int stringTableSize = 0;
+static int stringCount = 0;
+static int atomCount = 0;
+
+static int milli__getSlab(int size)
+{
+	int i;
+	// Round up so that the items can hold a free list pointer and stay aligned.
+	size = (size + (int)sizeof(void*)-1) & ~((int)sizeof(void*)-1);
+	for (i = 0; i < slabCount; i++) {
+		if (slabs[i].itemSize == size)
+			return i;
+	}
+	if (slabCount >= MI_MAX_SLABS)
+		return -1;
+	slabs[slabCount].itemSize = size;
+	slabs[slabCount].chunks = NULL;
+	slabs[slabCount].freeList = NULL;
+	return slabCount++;
+}
+
+static void* milli__slabAlloc(int slabIdx)
+{
+	struct MIslab* slab = &slabs[slabIdx];
+	void* item = NULL;
+
+	if (slab->freeList == NULL) {
+		// Allocate new chunk and thread its items to the free list.
+		int i;
+		unsigned char* items;
+		struct MIslabChunk* chunk = (struct MIslabChunk*)malloc(sizeof(struct MIslabChunk) + slab->itemSize * MI_SLAB_ITEMS);
+		if (chunk == NULL) return NULL;
+		chunk->next = slab->chunks;
+		slab->chunks = chunk;
+		items = (unsigned char*)(chunk+1);
+		for (i = MI_SLAB_ITEMS-1; i >= 0; i--) {
+			void** it = (void**)(items + i * slab->itemSize);
+			*it = slab->freeList;
+			slab->freeList = it;
+		}
+	}
+
+	item = slab->freeList;
+	slab->freeList = *(void**)item;
+	memset(item, 0, slab->itemSize);
+	return item;
+}
+
+static void milli__slabFree(int slabIdx, void* item)
+{
+	struct MIslab* slab = &slabs[slabIdx];
+	if (item == NULL) return;
+	*(void**)item = slab->freeList;
+	slab->freeList = item;
+}
+
+static void milli__deleteSlabs()
+{
+	int i;
+	for (i = 0; i < slabCount; i++) {
+		struct MIslabChunk* chunk = slabs[i].chunks;
+		while (chunk != NULL) {
+			struct MIslabChunk* next = chunk->next;
+			free(chunk);
+			chunk = next;
+		}
+	}
+	memset(slabs, 0, sizeof(slabs));
+	slabCount = 0;
+	varSlab = -1;
+}
+
+static void* milli__allocCell(int size)
+{
+	struct MIcell* cell = NULL;
+	int slab = milli__getSlab(size);
+	if (slab == -1) {
+		cell = (struct MIcell*)calloc(1, size);
+		if (cell == NULL) return NULL;
+		cell->slab = 0xff;
+		return cell;
+	}
+	cell = (struct MIcell*)milli__slabAlloc(slab);
+	if (cell == NULL) return NULL;
+	cell->slab = (unsigned char)slab;
+	return cell;
+}
+
+static void milli__releaseCell(struct MIcell* cell)
+{
+	if (cell->slab == 0xff)
+		free(cell);
+	else
+		milli__slabFree(cell->slab, cell);
+}
+
+static unsigned int milli__hashString(const char* s)
+{
+	// FNV-1a
+	unsigned int h = 2166136261u;
+	while (*s) {
+		h ^= (unsigned char)*s++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static const char* milli__storeString(const char* s, int len, struct MIstringChunk** owner)
+{
+	struct MIstringChunk* chunk = stringChunks;
+	char* dst;
+	if (chunk == NULL || chunk->size + len+1 > chunk->cap) {
+		int cap = maxi(MI_STRING_CHUNK_SIZE, len+1);
+		chunk = (struct MIstringChunk*)malloc(sizeof(struct MIstringChunk) + cap);
+		if (chunk == NULL) return NULL;
+		chunk->size = 0;
+		chunk->cap = cap;
+		chunk->live = 0;
+		chunk->next = stringChunks;
+		stringChunks = chunk;
+	}
+	dst = (char*)(chunk+1) + chunk->size;
+	memcpy(dst, s, len+1);
+	chunk->size += len+1;
+	chunk->live++;
+	*owner = chunk;
+	return dst;
+}
+
+static void milli__releaseChunk(struct MIstringChunk* chunk)
+{
+	struct MIstringChunk** prev = &stringChunks;
+	chunk->live--;
+	if (chunk->live > 0) return;
+	// The newest chunk is kept for the next strings.
+	if (chunk == stringChunks) {
+		chunk->size = 0;
+		return;
+	}
+	while (*prev != NULL && *prev != chunk)
+		prev = &(*prev)->next;
+	if (*prev == chunk)
+		*prev = chunk->next;
+	free(chunk);
+}
+
+static int milli__growStringTable()
+{
+	int i, newSize = stringTableSize == 0 ? 256 : stringTableSize*2;
+	struct MIstring* newTable = (struct MIstring*)calloc(newSize, sizeof(struct MIstring));
+	if (newTable == NULL) return 0;
+	for (i = 0; i < stringTableSize; i++) {
+		unsigned int h;
+		if (stringTable[i].str == NULL) continue;
+		h = milli__hashString(stringTable[i].str) & (newSize-1);
+		while (newTable[h].str != NULL)
+			h = (h+1) & (newSize-1);
+		newTable[h] = stringTable[i];
+	}
+	free(stringTable);
+	stringTable = newTable;
+	stringTableSize = newSize;
+	return 1;
+}
+
+static struct MIstring* milli__internEntry(const char* s)
+{
+	unsigned int h;
+	if (s == NULL) return NULL;
+	if ((stringCount+1)*2 > stringTableSize) {
+		if (!milli__growStringTable())
+			return NULL;
+	}
+	h = milli__hashString(s) & (stringTableSize-1);
+	while (stringTable[h].str != NULL) {
+		if (strcmp(stringTable[h].str, s) == 0)
+			return &stringTable[h];
+		h = (h+1) & (stringTableSize-1);
+	}
+	stringTable[h].str = milli__storeString(s, (int)strlen(s), &stringTable[h].chunk);
+	if (stringTable[h].str == NULL) return NULL;
+	stringTable[h].refs = 0;
+	stringTable[h].atom = -1;
+	stringCount++;
+	return &stringTable[h];
+}
+
+// Returns pooled copy of the string, equal strings return the same pointer.
+// Each call adds a reference, release the string with milli__releaseString().
+static const char* milli__internString(const char* s)
+{
+	struct MIstring* e = milli__internEntry(s);
+	if (e == NULL) return NULL;
+	e->refs++;
+	return e->str;
+}
+
+// Removes the reference added by milli__internString(), the string is removed
+// from the table when it is not used anymore.
+static void milli__releaseString(const char* s)
+{
+	unsigned int i, j, mask = (unsigned int)stringTableSize-1;
+	struct MIstringChunk* chunk;
+	if (s == NULL || stringTableSize == 0) return;
+	i = milli__hashString(s) & mask;
+	while (stringTable[i].str != NULL && stringTable[i].str != s)
+		i = (i+1) & mask;
+	if (stringTable[i].str == NULL) return;
+	if (stringTable[i].refs > 0)
+		stringTable[i].refs--;
+	if (stringTable[i].refs > 0 || stringTable[i].atom != -1) return;
+
+	chunk = stringTable[i].chunk;
+	stringCount--;
+	// Shift the following entries of the probe sequence back to fill the hole.
+	j = i;
+	for (;;) {
+		unsigned int k;
+		j = (j+1) & mask;
+		if (stringTable[j].str == NULL) break;
+		k = milli__hashString(stringTable[j].str) & mask;
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+		stringTable[i] = stringTable[j];
+		i = j;
+	}
+	memset(&stringTable[i], 0, sizeof(stringTable[i]));
+	// The string is not accessed after this, the chunk may be freed.
+	milli__releaseChunk(chunk);
+}
+
+// Returns small index for the param key or var name, equal strings return the same atom.
+// Templates use the atom to index their var table directly, returns -1 on failure.
+static int milli__internAtom(const char* s)
+{
+	struct MIstring* e = milli__internEntry(s);
+	if (e == NULL) return -1;
+	if (e->atom == -1)
+		e->atom = atomCount++;
+	return e->atom;
+}
+
+static void milli__deleteStrings()
+{
+	while (stringChunks != NULL) {
+		struct MIstringChunk* next = stringChunks->next;
+		free(stringChunks);
+		stringChunks = next;
+	}
+	free(stringTable);
+	stringTable = NULL;
+	stringTableSize = 0;
+	stringCount = 0;
+	atomCount = 0;
+}
+
+static void milli__invalidateBindings(struct MIcell* cell);
+
 static struct MIvar* milli__findVar(struct MIcell* cell, const char* name)
 {
 	struct MIvar* v;
@@ -191,7 +493,6 @@ static struct MIvar* milli__findVar(struct MIcell* cell, const char* name)
 	if (cell->vars == NULL) return NULL;
 	if (name == NULL) return NULL;
 	for (v = cell->vars; v != NULL; v = v->next) {
-		printf("%p %s==%s\n", cell, v->name, name);
 		if (strcmp(v->name, name) == 0)
 			return v;
 	}
@@ -214,27 +515,33 @@ static void milli__addVar(struct MIcell* cell, const char* name, const char* key
 		return;
 
 	// Create new var
-	var = (struct MIvar*)calloc(1, sizeof(struct MIvar));
+	if (varSlab == -1)
+		varSlab = milli__getSlab(sizeof(struct MIvar));
+	if (varSlab == -1) goto error;
+	var = (struct MIvar*)milli__slabAlloc(varSlab);
 	if (var == NULL) goto error;
 	// Store name
-	var->name = strdup(name);
+	var->name = milli__internString(name);
 	if (var->name == NULL) goto error;
+	var->atom = milli__internAtom(name);
+	if (var->atom == -1) goto error;
 	// Store key
-	var->key = strdup(key);
+	var->key = milli__internString(key);
 	if (var->key == NULL) goto error;
 	// Add to linked list
 	prev = &cell->vars;
 	while (*prev != NULL)
 		prev = &(*prev)->next;
 	*prev = var;
+	milli__invalidateBindings(cell);
 
 	return;
 
 error:
 	if (var != NULL) {
-		free(var->name);
-		free(var->key);
-		free(var);
+		milli__releaseString(var->name);
+		milli__releaseString(var->key);
+		milli__slabFree(varSlab, var);
 	}
 }
 
@@ -242,9 +549,9 @@ static void milli__freeVars(struct MIvar* v)
 {
 	while (v != NULL) {
 		struct MIvar* next = v->next;
-		free(v->name);
-		free(v->key);
-		free(v);
+		milli__releaseString(v->name);
+		milli__releaseString(v->key);
+		milli__slabFree(varSlab, v);
 		v = next;
 	}
 }
@@ -255,6 +562,360 @@ static int milli_pointInRect(float x, float y, struct MIrect r)
    return x >= r.x &&x <= r.x+r.width && y >= r.y && y <= r.y+r.height;
 }
 
+// Returns true if the rect is inside view, NULL view is unbounded.
+static int milli__rectInView(struct MIrect* view, struct MIrect r)
+{
+	if (view == NULL) return 1;
+	return r.x <= view->x+view->width && r.x+r.width >= view->x && r.y <= view->y+view->height && r.y+r.height >= view->y;
+}
+
+static struct MIrect milli__intersectRects(struct MIrect a, struct MIrect b)
+{
+	struct MIrect r;
+	r.x = maxf(a.x, b.x);
+	r.y = maxf(a.y, b.y);
+	r.width = maxf(0, minf(a.x+a.width, b.x+b.width) - r.x);
+	r.height = maxf(0, minf(a.y+a.height, b.y+b.height) - r.y);
+	return r;
+}
+
+static int milli__rectEquals(struct MIrect a, struct MIrect b)
+{
+	return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+enum MIdirtyFlags {
+	MI_DIRTY_MEASURE = 1 << 0,
+	MI_DIRTY_LAYOUT = 1 << 1,
+	MI_DIRTY_ALL = MI_DIRTY_MEASURE | MI_DIRTY_LAYOUT,
+};
+
+// Marks cell and its ancestors to need measure and layout.
+// The ancestors of a dirty cell are always dirty, so we can stop at first dirty one.
+static void milli__markDirty(struct MIcell* cell)
+{
+	for (; cell != NULL; cell = cell->parent) {
+		if (cell->dirty == MI_DIRTY_ALL)
+			break;
+		cell->dirty = MI_DIRTY_ALL;
+	}
+}
+
+static void milli__measureCell(struct MIcell* cell, struct NVGcontext* vg)
+{
+	if (!(cell->dirty & MI_DIRTY_MEASURE)) return;
+	if (cell->measure != NULL)
+		cell->measure(cell, vg);
+	else
+		cell->content.width = cell->content.height = 0;
+	cell->dirty &= ~MI_DIRTY_MEASURE;
+}
+
+static int milli__layoutCell(struct MIcell* cell, struct NVGcontext* vg)
+{
+	int reflow = 0;
+	// Layout only if something changed inside the cell or it got a new frame.
+	if (!(cell->dirty & MI_DIRTY_LAYOUT) && milli__rectEquals(cell->frame, cell->layoutFrame))
+		return 0;
+	if (cell->layout != NULL)
+		reflow = cell->layout(cell, vg);
+	cell->layoutFrame = cell->frame;
+	cell->dirty &= ~MI_DIRTY_LAYOUT;
+	return reflow;
+}
+
+
+// Parallel measure
+// Leaf cells do most of the measuring work (text metrics) and do not depend on each other,
+// so the dirty leaves are measured on worker threads first. Each worker has its own headless
+// nanovg context for font metrics. The interior cells are then measured on the calling thread,
+// which only combines the already measured child sizes.
+
+#define MI_MAX_MEASURE_THREADS 16
+#define MI_MAX_MEASURE_FONTS 16
+#define MI_MIN_PARALLEL_CELLS 512	// Don't bother with threads for smaller batches.
+#define MI_MEASURE_ATLAS_SIZE 1024
+
+struct MImeasureFont {
+	char* name;
+	char* filename;
+};
+
+struct MImeasureWorker {
+	struct NVGcontext* vg;
+	struct MIcell** cells;
+	int count;
+#ifdef _WIN32
+	HANDLE thread;
+#else
+	pthread_t thread;
+#endif
+};
+
+static struct MImeasureWorker measureWorkers[MI_MAX_MEASURE_THREADS];
+static int measureWorkerCount = 0;
+static struct MImeasureFont measureFonts[MI_MAX_MEASURE_FONTS];
+static int measureFontCount = 0;
+static struct MIcell** measureLeaves = NULL;
+static int measureLeafCount = 0;
+static int measureLeafCap = 0;
+
+// The measure contexts never render, the texture calls just need to succeed.
+static int milli__measureRenderCreate(void* uptr)
+{
+	MILLI_NOTUSED(uptr);
+	return 1;
+}
+
+static int milli__measureCreateTexture(void* uptr, int type, int w, int h, const unsigned char* data)
+{
+	MILLI_NOTUSED(uptr); MILLI_NOTUSED(type); MILLI_NOTUSED(w); MILLI_NOTUSED(h); MILLI_NOTUSED(data);
+	return 1;
+}
+
+static int milli__measureDeleteTexture(void* uptr, int image)
+{
+	MILLI_NOTUSED(uptr); MILLI_NOTUSED(image);
+	return 1;
+}
+
+static int milli__measureUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	MILLI_NOTUSED(uptr); MILLI_NOTUSED(image); MILLI_NOTUSED(x); MILLI_NOTUSED(y);
+	MILLI_NOTUSED(w); MILLI_NOTUSED(h); MILLI_NOTUSED(data);
+	return 1;
+}
+
+static int milli__measureGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	MILLI_NOTUSED(uptr); MILLI_NOTUSED(image);
+	*w = *h = MI_MEASURE_ATLAS_SIZE;
+	return 1;
+}
+
+static void milli__measureRenderDelete(void* uptr)
+{
+	MILLI_NOTUSED(uptr);
+}
+
+static struct NVGcontext* milli__createMeasureContext()
+{
+	struct NVGparams params;
+	struct NVGcontext* vg = NULL;
+	int i;
+
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = milli__measureRenderCreate;
+	params.renderCreateTexture = milli__measureCreateTexture;
+	params.renderDeleteTexture = milli__measureDeleteTexture;
+	params.renderUpdateTexture = milli__measureUpdateTexture;
+	params.renderGetTextureSize = milli__measureGetTextureSize;
+	params.renderDelete = milli__measureRenderDelete;
+	params.atlasWidth = MI_MEASURE_ATLAS_SIZE;
+	params.atlasHeight = MI_MEASURE_ATLAS_SIZE;
+
+	vg = nvgCreateInternal(&params);
+	if (vg == NULL) return NULL;
+	for (i = 0; i < measureFontCount; i++)
+		nvgCreateFont(vg, measureFonts[i].name, measureFonts[i].filename);
+	return vg;
+}
+
+static void milli__deleteMeasureThreads()
+{
+	int i;
+	for (i = 0; i < measureWorkerCount; i++) {
+		if (measureWorkers[i].vg != NULL)
+			nvgDeleteInternal(measureWorkers[i].vg);
+	}
+	memset(measureWorkers, 0, sizeof(measureWorkers));
+	measureWorkerCount = 0;
+	for (i = 0; i < measureFontCount; i++) {
+		free(measureFonts[i].name);
+		free(measureFonts[i].filename);
+	}
+	measureFontCount = 0;
+	free(measureLeaves);
+	measureLeaves = NULL;
+	measureLeafCount = measureLeafCap = 0;
+}
+
+int miSetMeasureThreads(int count)
+{
+	int i;
+	count = mini(maxi(count, 1), MI_MAX_MEASURE_THREADS);
+	// The calling thread measures too, using the context passed to miLayout().
+	for (i = count-1; i < measureWorkerCount; i++) {
+		if (measureWorkers[i].vg != NULL)
+			nvgDeleteInternal(measureWorkers[i].vg);
+		measureWorkers[i].vg = NULL;
+	}
+	for (i = measureWorkerCount; i < count-1; i++) {
+		measureWorkers[i].vg = milli__createMeasureContext();
+		if (measureWorkers[i].vg == NULL) {
+			measureWorkerCount = i;
+			return 0;
+		}
+	}
+	measureWorkerCount = count-1;
+	return 1;
+}
+
+int miAddMeasureFont(const char* name, const char* filename)
+{
+	int i;
+	struct MImeasureFont* font;
+	if (measureFontCount >= MI_MAX_MEASURE_FONTS) return 0;
+	font = &measureFonts[measureFontCount];
+	font->name = strdup(name);
+	font->filename = strdup(filename);
+	if (font->name == NULL || font->filename == NULL) {
+		free(font->name);
+		free(font->filename);
+		return 0;
+	}
+	measureFontCount++;
+	for (i = 0; i < measureWorkerCount; i++) {
+		if (nvgCreateFont(measureWorkers[i].vg, name, filename) == -1)
+			return 0;
+	}
+	return 1;
+}
+
+static void milli__invalidateMeasure(struct MIcell* cell)
+{
+	for (; cell != NULL; cell = cell->next) {
+		cell->dirty = MI_DIRTY_ALL;
+		milli__invalidateMeasure(cell->children);
+	}
+}
+
+void miInvalidateMeasure(struct MIcell* cell)
+{
+	if (cell == NULL) return;
+	milli__markDirty(cell);
+	cell->dirty = MI_DIRTY_ALL;
+	milli__invalidateMeasure(cell->children);
+}
+
+static int milli__collectDirtyLeaves(struct MIcell* cell)
+{
+	for (; cell != NULL; cell = cell->next) {
+		// Clean cell has clean subtree.
+		if (!(cell->dirty & MI_DIRTY_MEASURE)) continue;
+		if (cell->children != NULL) {
+			if (!milli__collectDirtyLeaves(cell->children))
+				return 0;
+			continue;
+		}
+		if (measureLeafCount+1 > measureLeafCap) {
+			int cap = measureLeafCap == 0 ? 1024 : measureLeafCap*2;
+			struct MIcell** leaves = (struct MIcell**)realloc(measureLeaves, sizeof(struct MIcell*) * cap);
+			if (leaves == NULL) return 0;
+			measureLeaves = leaves;
+			measureLeafCap = cap;
+		}
+		measureLeaves[measureLeafCount++] = cell;
+	}
+	return 1;
+}
+
+static void milli__measureCells(struct MIcell** cells, int count, struct NVGcontext* vg)
+{
+	int i;
+	for (i = 0; i < count; i++)
+		milli__measureCell(cells[i], vg);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI milli__measureThread(LPVOID arg)
+#else
+static void* milli__measureThread(void* arg)
+#endif
+{
+	struct MImeasureWorker* worker = (struct MImeasureWorker*)arg;
+	milli__measureCells(worker->cells, worker->count, worker->vg);
+	return 0;
+}
+
+static void milli__measureTree(struct MIcell* root, struct NVGcontext* vg)
+{
+	int i, n, start, rest, started = 0;
+
+	if (!(root->dirty & MI_DIRTY_MEASURE)) return;
+
+	if (measureWorkerCount > 0) {
+		measureLeafCount = 0;
+		if (root->children != NULL && milli__collectDirtyLeaves(root->children) && measureLeafCount >= MI_MIN_PARALLEL_CELLS) {
+			// Split leaves evenly, the calling thread takes the first batch.
+			n = measureWorkerCount+1;
+			start = measureLeafCount / n;
+			rest = measureLeafCount;
+			for (i = 0; i < measureWorkerCount; i++) {
+				struct MImeasureWorker* worker = &measureWorkers[i];
+				int end = (int)((long long)measureLeafCount * (i+2) / n);
+				worker->cells = measureLeaves + start;
+				worker->count = end - start;
+#ifdef _WIN32
+				worker->thread = CreateThread(NULL, 0, milli__measureThread, worker, 0, NULL);
+				if (worker->thread == NULL) {
+					rest = start;
+					break;
+				}
+#else
+				if (pthread_create(&worker->thread, NULL, milli__measureThread, worker) != 0) {
+					rest = start;
+					break;
+				}
+#endif
+				start = end;
+				started++;
+			}
+			milli__measureCells(measureLeaves, measureLeafCount / n, vg);
+			for (i = 0; i < started; i++) {
+#ifdef _WIN32
+				WaitForSingleObject(measureWorkers[i].thread, INFINITE);
+				CloseHandle(measureWorkers[i].thread);
+#else
+				pthread_join(measureWorkers[i].thread, NULL);
+#endif
+			}
+			// Measure the leaves of the workers which failed to start.
+			milli__measureCells(measureLeaves + rest, measureLeafCount - rest, vg);
+		}
+	}
+
+	// Measure the rest of the tree, the leaves are clean already.
+	milli__measureCell(root, vg);
+}
+
+
+#define MI_PARAM_CACHE_SIZE 256	// Must be power of two.
+#define MI_PARAM_VAL_SLACK 16	// Extra space per cached value, allows values to grow when updated in place.
+struct MIparamCacheItem {
+	const char* ptr;
+	char* src;
+	struct MIparam* params;
+	unsigned char* mem;		// Params and source are stored here, reused between misses.
+	int paramsSize;			// Size of the params at the start of mem, the source follows.
+	int cap;
+};
+
+enum MIinputEventType {
+	MI_INPUT_MOVE,
+	MI_INPUT_PRESS,
+	MI_INPUT_RELEASE,
+	MI_INPUT_KEY,
+};
+
+struct MIinputEvent {
+	int type;
+	double time;
+	float mx, my;
+	int keyType, code;
+};
+
+#define MI_INPUT_QUEUE_SIZE 256
 
 struct MIcontext {
 	struct MIcell* active;
@@ -262,10 +923,27 @@ struct MIcontext {
 	struct MIcell* focus;
 
 	float startmx, startmy;
+	float mx, my;
 
+	struct MIinputEvent inputQueue[MI_INPUT_QUEUE_SIZE];
+	int inputHead, inputCount;
+	int inputButtonDown;	// Button state after the last queued event.
+	double inputTime;		// Time of the event being processed.
+
+	struct MIparamCacheItem paramCache[MI_PARAM_CACHE_SIZE];
 };
 struct MIcontext g_context;
 
+static void milli__clearParamCache()
+{
+	int i;
+	for (i = 0; i < MI_PARAM_CACHE_SIZE; i++) {
+		struct MIparamCacheItem* item = &g_context.paramCache[i];
+		free(item->mem);
+		memset(item, 0, sizeof(*item));
+	}
+}
+
 int miInit()
 {
 	memset(&g_context, 0, sizeof(g_context));
@@ -276,6 +954,10 @@ int miInit()
 void miTerminate()
 {
 	deleteIcons();
+	milli__clearParamCache();
+	milli__deleteMeasureThreads();
+	milli__deleteSlabs();
+	milli__deleteStrings();
 }
 
 void miFrameBegin(struct NVGcontext* vg, int width, int height, struct MIinputState* input)
@@ -291,6 +973,81 @@ void miFrameEnd()
 
 }
 
+// Makes room in the full queue by removing one mouse move. The earlier of two consecutive
+// moves goes first since the later one overrides it, otherwise the oldest move is removed.
+// Presses, releases and keys carry their own state and are never removed.
+static int milli__dropInputMove()
+{
+	struct MIinputEvent* q = g_context.inputQueue;
+	int i, idx = -1;
+	for (i = 0; i < g_context.inputCount; i++) {
+		int cur = (g_context.inputHead + i) % MI_INPUT_QUEUE_SIZE;
+		int next = (cur+1) % MI_INPUT_QUEUE_SIZE;
+		if (q[cur].type != MI_INPUT_MOVE) continue;
+		if (idx == -1)
+			idx = i;
+		if (i+1 < g_context.inputCount && q[next].type == MI_INPUT_MOVE) {
+			idx = i;
+			break;
+		}
+	}
+	if (idx == -1) return 0;
+	for (i = idx; i+1 < g_context.inputCount; i++)
+		q[(g_context.inputHead + i) % MI_INPUT_QUEUE_SIZE] = q[(g_context.inputHead + i+1) % MI_INPUT_QUEUE_SIZE];
+	g_context.inputCount--;
+	return 1;
+}
+
+static struct MIinputEvent* milli__pushInputEvent(int type, double time)
+{
+	struct MIinputEvent* e;
+	if (g_context.inputCount >= MI_INPUT_QUEUE_SIZE && !milli__dropInputMove()) return NULL;
+	e = &g_context.inputQueue[(g_context.inputHead + g_context.inputCount) % MI_INPUT_QUEUE_SIZE];
+	g_context.inputCount++;
+	memset(e, 0, sizeof(*e));
+	e->type = type;
+	e->time = time;
+	return e;
+}
+
+int miPushMouseMove(double time, float mx, float my)
+{
+	struct MIinputEvent* e = NULL;
+	// Consecutive moves are merged while no button is down, then only the latest position matters.
+	// Drags keep every move.
+	if (g_context.inputCount > 0 && !g_context.inputButtonDown) {
+		e = &g_context.inputQueue[(g_context.inputHead + g_context.inputCount-1) % MI_INPUT_QUEUE_SIZE];
+		if (e->type != MI_INPUT_MOVE)
+			e = NULL;
+	}
+	if (e == NULL)
+		e = milli__pushInputEvent(MI_INPUT_MOVE, time);
+	if (e == NULL) return 0;
+	e->time = time;
+	e->mx = mx;
+	e->my = my;
+	return 1;
+}
+
+int miPushMouseButton(double time, float mx, float my, int pressed)
+{
+	struct MIinputEvent* e = milli__pushInputEvent(pressed ? MI_INPUT_PRESS : MI_INPUT_RELEASE, time);
+	if (e == NULL) return 0;
+	e->mx = mx;
+	e->my = my;
+	g_context.inputButtonDown = pressed;
+	return 1;
+}
+
+int miPushKey(double time, int type, int code)
+{
+	struct MIinputEvent* e = milli__pushInputEvent(MI_INPUT_KEY, time);
+	if (e == NULL) return 0;
+	e->keyType = type;
+	e->code = code;
+	return 1;
+}
+
 static int milli__isspace(char c)
 {
 	return strchr(" \t\n\v\f\r", c) != 0;
@@ -306,131 +1063,227 @@ static int milli__isnum(char c)
 	return strchr("0123456789+-.eE", c) != 0;
 }
 
-static struct MIparam* milli__allocParam(const char* key, int keyLen, const char* val, int valLen)
+static const char* milli__keyNames[MI_KEY_COUNT] = {
+	"",
+	"id",
+	"grow",
+	"paddingx",
+	"paddingy",
+	"padding",
+	"spacing",
+	"dir",
+	"align",
+	"pack",
+	"overflow",
+	"width",
+	"height",
+	"label",
+	"font-size",
+	"line-height",
+	"font-face",
+	"icon",
+	"value",
+	"vmin",
+	"vmax",
+};
+
+int miInternParamKey(const char* key)
 {
-	struct MIparam* p = (struct MIparam*)calloc(1, sizeof(struct MIparam));
-	if (p == NULL) goto error;
+	int i;
+	for (i = 1; i < MI_KEY_COUNT; i++) {
+		if (strcmp(milli__keyNames[i], key) == 0)
+			return i;
+	}
+	return MI_KEY_UNKNOWN;
+}
 
-	p->key = (char*)malloc(keyLen+1);
-	if (p->key == NULL) goto error;
-	memcpy(p->key, key, keyLen);
-	p->key[keyLen] = '\0';
+static int milli__parseNumbers(const char* s, float* vals, int maxVals)
+{
+	int n = 0;
+	char* end = NULL;
+	while (n < maxVals) {
+		float v = (float)strtod(s, &end);
+		if (end == s) break;
+		vals[n++] = v;
+		s = end;
+	}
+	return n;
+}
+
+static void milli__compileParam(struct MIparam* p)
+{
+	p->keyId = miInternParamKey(p->key);
+	p->atom = milli__internAtom(p->key);
+	p->nvals = milli__parseNumbers(p->val, p->vals, MI_MAX_PARAMVALS);
+}
 
-	p->val = (char*)malloc(valLen+1);
-	if (p->val == NULL) goto error;
-	memcpy(p->val, val, valLen);
-	p->val[valLen] = '\0';
+static const char* milli__nextParam(const char* s, const char** key, int* keyLen, const char** val, int* valLen)
+{
+	*key = NULL; *val = NULL;
+	*keyLen = 0; *valLen = 0;
 
-	return p;
+	// Skip white space before the param name
+	while (*s && milli__isspace(*s)) s++;
+	if (!*s) return s;
+	*key = s;
+	// Find end of the attrib name.
+	while (*s && !milli__isspace(*s) && *s != '=') s++;
+	*keyLen = (int)(s - *key);
 
-error:
-	if (p != NULL) {
-		free(p->key);
-		free(p->val);
-		free(p);
+	// Skip until the beginning of the value.
+	while (*s && (milli__isspace(*s) || *s == '=')) s++;
+	if (*s == '\'' || *s == '\"') {
+		// Parse quoted value
+		char quote = *s;
+		s++; // skip quote
+		*val = s;
+		while (*s && *s != quote) s++;
+		*valLen = (int)(s - *val);
+		if (*s) s++; // skip quote
+	} else {
+		// Parse unquoted value
+		*val = s;
+		while (*s && !milli__isspace(*s)) s++;
+		*valLen = (int)(s - *val);
 	}
-	return NULL;
+	return s;
 }
 
-struct MIparam* miParseParams(const char* s)
+static int milli__alignSize(int size)
+{
+	return (size + (int)sizeof(void*)-1) & ~((int)sizeof(void*)-1);
+}
+
+// Returns number of bytes needed to store the params parsed from the string.
+// Each value gets 'slack' bytes of extra space so that it can be updated in place.
+static int milli__paramsSize(const char* s, int slack)
+{
+	int size = 0;
+	while (*s) {
+		const char *key, *val;
+		int keyLen, valLen;
+		s = milli__nextParam(s, &key, &keyLen, &val, &valLen);
+		if (key != NULL && keyLen > 0 && val != NULL && valLen > 0)
+			size += milli__alignSize(sizeof(struct MIparam) + keyLen+1 + valLen+1 + slack);
+	}
+	return size;
+}
+
+// Parses the params into a single block of memory, the list head is at the start of the block.
+static struct MIparam* milli__buildParams(const char* s, unsigned char* mem, int slack)
 {
 	struct MIparam* ret = NULL;
 	struct MIparam** cur = &ret;
 
 	while (*s) {
-		const char *key = NULL, *val = NULL;
-		int keyLen = 0, valLen = 0;
-
-		// Skip white space before the param name
-		while (*s && milli__isspace(*s)) s++;
-		if (!*s) break;
-		key = s;
-		// Find end of the attrib name.
-		while (*s && !milli__isspace(*s) && *s != '=') s++;
-		keyLen = (int)(s - key);
-
-		// Skip until the beginning of the value.
-		while (*s && (milli__isspace(*s) || *s == '=')) s++;
-		if (*s == '\'' || *s == '\"') {
-			// Parse quoted value
-			char quote = *s;
-			s++; // skip quote
-			val = s;
-			while (*s && *s != quote) s++;
-			valLen = (int)(s - val);
-			s++; // skip quote
-		} else {
-			// Parse unquoted value
-			val = s;
-			while (*s && !milli__isspace(*s)) s++;
-			valLen = (int)(s - val);
-		}
-
-		if (key != NULL && keyLen > 0 && val != NULL && valLen > 0) {
-			struct MIparam* p = milli__allocParam(key, keyLen, val, valLen);
-			if (p != NULL) {
-				*cur = p;
-				cur = &p->next;
-			}
-		}
+		const char *key, *val;
+		int keyLen, valLen;
+		struct MIparam* p;
+		s = milli__nextParam(s, &key, &keyLen, &val, &valLen);
+		if (key == NULL || keyLen == 0 || val == NULL || valLen == 0)
+			continue;
+
+		p = (struct MIparam*)mem;
+		memset(p, 0, sizeof(struct MIparam));
+		p->key = (char*)(p+1);
+		memcpy(p->key, key, keyLen);
+		p->key[keyLen] = '\0';
+		p->val = p->key + keyLen+1;
+		memcpy(p->val, val, valLen);
+		p->val[valLen] = '\0';
+		milli__compileParam(p);
+		mem += milli__alignSize(sizeof(struct MIparam) + keyLen+1 + valLen+1 + slack);
+
+		*cur = p;
+		cur = &p->next;
 	}
-	
+
 	return ret;
 }
 
+struct MIparam* miCompileParams(const char* s)
+{
+	unsigned char* mem = NULL;
+	int size = milli__paramsSize(s, 0);
+	if (size == 0) return NULL;
+	mem = (unsigned char*)malloc(size);
+	if (mem == NULL) return NULL;
+	return milli__buildParams(s, mem, 0);
+}
+
+struct MIparam* miParseParams(const char* s)
+{
+	return miCompileParams(s);
+}
+
 void miFreeParams(struct MIparam* p)
 {
-	if (p == NULL) return;
-	miFreeParams(p->next);
-	free(p->key);
-	free(p->val);
+	// The whole list is stored in one allocation.
 	free(p);
 }
 
+static int milli__paramInt(struct MIparam* p, int i)
+{
+	return i < p->nvals ? (int)p->vals[i] : -1;
+}
+
+static float milli__paramFloat(struct MIparam* p, int i)
+{
+	return i < p->nvals ? p->vals[i] : -1.0f;
+}
+
 int miCellParam(struct MIcell* cell, struct MIparam* p)
 {
-	if (strcmp(p->key, "id") == 0) {
+	switch (p->keyId) {
+	case MI_KEY_ID:
 		if (p->val != NULL && strlen(p->val) > 0) {
-			if (cell->id != NULL) free(cell->id);
-			cell->id = strdup(p->val);
+			const char* id = milli__internString(p->val);
+			milli__releaseString(cell->id);
+			cell->id = id;
 			return 1;
 		}
-	} else if (strcmp(p->key, "grow") == 0) {
-		int grow = -1;
-		sscanf(p->val, "%d", &grow);
+		break;
+	case MI_KEY_GROW: {
+		int grow = milli__paramInt(p, 0);
 		if (grow >= 0 && grow < 100) {
 			cell->grow = grow;
 			return 1;
 		}
-	} else if (strcmp(p->key, "paddingx") == 0) {
-		int pad = -1;
-		sscanf(p->val, "%d", &pad);
+		break;
+	}
+	case MI_KEY_PADDINGX: {
+		int pad = milli__paramInt(p, 0);
 		if (pad >= 0 && pad < 100) {
 			cell->paddingx = pad;
 			return 1;
 		}
-	} else if (strcmp(p->key, "paddingy") == 0) {
-		int pad = -1;
-		sscanf(p->val, "%d", &pad);
+		break;
+	}
+	case MI_KEY_PADDINGY: {
+		int pad = milli__paramInt(p, 0);
 		if (pad >= 0 && pad < 100) {
 			cell->paddingy = pad;
 			return 1;
 		}
-	} else if (strcmp(p->key, "padding") == 0) {
-		int padx = -1, pady = -1;
-		sscanf(p->val, "%d %d", &padx, &pady);
+		break;
+	}
+	case MI_KEY_PADDING: {
+		int padx = milli__paramInt(p, 0), pady = milli__paramInt(p, 1);
 		if (padx >= 0 && padx < 100 && pady >= 0 && pady < 100) {
 			cell->paddingx = padx;
 			cell->paddingy = pady;
 			return 1;
 		}
-	} else if (strcmp(p->key, "spacing") == 0) {
-		int spacing = -1;
-		sscanf(p->val, "%d", &spacing);
+		break;
+	}
+	case MI_KEY_SPACING: {
+		int spacing = milli__paramInt(p, 0);
 		if (spacing >= 0 && spacing < 100) {
 			cell->spacing = spacing;
 			return 1;
 		}
+		break;
+	}
 	}
 	return 0;
 }
@@ -441,18 +1294,40 @@ void milli__boxRender(struct MIcell* cell, struct NVGcontext* vg, struct MIrect*
 	struct MIbox* box = (struct MIbox*)cell;
 	struct MIcell* child;
 	struct MIrect rect = box->cell.frame;
+	struct MIrect clip;
+	struct MIrect* childView = view;
 	struct NVGcolor color = (g_context.hover == cell) ? nvgRGBA(255,255,255,64) : nvgRGBA(255,255,255,32);
+	int clipped = box->overflow == MI_HIDDEN || box->overflow == MI_SCROLL;
+
+	if (!milli__rectInView(view, rect)) return;
 
 	nvgBeginPath(vg);
 	nvgRect(vg, rect.x, rect.y, rect.width, rect.height);
 	nvgFillColor(vg, color);
 	nvgFill(vg);
 
+	// Clip children to the box at overflow boundary.
+	if (clipped) {
+		clip = view != NULL ? milli__intersectRects(*view, rect) : rect;
+		childView = &clip;
+		nvgSave(vg);
+		nvgScissor(vg, clip.x, clip.y, clip.width, clip.height);
+	}
+
 	// Render children
 	for (child = box->cell.children; child != NULL; child = child->next) {
+		if (!milli__rectInView(childView, child->frame)) {
+			// Children are laid out in order, the rest are outside the view too.
+			if (box->dir == MI_COL && child->frame.y > childView->y + childView->height) break;
+			if (box->dir == MI_ROW && child->frame.x > childView->x + childView->width) break;
+			continue;
+		}
 		if (child->render != NULL)
-			child->render(child, vg, &rect);
+			child->render(child, vg, childView);
 	}
+
+	if (clipped)
+		nvgRestore(vg);
 }
 
 int milli__boxLayout(struct MIcell* cell, struct NVGcontext* vg)
@@ -556,8 +1431,7 @@ int milli__boxLayout(struct MIcell* cell, struct NVGcontext* vg)
 			}
 			y += child->frame.height + child->spacing + packSpacing;
 
-			if (child->layout)
-				reflow |= child->layout(child, vg);
+			reflow |= milli__layoutCell(child, vg);
 		}
 
 	} else {
@@ -608,8 +1482,7 @@ int milli__boxLayout(struct MIcell* cell, struct NVGcontext* vg)
 
 			x += child->frame.width + child->spacing + packSpacing;
 
-			if (child->layout)
-				reflow |= child->layout(child, vg);
+			reflow |= milli__layoutCell(child, vg);
 		}
 	}
 
@@ -625,13 +1498,9 @@ static void milli__boxMeasure(struct MIcell* cell, struct NVGcontext* vg)
 	size->width = 0;
 	size->height = 0;
 
-	// First measure children.
-	for (child = box->cell.children; child != NULL; child = child->next) {
-		if (child->measure != NULL)
-			child->measure(child, vg);
-		else
-			child->content.width = child->content.height = 0;
-	}
+	// First measure children, only the changed ones need to be measured again.
+	for (child = box->cell.children; child != NULL; child = child->next)
+		milli__measureCell(child, vg);
 
 	// Adapt to child size based on direction.
 	if (box->dir == MI_COL) {
@@ -702,44 +1571,55 @@ static void milli__boxParam(struct MIcell* cell, struct MIparam* p)
 
 	if (miCellParam(cell, p)) return;
 
-	if (strcmp(p->key, "dir") == 0) {
+	switch (p->keyId) {
+	case MI_KEY_DIR: {
 		int dir = milli__boxParseDir(p->val);
 		if (dir != -1) {
 			box->dir = dir;
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "align") == 0) {
+		break;
+	}
+	case MI_KEY_ALIGN: {
 		int align = milli__boxParseAlign(p->val);
 		if (align != -1) {
 			box->align = align;
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "pack") == 0) {
+		break;
+	}
+	case MI_KEY_PACK: {
 		int pack = milli__boxParseAlign(p->val);
 		if (pack != -1) {
 			box->pack = pack;
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "overflow") == 0) {
+		break;
+	}
+	case MI_KEY_OVERFLOW: {
 		int overflow = milli__boxParseOverflow(p->val);
 		if (overflow != -1) {
 			box->overflow = overflow;
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "width") == 0) {
-		float width = -1;
-		sscanf(p->val, "%f", &width);
+		break;
+	}
+	case MI_KEY_WIDTH: {
+		float width = milli__paramFloat(p, 0);
 		if (width > 0 && width < 10000) {
 			box->width = width;
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "height") == 0) {
-		float height = -1;
-		sscanf(p->val, "%f", &height);
+		break;
+	}
+	case MI_KEY_HEIGHT: {
+		float height = milli__paramFloat(p, 0);
 		if (height > 0 && height < 10000) {
 			box->height = height;
 			valid = 1;
 		}
+		break;
+	}
 	}
 	if (!valid)
 		printf("Box: invalid parameter: %s=%s\n", p->key, p->val);
@@ -752,7 +1632,7 @@ static void milli__boxDtor(struct MIcell* cell)
 
 struct MIcell* miCreateBox(const char* params)
 {
-	struct MIbox* box = (struct MIbox*)calloc(1, sizeof(struct MIbox));
+	struct MIbox* box = (struct MIbox*)milli__allocCell(sizeof(struct MIbox));
 	if (box == NULL) goto error;
 	box->cell.render = milli__boxRender;
 	box->cell.layout = milli__boxLayout;
@@ -776,9 +1656,8 @@ static void milli__textRender(struct MIcell* cell, struct NVGcontext* vg, struct
 	struct MIrect rect = text->cell.frame;
 	struct NVGcolor color = (g_context.hover == cell) ? nvgRGBA(0,255,0,64) : nvgRGBA(0,255,0,32);
 
-	MILLI_NOTUSED(view);
-
-	if (text->text == NULL) return;	
+	if (text->text == NULL) return;
+	if (!milli__rectInView(view, rect)) return;
 
 	nvgBeginPath(vg);
 	nvgRect(vg, rect.x, rect.y, rect.width, rect.height);
@@ -833,6 +1712,20 @@ static int milli__textLogic(struct MIcell* cell, struct MIevent* event)
 	return 0;
 }
 
+static void milli__textSetLabel(struct MItext* text, const char* label)
+{
+	int len = (int)strlen(label);
+	if (text->text != text->textBuf)
+		free(text->text);
+	// Short labels are stored inline to avoid allocation per text cell.
+	if (len < MI_TEXT_INLINE_SIZE) {
+		memcpy(text->textBuf, label, len+1);
+		text->text = text->textBuf;
+	} else {
+		text->text = strdup(label);
+	}
+}
+
 static void milli__textParam(struct MIcell* cell, struct MIparam* p)
 {
 	struct MItext* text = (struct MItext*)cell;
@@ -840,44 +1733,55 @@ static void milli__textParam(struct MIcell* cell, struct MIparam* p)
 
 	if (miCellParam(cell, p)) return;
 
-	if (strcmp(p->key, "label") == 0) {
+	switch (p->keyId) {
+	case MI_KEY_LABEL:
 		if (p->val != NULL && strlen(p->val) > 0) {
-			if (text->text != NULL) free(text->text);
-			text->text = strdup(p->val);
+			milli__textSetLabel(text, p->val);
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "font-size") == 0) {
-		float size = -1;
-		sscanf(p->val, "%f", &size);
+		break;
+	case MI_KEY_FONT_SIZE: {
+		float size = milli__paramFloat(p, 0);
 		if (size >= 0 && size < 100) {
 			text->fontSize = size;
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "line-height") == 0) {
-		float height = -1;
-		sscanf(p->val, "%f", &height);
+		break;
+	}
+	case MI_KEY_LINE_HEIGHT: {
+		float height = milli__paramFloat(p, 0);
 		if (height >= 0 && height < 5) {
 			text->lineHeight = height;
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "font-face") == 0) {
+		break;
+	}
+	case MI_KEY_FONT_FACE:
 		if (p->val != NULL && strlen(p->val) > 0) {
-			if (text->fontFace != NULL) free(text->fontFace);
-			text->fontFace = strdup(p->val);
-			valid = 1;
+			const char* face = milli__internString(p->val);
+			if (face != NULL) {
+				milli__releaseString(text->fontFace);
+				text->fontFace = face;
+				valid = 1;
+			}
 		}
-	} else if (strcmp(p->key, "align") == 0) {
+		break;
+	case MI_KEY_ALIGN: {
 		int align = milli__boxParseAlign(p->val);
 		if (align != -1) {
 			text->align = align;
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "pack") == 0) {
+		break;
+	}
+	case MI_KEY_PACK: {
 		int pack = milli__boxParseAlign(p->val);
 		if (pack != -1) {
 			text->pack = pack;
 			valid = 1;
 		}
+		break;
+	}
 	}
 
 	if (!valid)
@@ -887,13 +1791,14 @@ static void milli__textParam(struct MIcell* cell, struct MIparam* p)
 static void milli__textDtor(struct MIcell* cell)
 {
 	struct MItext* text = (struct MItext*)cell;
-	free(text->text);
-	free(text->fontFace);
+	if (text->text != text->textBuf)
+		free(text->text);
+	milli__releaseString(text->fontFace);
 }
 
 struct MIcell* miCreateText(const char* params)
 {
-	struct MItext* text = (struct MItext*)calloc(1, sizeof(struct MItext));
+	struct MItext* text = (struct MItext*)milli__allocCell(sizeof(struct MItext));
 	if (text == NULL) goto error;
 	text->cell.render = milli__textRender;
 	text->cell.layout = milli__textLayout;
@@ -901,7 +1806,7 @@ struct MIcell* miCreateText(const char* params)
 	text->cell.measure = milli__textMeasure;
 	text->cell.param = milli__textParam;
 	text->cell.dtor = milli__textDtor;
-	text->fontFace = strdup("sans");
+	text->fontFace = milli__internString("sans");
 	text->fontSize = 18.0f;
 	text->lineHeight = 1.2f;
 	text->align = MI_START;
@@ -921,6 +1826,8 @@ static void milli__iconRender(struct MIcell* cell, struct NVGcontext* vg, struct
 	struct MIcolor col = {255,255,255,255};
 	struct NVGcolor color = (g_context.hover == cell) ? nvgRGBA(255,0,0,64) : nvgRGBA(255,0,0,32);
 
+	if (!milli__rectInView(view, rect)) return;
+
 	nvgBeginPath(vg);
 	nvgRect(vg, rect.x, rect.y, rect.width, rect.height);
 	nvgFillColor(vg, color);
@@ -976,26 +1883,31 @@ static void milli__iconParam(struct MIcell* cell, struct MIparam* p)
 
 	if (miCellParam(cell, p)) return;
 
-	if (strcmp(p->key, "icon") == 0) {
+	switch (p->keyId) {
+	case MI_KEY_ICON: {
 		struct MIiconImage* image = findIcon(p->val);
 		if (image != NULL) {
 			icon->image = image;
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "width") == 0) {
-		float width = -1;
-		sscanf(p->val, "%f", &width);
+		break;
+	}
+	case MI_KEY_WIDTH: {
+		float width = milli__paramFloat(p, 0);
 		if (width > 0 && width < 10000) {
 			icon->width = width;
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "height") == 0) {
-		float height = -1;
-		sscanf(p->val, "%f", &height);
+		break;
+	}
+	case MI_KEY_HEIGHT: {
+		float height = milli__paramFloat(p, 0);
 		if (height > 0 && height < 10000) {
 			icon->width = height;
 			valid = 1;
 		}
+		break;
+	}
 	}
 
 	if (!valid)
@@ -1012,7 +1924,7 @@ static void milli__iconDtor(struct MIcell* cell)
 
 struct MIcell* miCreateIcon(const char* params)
 {
-	struct MIicon* icon = (struct MIicon*)calloc(1, sizeof(struct MIicon));
+	struct MIicon* icon = (struct MIicon*)milli__allocCell(sizeof(struct MIicon));
 	if (icon == NULL) goto error;
 	icon->cell.render = milli__iconRender;
 	icon->cell.layout = milli__iconLayout;
@@ -1051,6 +1963,8 @@ static void milli__sliderRender(struct MIcell* cell, struct NVGcontext* vg, stru
 	float hx = slotx + clampf((slider->value - slider->vmin) / (slider->vmax - slider->vmin), 0.0f, 1.0f) * slotw;
 	struct NVGcolor color = (g_context.hover == cell) ? nvgRGBA(0,0,255,64) : nvgRGBA(0,0,255,32);
 
+	if (!milli__rectInView(view, slider->cell.frame)) return;
+
 	nvgBeginPath(vg);
 	nvgRect(vg, rect.x, rect.y, rect.width, rect.height);
 	nvgFillColor(vg, color);
@@ -1117,38 +2031,41 @@ static void milli__sliderParam(struct MIcell* cell, struct MIparam* p)
 
 	if (miCellParam(cell, p)) return;
 
-	if (strcmp(p->key, "value") == 0) {
-		float v = 0;
-		if (sscanf(p->val, "%f", &v) == 1) {
-			slider->value = v;
+	switch (p->keyId) {
+	case MI_KEY_VALUE:
+		if (p->nvals > 0) {
+			slider->value = p->vals[0];
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "vmin") == 0) {
-		float v = 0;
-		if (sscanf(p->val, "%f", &v) == 1) {
-			slider->vmin = v;
+		break;
+	case MI_KEY_VMIN:
+		if (p->nvals > 0) {
+			slider->vmin = p->vals[0];
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "vmax") == 0) {
-		float v = 0;
-		if (sscanf(p->val, "%f", &v) == 1) {
-			slider->vmax = v;
+		break;
+	case MI_KEY_VMAX:
+		if (p->nvals > 0) {
+			slider->vmax = p->vals[0];
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "width") == 0) {
-		float width = -1;
-		sscanf(p->val, "%f", &width);
+		break;
+	case MI_KEY_WIDTH: {
+		float width = milli__paramFloat(p, 0);
 		if (width > 0 && width < 10000) {
 			slider->width = width;
 			valid = 1;
 		}
-	} else if (strcmp(p->key, "height") == 0) {
-		float height = -1;
-		sscanf(p->val, "%f", &height);
+		break;
+	}
+	case MI_KEY_HEIGHT: {
+		float height = milli__paramFloat(p, 0);
 		if (height > 0 && height < 10000) {
 			slider->width = height;
 			valid = 1;
 		}
+		break;
+	}
 	}
 
 	if (!valid)
@@ -1162,7 +2079,7 @@ static void milli__sliderDtor(struct MIcell* cell)
 
 struct MIcell* miCreateSlider(const char* params)
 {
-	struct MIslider* slider = (struct MIslider*)calloc(1, sizeof(struct MIslider));
+	struct MIslider* slider = (struct MIslider*)milli__allocCell(sizeof(struct MIslider));
 	if (slider == NULL) goto error;
 	slider->cell.render = milli__sliderRender;
 	slider->cell.layout = milli__sliderLayout;
@@ -1196,21 +2113,15 @@ static int milli__templateLayout(struct MIcell* cell, struct NVGcontext* vg)
 	struct MItemplate* tmpl = (struct MItemplate*)cell;
 	struct MIcell* host = tmpl->cell.children;
 	host->frame = tmpl->cell.frame;
-	if (host->layout)
-		return host->layout(host, vg);
-	return 0;
+	return milli__layoutCell(host, vg);
 }
 
 static void milli__templateMeasure(struct MIcell* cell, struct NVGcontext* vg)
 {
 	struct MItemplate* tmpl = (struct MItemplate*)cell;
 	struct MIcell* host = tmpl->cell.children;
-	if (host->measure) {
-		host->measure(host, vg);
-		tmpl->cell.content = host->content;
-	} else {
-		tmpl->cell.content.width = tmpl->cell.content.height = 0;
-	}
+	milli__measureCell(host, vg);
+	tmpl->cell.content = host->content;
 }
 
 static int milli__templateLogic(struct MIcell* cell, struct MIevent* event)
@@ -1223,24 +2134,110 @@ static int milli__templateLogic(struct MIcell* cell, struct MIevent* event)
 }
 
 
-static int milli__templateSetVar(struct MIcell* cell, char* name, char* val)
+static void milli__collectBindings(struct MItemplate* tmpl, struct MIcell* cell)
 {
 	struct MIvar* var;
+	for (; cell != NULL; cell = cell->next) {
+		for (var = cell->vars; var != NULL; var = var->next) {
+			struct MIbinding* b;
+			if (tmpl->bindingCount+1 > tmpl->bindingCapacity) {
+				int cap = tmpl->bindingCapacity == 0 ? 8 : tmpl->bindingCapacity*2;
+				struct MIbinding* bindings = (struct MIbinding*)realloc(tmpl->bindings, sizeof(struct MIbinding)*cap);
+				if (bindings == NULL) {
+					printf("Template: out of memory, skipping %s\n", var->name);
+					continue;
+				}
+				tmpl->bindings = bindings;
+				tmpl->bindingCapacity = cap;
+			}
+			b = &tmpl->bindings[tmpl->bindingCount++];
+			b->atom = var->atom;
+			b->key = var->key;
+			b->keyId = miInternParamKey(var->key);
+			b->cell = cell;
+		}
+		milli__collectBindings(tmpl, cell->children);
+	}
+}
 
-	if (cell == NULL) return 0;
+// Sorts the bindings by var atom, keeping the tree order of the bindings of each var,
+// and builds table from var atom to the first binding of the var.
+static void milli__updateBindings(struct MItemplate* tmpl)
+{
+	int i, n, maxAtom = -1;
+	struct MIbinding* sorted = NULL;
+	if (tmpl->bindingsValid) return;
+	tmpl->bindingCount = 0;
+	tmpl->varCount = 0;
+	milli__collectBindings(tmpl, tmpl->cell.children);
+
+	for (i = 0; i < tmpl->bindingCount; i++)
+		maxAtom = maxi(maxAtom, tmpl->bindings[i].atom);
+	if (maxAtom+1 > tmpl->varCapacity) {
+		int* vars = (int*)realloc(tmpl->vars, sizeof(int)*(maxAtom+1));
+		if (vars == NULL) goto error;
+		tmpl->vars = vars;
+		tmpl->varCapacity = maxAtom+1;
+	}
+	if (tmpl->bindingCount > 0) {
+		sorted = (struct MIbinding*)malloc(sizeof(struct MIbinding)*tmpl->bindingCapacity);
+		if (sorted == NULL) goto error;
+	}
 
-	var = milli__findVar(cell, name);
-	if (var != NULL) {
-		struct MIparam p = {var->key, val, NULL};
-//		printf("Template calling: %s=%s -> %s=%s\n", name,val, p.key, p.val);
-		if (cell->param != NULL)
-			cell->param(cell, &p);
-		return 1;
+	// Counting sort, after the prefix sum vars[atom] is the first binding of the var.
+	tmpl->varCount = maxAtom+1;
+	memset(tmpl->vars, 0, sizeof(int)*tmpl->varCount);
+	for (i = 0; i < tmpl->bindingCount; i++)
+		tmpl->vars[tmpl->bindings[i].atom]++;
+	for (i = 0, n = 0; i < tmpl->varCount; i++) {
+		int count = tmpl->vars[i];
+		tmpl->vars[i] = n;
+		n += count;
+	}
+	for (i = 0; i < tmpl->bindingCount; i++)
+		sorted[tmpl->vars[tmpl->bindings[i].atom]++] = tmpl->bindings[i];
+	// The scatter left each entry at the end of its var, restore the starts.
+	for (i = 0, n = 0; i < tmpl->varCount; i++) {
+		int end = tmpl->vars[i];
+		tmpl->vars[i] = end > n ? n : -1;
+		n = end;
+	}
+	if (sorted != NULL) {
+		free(tmpl->bindings);
+		tmpl->bindings = sorted;
 	}
 
-	if (milli__templateSetVar(cell->next, name, val)) return 1;
-	if (milli__templateSetVar(cell->children, name, val)) return 1;
-	return 0;
+	tmpl->bindingsValid = 1;
+	return;
+
+error:
+	printf("Template: out of memory, vars are not set\n");
+	tmpl->bindingCount = 0;
+	tmpl->varCount = 0;
+}
+
+// The param key atom indexes the var table, and the values parsed when the param
+// was compiled are passed on, so setting a var does not look up or parse strings.
+static int milli__templateSetVar(struct MItemplate* tmpl, struct MIparam* src)
+{
+	int i;
+
+	milli__updateBindings(tmpl);
+	if (src->atom < 0 || src->atom >= tmpl->varCount) return 0;
+	i = tmpl->vars[src->atom];
+	if (i == -1) return 0;
+
+	for (; i < tmpl->bindingCount && tmpl->bindings[i].atom == src->atom; i++) {
+		struct MIbinding* b = &tmpl->bindings[i];
+		struct MIparam p = *src;
+		p.key = (char*)b->key;
+		p.keyId = b->keyId;
+		p.next = NULL;
+		if (b->cell->param != NULL)
+			b->cell->param(b->cell, &p);
+		milli__markDirty(b->cell);
+	}
+	return 1;
 }
 
 static void milli__templateParam(struct MIcell* cell, struct MIparam* p)
@@ -1251,7 +2248,7 @@ static void milli__templateParam(struct MIcell* cell, struct MIparam* p)
 //	printf("template %s=%s\n", p->key, p->val);
 
 	// First try to user variables
-	if (milli__templateSetVar(host, p->key, p->val))
+	if (milli__templateSetVar(tmpl, p))
 		return;
 
 	// Finally pass to host
@@ -1293,11 +2290,28 @@ static void milli__templateParam(struct MIcell* cell, struct MIparam* p)
 static void milli__templateDtor(struct MIcell* cell)
 {
 	struct MItemplate* tmpl = (struct MItemplate*)cell;
+	free(tmpl->bindings);
+	tmpl->bindings = NULL;
+	tmpl->bindingCount = 0;
+	tmpl->bindingCapacity = 0;
+	free(tmpl->vars);
+	tmpl->vars = NULL;
+	tmpl->varCount = 0;
+	tmpl->varCapacity = 0;
+}
+
+// Templates containing the cell need to look up their bindings again.
+static void milli__invalidateBindings(struct MIcell* cell)
+{
+	for (; cell != NULL; cell = cell->parent) {
+		if (cell->param == milli__templateParam)
+			((struct MItemplate*)cell)->bindingsValid = 0;
+	}
 }
 
 struct MIcell* miCreateTemplate(struct MIcell* host)
 {
-	struct MItemplate* tmpl = (struct MItemplate*)calloc(1, sizeof(struct MItemplate));
+	struct MItemplate* tmpl = (struct MItemplate*)milli__allocCell(sizeof(struct MItemplate));
 	if (tmpl == NULL) goto error;
 	tmpl->cell.render = milli__templateRender;
 	tmpl->cell.layout = milli__templateLayout;
@@ -1307,6 +2321,7 @@ struct MIcell* miCreateTemplate(struct MIcell* host)
 	tmpl->cell.dtor = milli__templateDtor;
 
 	miAddChild(tmpl, host);
+	milli__updateBindings(tmpl);
 
 	tmpl->cell.grow = host->grow;
 	tmpl->cell.paddingx = host->paddingx;
@@ -1394,6 +2409,389 @@ struct MIcell* miCreateIconButton(const char* params)
 }
 
 
+// Binary UI description
+// The blob contains only offsets and indices so that it can be used directly from
+// read-only or memory-mapped memory. Params are stored precompiled and all strings
+// are stored once.
+
+enum MIuiCellType {
+	MI_UI_BOX,
+	MI_UI_TEXT,
+	MI_UI_ICON,
+	MI_UI_SLIDER,
+	MI_UI_BUTTON,
+	MI_UI_ICONBUTTON,
+	MI_UI_TYPE_COUNT
+};
+
+static const char* milli__uiTypeNames[MI_UI_TYPE_COUNT] = {
+	"box", "text", "icon", "slider", "button", "iconbutton",
+};
+
+#define MI_UI_BATCH_PARAMS 16
+#define MI_UI_MAX_DEPTH 64
+
+static const struct MIuiHeader* milli__uiHeader(const void* data)
+{
+	const struct MIuiHeader* hdr = (const struct MIuiHeader*)data;
+	if (hdr == NULL) return NULL;
+	if (hdr->magic != MI_UI_MAGIC || hdr->version != MI_UI_VERSION) return NULL;
+	return hdr;
+}
+
+static const struct MIuiCell* milli__uiCells(const struct MIuiHeader* hdr)
+{
+	return (const struct MIuiCell*)((const unsigned char*)hdr + hdr->cellsOffset);
+}
+
+static const struct MIuiParam* milli__uiParams(const struct MIuiHeader* hdr)
+{
+	return (const struct MIuiParam*)((const unsigned char*)hdr + hdr->paramsOffset);
+}
+
+static const char* milli__uiString(const struct MIuiHeader* hdr, int offset)
+{
+	if (offset < 0) return NULL;
+	return (const char*)hdr + hdr->stringsOffset + offset;
+}
+
+int miCheckUI(const void* data, int size)
+{
+	const struct MIuiHeader* hdr = (const struct MIuiHeader*)data;
+	const struct MIuiCell* cells;
+	const struct MIuiParam* params;
+	const char* strings;
+	unsigned char* depth = NULL;
+	int i, ret = 0;
+
+	if (data == NULL || size < (int)sizeof(struct MIuiHeader)) return 0;
+	if (((size_t)data & (sizeof(int)-1)) != 0) return 0;
+	if (hdr->magic != MI_UI_MAGIC) return 0;
+	if (hdr->version != MI_UI_VERSION) {
+		printf("UI: unsupported version %d\n", hdr->version);
+		return 0;
+	}
+	if (hdr->cellCount < 0 || hdr->paramCount < 0 || hdr->stringsSize < 1) return 0;
+	// Check the counts against the space left so that hostile counts cannot overflow.
+	if (hdr->cellsOffset < (int)sizeof(struct MIuiHeader) || hdr->cellsOffset > size) return 0;
+	if ((hdr->cellsOffset & (sizeof(int)-1)) != 0) return 0;
+	if (hdr->cellCount > (size - hdr->cellsOffset) / (int)sizeof(struct MIuiCell)) return 0;
+	if (hdr->paramsOffset < (int)sizeof(struct MIuiHeader) || hdr->paramsOffset > size) return 0;
+	if ((hdr->paramsOffset & (sizeof(int)-1)) != 0) return 0;
+	if (hdr->paramCount > (size - hdr->paramsOffset) / (int)sizeof(struct MIuiParam)) return 0;
+	if (hdr->stringsOffset < (int)sizeof(struct MIuiHeader) || hdr->stringsOffset > size) return 0;
+	if (hdr->stringsSize > size - hdr->stringsOffset) return 0;
+
+	cells = milli__uiCells(hdr);
+	params = milli__uiParams(hdr);
+	strings = (const char*)hdr + hdr->stringsOffset;
+	if (strings[hdr->stringsSize-1] != '\0') return 0;
+
+	// Nesting depth of each cell, miCreateFromUI() recurses once per level.
+	depth = (unsigned char*)malloc(hdr->cellCount > 0 ? hdr->cellCount : 1);
+	if (depth == NULL) return 0;
+	memset(depth, 0, hdr->cellCount);
+
+	for (i = 0; i < hdr->cellCount; i++) {
+		const struct MIuiCell* c = &cells[i];
+		if (c->type < 0 || c->type >= MI_UI_TYPE_COUNT) goto error;
+		if (c->id < -1 || c->id >= hdr->stringsSize) goto error;
+		// Children and siblings must come after the cell, this also guarantees there are no cycles,
+		// and that the depth of a cell is final before it is visited.
+		if (c->firstChild != -1) {
+			if (c->firstChild <= i || c->firstChild >= hdr->cellCount) goto error;
+			if (depth[i]+1 >= MI_UI_MAX_DEPTH) goto error;
+			depth[c->firstChild] = (unsigned char)maxi(depth[c->firstChild], depth[i]+1);
+		}
+		if (c->next != -1) {
+			if (c->next <= i || c->next >= hdr->cellCount) goto error;
+			depth[c->next] = (unsigned char)maxi(depth[c->next], depth[i]);
+		}
+		if (c->firstParam < 0 || c->paramCount < 0 || c->firstParam > hdr->paramCount || c->paramCount > hdr->paramCount - c->firstParam) goto error;
+	}
+	for (i = 0; i < hdr->paramCount; i++) {
+		const struct MIuiParam* p = &params[i];
+		if (p->key < 0 || p->key >= hdr->stringsSize) goto error;
+		if (p->val < 0 || p->val >= hdr->stringsSize) goto error;
+		if (p->nvals < 0 || p->nvals > MI_MAX_PARAMVALS) goto error;
+	}
+	ret = 1;
+
+error:
+	free(depth);
+	return ret;
+}
+
+int miFindUI(const void* data, const char* id)
+{
+	const struct MIuiHeader* hdr = milli__uiHeader(data);
+	const struct MIuiCell* cells;
+	int i;
+	if (hdr == NULL || id == NULL) return -1;
+	cells = milli__uiCells(hdr);
+	for (i = 0; i < hdr->cellCount; i++) {
+		const char* cellId = milli__uiString(hdr, cells[i].id);
+		if (cellId != NULL && strcmp(cellId, id) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static struct MIcell* milli__createUICell(const struct MIuiHeader* hdr, int idx)
+{
+	const struct MIuiCell* c = &milli__uiCells(hdr)[idx];
+	const struct MIuiParam* src = &milli__uiParams(hdr)[c->firstParam];
+	struct MIparam params[MI_UI_BATCH_PARAMS];
+	struct MIcell* cell = NULL;
+	int i, j, n, child, prev;
+
+	switch (c->type) {
+	case MI_UI_BOX: cell = miCreateBox(NULL); break;
+	case MI_UI_TEXT: cell = miCreateText(NULL); break;
+	case MI_UI_ICON: cell = miCreateIcon(NULL); break;
+	case MI_UI_SLIDER: cell = miCreateSlider(NULL); break;
+	case MI_UI_BUTTON: cell = miCreateButton(NULL); break;
+	case MI_UI_ICONBUTTON: cell = miCreateIconButton(NULL); break;
+	}
+	if (cell == NULL) return NULL;
+
+	// Params are applied in batches, the keys and values point directly to the blob.
+	for (i = 0; i < c->paramCount; i += n) {
+		n = mini(c->paramCount - i, MI_UI_BATCH_PARAMS);
+		for (j = 0; j < n; j++) {
+			struct MIparam* p = &params[j];
+			p->key = (char*)milli__uiString(hdr, src[i+j].key);
+			p->val = (char*)milli__uiString(hdr, src[i+j].val);
+			p->keyId = src[i+j].keyId;
+			p->atom = milli__internAtom(p->key);
+			p->nvals = src[i+j].nvals;
+			memcpy(p->vals, src[i+j].vals, sizeof(p->vals));
+			p->next = j+1 < n ? &params[j+1] : NULL;
+		}
+		miSetCompiled(cell, params);
+	}
+
+	// Children come after the parent and siblings after each other, which guarantees that the recursion ends.
+	prev = idx;
+	for (child = c->firstChild; child != -1; prev = child, child = milli__uiCells(hdr)[child].next) {
+		if (child <= prev || child >= hdr->cellCount) break;
+		miAddChild(cell, milli__createUICell(hdr, child));
+	}
+
+	return cell;
+}
+
+struct MIcell* miCreateFromUI(const void* data, int index)
+{
+	const struct MIuiHeader* hdr = milli__uiHeader(data);
+	if (hdr == NULL) return NULL;
+	if (index < 0 || index >= hdr->cellCount) return NULL;
+	return milli__createUICell(hdr, index);
+}
+
+
+struct MIuiBuilder {
+	struct MIuiCell* cells;
+	int cellCount, cellCap;
+	struct MIuiParam* params;
+	int paramCount, paramCap;
+	char* strings;
+	int stringsSize, stringsCap;
+};
+
+static void* milli__growArray(void* arr, int count, int* cap, int itemSize)
+{
+	void* ret;
+	int newCap;
+	if (count < *cap) return arr;
+	newCap = *cap == 0 ? 64 : *cap * 2;
+	ret = realloc(arr, newCap * itemSize);
+	if (ret == NULL) return NULL;
+	*cap = newCap;
+	return ret;
+}
+
+// Returns offset of the string in the string table, equal strings are stored once.
+static int milli__uiAddString(struct MIuiBuilder* b, const char* s)
+{
+	int i = 0, len = (int)strlen(s);
+	char* strings;
+	while (i < b->stringsSize) {
+		int n = (int)strlen(b->strings + i);
+		if (n == len && memcmp(b->strings + i, s, len) == 0)
+			return i;
+		i += n+1;
+	}
+	while (b->stringsSize + len+1 > b->stringsCap) {
+		int newCap = b->stringsCap == 0 ? 1024 : b->stringsCap * 2;
+		strings = (char*)realloc(b->strings, newCap);
+		if (strings == NULL) return -1;
+		b->strings = strings;
+		b->stringsCap = newCap;
+	}
+	i = b->stringsSize;
+	memcpy(b->strings + i, s, len+1);
+	b->stringsSize += len+1;
+	return i;
+}
+
+static int milli__uiAddCell(struct MIuiBuilder* b, int type, const char* params)
+{
+	struct MIparam* compiled = NULL;
+	struct MIparam* it;
+	struct MIuiCell* c;
+	struct MIuiCell* cells;
+
+	cells = (struct MIuiCell*)milli__growArray(b->cells, b->cellCount, &b->cellCap, sizeof(struct MIuiCell));
+	if (cells == NULL) return -1;
+	b->cells = cells;
+	c = &b->cells[b->cellCount];
+	memset(c, 0, sizeof(*c));
+	c->type = type;
+	c->id = -1;
+	c->firstChild = -1;
+	c->next = -1;
+	c->firstParam = b->paramCount;
+
+	compiled = miCompileParams(params);
+	for (it = compiled; it != NULL; it = it->next) {
+		struct MIuiParam* p;
+		struct MIuiParam* ps = (struct MIuiParam*)milli__growArray(b->params, b->paramCount, &b->paramCap, sizeof(struct MIuiParam));
+		if (ps == NULL) goto error;
+		b->params = ps;
+		p = &b->params[b->paramCount++];
+		p->key = milli__uiAddString(b, it->key);
+		p->val = milli__uiAddString(b, it->val);
+		if (p->key == -1 || p->val == -1) goto error;
+		p->keyId = it->keyId;
+		p->nvals = it->nvals;
+		memcpy(p->vals, it->vals, sizeof(p->vals));
+		if (it->keyId == MI_KEY_ID && it->val[0] != '{')
+			c->id = p->val;
+		c->paramCount++;
+	}
+	miFreeParams(compiled);
+
+	return b->cellCount++;
+
+error:
+	miFreeParams(compiled);
+	return -1;
+}
+
+int miCompileUI(const char* text, void** data, int* size)
+{
+	struct MIuiBuilder b;
+	struct MIuiHeader hdr;
+	int last[MI_UI_MAX_DEPTH];	// Last cell added at each depth.
+	const char* s = text;
+	unsigned char* mem = NULL;
+	char line[1024];
+	int lineNum = 0, prevDepth = -1, i;
+
+	memset(&b, 0, sizeof(b));
+	for (i = 0; i < MI_UI_MAX_DEPTH; i++)
+		last[i] = -1;
+	// Offset 0 is the empty string.
+	if (milli__uiAddString(&b, "") == -1) goto error;
+
+	while (*s) {
+		const char* start = s;
+		char* type;
+		char* params;
+		int len, depth = 0, idx, t;
+
+		// Copy next line.
+		while (*s && *s != '\n') s++;
+		len = (int)(s - start);
+		if (*s) s++;
+		lineNum++;
+		if (len >= (int)sizeof(line)) {
+			printf("UI: line %d: line too long\n", lineNum);
+			goto error;
+		}
+		memcpy(line, start, len);
+		line[len] = '\0';
+		if (len > 0 && line[len-1] == '\r') line[len-1] = '\0';
+
+		// Depth is defined by the number of leading tabs.
+		while (line[depth] == '\t') depth++;
+		type = line + depth;
+		while (milli__isspace(*type)) type++;
+		if (*type == '\0' || *type == '#') continue;
+		if (type != line + depth) {
+			printf("UI: line %d: indent with tabs\n", lineNum);
+			goto error;
+		}
+		if (depth > prevDepth+1 || depth >= MI_UI_MAX_DEPTH) {
+			printf("UI: line %d: invalid indent\n", lineNum);
+			goto error;
+		}
+
+		params = type;
+		while (*params && !milli__isspace(*params)) params++;
+		if (*params) *params++ = '\0';
+
+		for (t = 0; t < MI_UI_TYPE_COUNT; t++) {
+			if (strcmp(type, milli__uiTypeNames[t]) == 0)
+				break;
+		}
+		if (t == MI_UI_TYPE_COUNT) {
+			printf("UI: line %d: unknown cell type '%s'\n", lineNum, type);
+			goto error;
+		}
+
+		idx = milli__uiAddCell(&b, t, params);
+		if (idx == -1) goto error;
+
+		// Link to parent or previous sibling.
+		if (depth > 0 && last[depth] != -1 && b.cells[last[depth]].parent == last[depth-1])
+			b.cells[last[depth]].next = idx;
+		else if (depth > 0)
+			b.cells[last[depth-1]].firstChild = idx;
+		else if (last[0] != -1)
+			b.cells[last[0]].next = idx;
+		b.cells[idx].parent = depth > 0 ? last[depth-1] : -1;
+		last[depth] = idx;
+		prevDepth = depth;
+	}
+
+	// Pack it all into one blob.
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = MI_UI_MAGIC;
+	hdr.version = MI_UI_VERSION;
+	hdr.cellCount = b.cellCount;
+	hdr.paramCount = b.paramCount;
+	hdr.stringsSize = b.stringsSize;
+	hdr.cellsOffset = sizeof(struct MIuiHeader);
+	hdr.paramsOffset = hdr.cellsOffset + b.cellCount * sizeof(struct MIuiCell);
+	hdr.stringsOffset = hdr.paramsOffset + b.paramCount * sizeof(struct MIuiParam);
+	*size = hdr.stringsOffset + b.stringsSize;
+
+	mem = (unsigned char*)malloc(*size);
+	if (mem == NULL) goto error;
+	memcpy(mem, &hdr, sizeof(hdr));
+	memcpy(mem + hdr.cellsOffset, b.cells, b.cellCount * sizeof(struct MIuiCell));
+	if (b.paramCount > 0)
+		memcpy(mem + hdr.paramsOffset, b.params, b.paramCount * sizeof(struct MIuiParam));
+	memcpy(mem + hdr.stringsOffset, b.strings, b.stringsSize);
+	*data = mem;
+
+	free(b.cells);
+	free(b.params);
+	free(b.strings);
+	return 1;
+
+error:
+	free(b.cells);
+	free(b.params);
+	free(b.strings);
+	*data = NULL;
+	*size = 0;
+	return 0;
+}
+
+
 
 void miAddChild(struct MIcell* parent, struct MIcell* child)
 {
@@ -1405,50 +2803,179 @@ void miAddChild(struct MIcell* parent, struct MIcell* child)
 		prev = &(*prev)->next;
 	*prev = child;
 	child->parent = parent;
+	child->dirty = 0;
+	milli__markDirty(child);
+	milli__invalidateBindings(parent);
 }
 
+static void milli__freeCell(struct MIcell* root)
+{
+	// Free the subtree in post order without recursion, the children list is
+	// consumed as we go so parent pointers are enough to find the way back up.
+	struct MIcell* cell = root;
+	while (cell != NULL) {
+		struct MIcell* parent = NULL;
+		if (cell->children != NULL) {
+			cell = cell->children;
+			continue;
+		}
+		parent = cell == root ? NULL : cell->parent;
+		if (parent != NULL)
+			parent->children = cell->next;
+		if (g_context.hover == cell) g_context.hover = NULL;
+		if (g_context.active == cell) g_context.active = NULL;
+		if (g_context.focus == cell) g_context.focus = NULL;
+		if (cell->dtor) cell->dtor(cell);
+		milli__freeVars(cell->vars);
+		milli__releaseString(cell->id);
+		milli__releaseCell(cell);
+		cell = parent;
+	}
+}
 
 void miFreeCell(struct MIcell* cell)
 {
+	struct MIcell** prev = NULL;
 	if (cell == NULL) return;
-	miFreeCell(cell->children);
-	miFreeCell(cell->next);
-	if (cell->dtor) cell->dtor(cell);
-	free(cell->id);
-	milli__freeVars(cell->vars);
-	free(cell);
+	// Unlink from parent, it needs to be laid out again.
+	if (cell->parent != NULL) {
+		prev = &cell->parent->children;
+		while (*prev != NULL && *prev != cell)
+			prev = &(*prev)->next;
+		if (*prev == cell)
+			*prev = cell->next;
+		milli__markDirty(cell->parent);
+		milli__invalidateBindings(cell->parent);
+	}
+	milli__freeCell(cell);
 }
 
-void miSet(struct MIcell* cell, const char* params)
+void miSetCompiled(struct MIcell* cell, struct MIparam* params)
 {
-	struct MIparam* p = miParseParams(params);
-	struct MIparam* it = p;
-	for (it = p; it != NULL; it = it->next) {
+	struct MIparam* it;
+	if (cell == NULL) return;
+	milli__markDirty(cell);
+	for (it = params; it != NULL; it = it->next) {
 		if (it->val[0] == '{') {
 			char* name = strdup(it->val+1);
-			name[strlen(name)-1] = '\0';
+			int len = (int)strlen(name);
+			if (len > 0 && name[len-1] == '}')
+				name[len-1] = '\0';
 			milli__addVar(cell, name, it->key);
 			free(name);
 		} else {
 			cell->param(cell, it);
 		}
 	}
-	miFreeParams(p);
+}
+
+// Updates the values of cached params in place, when the string has the same keys as before.
+// This is the common case for live text written into a reused buffer.
+// Returns 0 if the keys changed or the new values do not fit, and the params need to be rebuilt.
+static int milli__updateCachedParams(struct MIparamCacheItem* item, const char* s)
+{
+	const char* it = s;
+	unsigned char* end = item->mem + item->paramsSize;
+	struct MIparam* p = item->params;
+	int srcLen = (int)strlen(s);
+
+	if (srcLen+1 > item->cap - item->paramsSize)
+		return 0;
+
+	// Check that the layout matches.
+	while (*it) {
+		const char *key, *val;
+		int keyLen, valLen, valCap;
+		it = milli__nextParam(it, &key, &keyLen, &val, &valLen);
+		if (key == NULL || keyLen == 0 || val == NULL || valLen == 0)
+			continue;
+		if (p == NULL) return 0;
+		if ((int)(p->val - p->key)-1 != keyLen || memcmp(p->key, key, keyLen) != 0)
+			return 0;
+		valCap = (int)((p->next != NULL ? (unsigned char*)p->next : end) - (unsigned char*)p->val);
+		if (valLen+1 > valCap)
+			return 0;
+		p = p->next;
+	}
+	if (p != NULL) return 0;
+
+	// Parse only the values which changed.
+	it = s;
+	p = item->params;
+	while (*it) {
+		const char *key, *val;
+		int keyLen, valLen;
+		it = milli__nextParam(it, &key, &keyLen, &val, &valLen);
+		if (key == NULL || keyLen == 0 || val == NULL || valLen == 0)
+			continue;
+		if (strncmp(p->val, val, valLen) != 0 || p->val[valLen] != '\0') {
+			memcpy(p->val, val, valLen);
+			p->val[valLen] = '\0';
+			p->nvals = milli__parseNumbers(p->val, p->vals, MI_MAX_PARAMVALS);
+		}
+		p = p->next;
+	}
+
+	memcpy(item->src, s, srcLen+1);
+	return 1;
+}
+
+static struct MIparam* milli__getCachedParams(const char* params)
+{
+	struct MIparamCacheItem* item;
+	int paramsSize, srcLen;
+	unsigned int h = (unsigned int)((size_t)params >> 3);
+	h ^= h >> 11;
+	item = &g_context.paramCache[(h * 2654435761u) >> 24 & (MI_PARAM_CACHE_SIZE-1)];
+
+	// The pointer may point to a buffer which is reused, check that the contents match too.
+	if (item->ptr == params) {
+		if (strcmp(item->src, params) == 0)
+			return item->params;
+		if (milli__updateCachedParams(item, params))
+			return item->params;
+	}
+
+	paramsSize = milli__paramsSize(params, MI_PARAM_VAL_SLACK);
+	if (paramsSize == 0) return NULL;
+	srcLen = (int)strlen(params);
+	if (paramsSize + srcLen+1 + MI_PARAM_VAL_SLACK > item->cap) {
+		unsigned char* mem = (unsigned char*)realloc(item->mem, paramsSize + srcLen+1 + MI_PARAM_VAL_SLACK);
+		if (mem == NULL) return NULL;
+		item->mem = mem;
+		item->cap = paramsSize + srcLen+1 + MI_PARAM_VAL_SLACK;
+	}
+	item->ptr = params;
+	item->params = milli__buildParams(params, item->mem, MI_PARAM_VAL_SLACK);
+	item->paramsSize = paramsSize;
+	item->src = (char*)item->mem + paramsSize;
+	memcpy(item->src, params, srcLen+1);
+
+	return item->params;
+}
+
+void miSet(struct MIcell* cell, const char* params)
+{
+	struct MIparam* p;
+	milli__markDirty(cell);
+	if (params == NULL) return;
+	p = milli__getCachedParams(params);
+	if (p == NULL) return;
+	miSetCompiled(cell, p);
 }
 
 void miLayout(struct MIcell* cell, struct NVGcontext* vg)
 {
 	if (cell == NULL) return;
 
-	if (cell->measure != NULL)
-		cell->measure(cell, vg);
+	// Only the cells marked dirty since last layout are revisited.
+	milli__measureTree(cell, vg);
 
 	cell->frame.x = 0;
 	cell->frame.y = 0;
 	cell->frame.width = cell->content.width + cell->paddingx*2;
 	cell->frame.height = cell->content.height + cell->paddingy*2;
-	if (cell->layout != NULL)
-		cell->layout(cell, vg);
+	milli__layoutCell(cell, vg);
 }
 
 
@@ -1462,31 +2989,41 @@ void miLayout(struct MIcell* cell, struct NVGcontext* vg)
 	return milli__hitTest(cell->next, input);
 }*/
 
-static void milli__setHover(struct MIcell* cell, struct MIcell* hover)
+// Only the previous and new cell need to be updated.
+static void milli__setHover(struct MIcell* hover)
 {
-	if (cell == NULL) return;
-	milli__setHover(cell->next, hover);
-	milli__setHover(cell->children, hover);
-	cell->hover = (cell == hover) ? 1 : 0;
+	if (g_context.hover == hover) return;
+	if (g_context.hover != NULL)
+		g_context.hover->hover = 0;
+	if (hover != NULL)
+		hover->hover = 1;
+	g_context.hover = hover;
 }
 
-static void milli__setActive(struct MIcell* cell, struct MIcell* active)
+static void milli__setActive(struct MIcell* active)
 {
-	if (cell == NULL) return;
-	milli__setActive(cell->next, active);
-	milli__setActive(cell->children, active);
-	cell->active = (cell == active) ? 1 : 0;
+	if (g_context.active == active) return;
+	if (g_context.active != NULL)
+		g_context.active->active = 0;
+	if (active != NULL)
+		active->active = 1;
+	g_context.active = active;
 }
 
-static struct MIcell* milli__hitTest(struct MIcell* cell, struct MIinputState* input)
+static struct MIcell* milli__hitTest(struct MIcell* cell, float x, float y)
 {
-	if (cell == NULL) return NULL;
-	if (milli_pointInRect(input->mx, input->my, cell->frame)) {
-		struct MIcell* hit = milli__hitTest(cell->children, input);
-		if (hit != NULL) return hit;
-		return cell;
+	// Find first sibling which contains the point, and continue to its children.
+	// Children outside the frame of the parent are not visited.
+	struct MIcell* hit = NULL;
+	while (cell != NULL) {
+		if (milli_pointInRect(x, y, cell->frame)) {
+			hit = cell;
+			cell = cell->children;
+		} else {
+			cell = cell->next;
+		}
 	}
-	return milli__hitTest(cell->next, input);
+	return hit;
 }
 
 static void fireLogic(struct MIcell* cell, int type, struct MIevent* event)
@@ -1497,7 +3034,7 @@ static void fireLogic(struct MIcell* cell, int type, struct MIevent* event)
 		cell->logic(cell, event);
 }
 
-void miInput(struct MIcell* cell, struct MIinputState* input)
+static void milli__processInput(struct MIcell* cell, float mx, float my, int mbut, struct MIkeyPress* keys, int nkeys)
 {
 	struct MIcell* hit = NULL;
 	struct MIcell* entered = NULL;
@@ -1511,23 +3048,24 @@ void miInput(struct MIcell* cell, struct MIinputState* input)
 	struct MIevent event;
 	int i;
 
-	if (cell == NULL) return;
+	g_context.mx = mx;
+	g_context.my = my;
 
-	hit = milli__hitTest(cell, input);
+	hit = milli__hitTest(cell, mx, my);
 
 	if (g_context.active == NULL) {
 		if (g_context.hover != hit) {
 			exited = g_context.hover;
 			entered = hit;
-			g_context.hover = hit;
+			milli__setHover(hit);
 		}
-		if (input->mbut & MI_MOUSE_PRESSED) {
+		if (mbut & MI_MOUSE_PRESSED) {
 			if (g_context.focus != hit) {
 				blurred = g_context.focus;
 				focused = hit;
 			}
 			g_context.focus = hit;
-			g_context.active = hit;
+			milli__setActive(hit);
 			pressed = hit;
 		}
 	}
@@ -1537,15 +3075,15 @@ void miInput(struct MIcell* cell, struct MIinputState* input)
 			if (g_context.hover != hit) {
 				exited = g_context.hover;
 				entered = hit;
-				g_context.hover = hit;
+				milli__setHover(hit);
 			}
 //			context.hover = hit->id;
 		}
-		if (input->mbut & MI_MOUSE_RELEASED) {
+		if (mbut & MI_MOUSE_RELEASED) {
 			if (g_context.hover == g_context.active)
 				clicked = g_context.hover;
 			released = g_context.active;
-			g_context.active = NULL;
+			milli__setActive(NULL);
 		} else {
 //			if (g_context.moved)
 				dragged = g_context.active;
@@ -1554,18 +3092,19 @@ void miInput(struct MIcell* cell, struct MIinputState* input)
 
 	// Update mouse positions.
 	if (pressed != NULL) {
-		g_context.startmx = input->mx;
-		g_context.startmy = input->my;
+		g_context.startmx = mx;
+		g_context.startmy = my;
 	}
 
-	event.mx = input->mx;
-	event.my = input->my;
-	event.mbut = input->mbut;
+	event.mx = mx;
+	event.my = my;
+	event.mbut = mbut;
 	event.key = 0;
+	event.time = g_context.inputTime;
 
 	if (g_context.active != NULL) {
-		event.deltamx = input->mx - g_context.startmx;
-		event.deltamy = input->my - g_context.startmy;
+		event.deltamx = mx - g_context.startmx;
+		event.deltamy = my - g_context.startmy;
 	}
 
 //	setHit(context.hover, &context.hoverHit);
@@ -1581,15 +3120,50 @@ void miInput(struct MIcell* cell, struct MIinputState* input)
 	fireLogic(entered, MI_ENTERED, &event);
 
 	if (g_context.focus != 0) {
-		for (i = 0; i < input->nkeys; i++) {
-			event.key = input->keys[i].code;
-			fireLogic(g_context.focus, input->keys[i].type, &event);
+		for (i = 0; i < nkeys; i++) {
+			event.key = keys[i].code;
+			fireLogic(g_context.focus, keys[i].type, &event);
 		}
 	}
 
 
 //	if (cell->logic != NULL)
 //		cell->logic(cell, vg);
+}
+
+void miInput(struct MIcell* cell, struct MIinputState* input)
+{
+	if (cell == NULL) return;
+
+	// Queued events are processed one by one in order, so that no press or release is lost.
+	while (g_context.inputCount > 0) {
+		struct MIinputEvent* e = &g_context.inputQueue[g_context.inputHead];
+		g_context.inputTime = e->time;
+		switch (e->type) {
+		case MI_INPUT_MOVE:
+			milli__processInput(cell, e->mx, e->my, 0, NULL, 0);
+			break;
+		case MI_INPUT_PRESS:
+			milli__processInput(cell, e->mx, e->my, MI_MOUSE_PRESSED, NULL, 0);
+			break;
+		case MI_INPUT_RELEASE:
+			milli__processInput(cell, e->mx, e->my, MI_MOUSE_RELEASED, NULL, 0);
+			break;
+		case MI_INPUT_KEY: {
+			struct MIkeyPress key;
+			key.type = e->keyType;
+			key.code = e->code;
+			milli__processInput(cell, g_context.mx, g_context.my, 0, &key, 1);
+			break;
+		}
+		}
+		g_context.inputHead = (g_context.inputHead+1) % MI_INPUT_QUEUE_SIZE;
+		g_context.inputCount--;
+	}
+
+	if (input == NULL) return;
+
+	milli__processInput(cell, input->mx, input->my, input->mbut, input->keys, input->nkeys);
 
 	// Mark input consumed
 	input->nkeys = 0;
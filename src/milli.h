@@ -74,6 +74,7 @@ struct MIevent {
 	float deltamx, deltamy;
 	int mbut;
 	int key;
+	double time;	// Time of the queued input event, time of the last queued event for polled input.
 };
 
 struct MIinputState
@@ -87,9 +88,49 @@ struct MIinputState
 void miFrameBegin(struct NVGcontext* vg, int width, int height, struct MIinputState* input);
 void miFrameEnd();
 
+// Queues timestamped input events, miInput() processes them in order before the input state.
+// Consecutive mouse moves are merged while no button is down, moves during drag, presses, releases
+// and keys are all kept. The time is passed to the cell logic in MIevent.
+// When the queue is full, mouse moves are dropped to make room for the new event.
+// Returns 0 if the queue is full of presses, releases and keys.
+int miPushMouseMove(double time, float mx, float my);
+int miPushMouseButton(double time, float mx, float my, int pressed);
+int miPushKey(double time, int type, int code);
+
+enum MIparamKey {
+	MI_KEY_UNKNOWN,
+	MI_KEY_ID,
+	MI_KEY_GROW,
+	MI_KEY_PADDINGX,
+	MI_KEY_PADDINGY,
+	MI_KEY_PADDING,
+	MI_KEY_SPACING,
+	MI_KEY_DIR,
+	MI_KEY_ALIGN,
+	MI_KEY_PACK,
+	MI_KEY_OVERFLOW,
+	MI_KEY_WIDTH,
+	MI_KEY_HEIGHT,
+	MI_KEY_LABEL,
+	MI_KEY_FONT_SIZE,
+	MI_KEY_LINE_HEIGHT,
+	MI_KEY_FONT_FACE,
+	MI_KEY_ICON,
+	MI_KEY_VALUE,
+	MI_KEY_VMIN,
+	MI_KEY_VMAX,
+	MI_KEY_COUNT
+};
+
+#define MI_MAX_PARAMVALS 2
+
 struct MIparam {
 	char* key;
 	char* val;
+	int keyId;						// Interned key, see MIparamKey.
+	int atom;						// Interned key atom, used to look up template vars.
+	int nvals;						// Number of numbers parsed from the value.
+	float vals[MI_MAX_PARAMVALS];
 	struct MIparam* next;
 };
 
@@ -103,13 +144,14 @@ typedef void (*MIparamFun)(struct MIcell* cell, struct MIparam* param);
 typedef void (*MIdtorFun)(struct MIcell* cell);
 
 struct MIvar {
-	char* name;
-	char* key;
+	const char* name;	// Interned, owned by milli.
+	const char* key;
+	int atom;			// Atom of the name.
 	struct MIvar* next;
 };
 
 struct MIcell {
-	char* id;
+	const char* id;	// Interned, owned by milli.
 
 	struct MIrect frame;
 	struct MIsize content;
@@ -120,6 +162,10 @@ struct MIcell {
 	unsigned char hover;
 	unsigned char active;
 
+	unsigned char dirty;
+	unsigned char slab;	// Allocator slab the cell came from.
+	struct MIrect layoutFrame;	// Frame used in last layout.
+
 	MIrenderFun render;
 	MIlayoutFun layout;
 	MIlogicFun logic;
@@ -143,11 +189,14 @@ struct MIbox {
 	float width, height;
 };
 
+#define MI_TEXT_INLINE_SIZE 32
+
 struct MItext {
 	struct MIcell cell;
 	char* text;
+	char textBuf[MI_TEXT_INLINE_SIZE];	// Storage for short labels.
 //	int maxText;
-	char* fontFace;
+	const char* fontFace;
 	float fontSize;
 	float lineHeight;
 	unsigned char align;
@@ -162,8 +211,23 @@ struct MIicon {
 	float width, height;
 };
 
+// Template var resolved to the cell and param key it sets.
+struct MIbinding {
+	int atom;			// Atom of the var name.
+	const char* key;
+	int keyId;
+	struct MIcell* cell;
+};
+
 struct MItemplate {
 	struct MIcell cell;
+	struct MIbinding* bindings;	// Sorted by var atom.
+	int bindingCount;
+	int bindingCapacity;
+	int* vars;					// Index of the first binding of each var atom, or -1.
+	int varCount;
+	int varCapacity;
+	unsigned char bindingsValid;
 };
 
 struct MIslider {
@@ -177,6 +241,11 @@ struct MIslider {
 
 struct MIparam* miParseParams(const char* params);
 void miFreeParams(struct MIparam* p);
+
+// Compiles param string into list of params with interned keys and parsed values.
+// The result can be applied to many cells using miSetCompiled(), free with miFreeParams().
+struct MIparam* miCompileParams(const char* params);
+int miInternParamKey(const char* key);
 int miCellParam(struct MIcell* cell, struct MIparam* p);
 
 struct MIcell* miCreateBox(const char* params);
@@ -189,15 +258,71 @@ struct MIcell* miCreateIconButton(const char* params);
 
 struct MIcell* miCreatetemplate(struct MIcell* host);
 
+// Binary UI description, see miCompileUI().
+// All references are offsets or indices, so the blob can be used from read-only or memory-mapped memory.
+// The data is in native byte order.
+#define MI_UI_MAGIC 0x4955494d	// 'MIUI'
+#define MI_UI_VERSION 1
+
+struct MIuiHeader {
+	unsigned int magic;
+	int version;
+	int cellCount, paramCount, stringsSize;
+	int cellsOffset, paramsOffset, stringsOffset;
+};
+
+struct MIuiCell {
+	int type;
+	int id;					// String offset of the id param, or -1.
+	int parent, firstChild, next;	// Cell indices, or -1.
+	int firstParam, paramCount;
+};
+
+struct MIuiParam {
+	int key, val;			// String offsets.
+	int keyId;
+	int nvals;
+	float vals[MI_MAX_PARAMVALS];
+};
+
+// Compiles text UI description into a binary blob, free the data with free().
+// Each line describes one cell: cell type followed by params, children are indented with tabs.
+// Cell types are box, text, icon, slider, button and iconbutton, lines starting with # are comments.
+//   box id=dialog dir=col
+//   	text label=Hello
+//   	button label=OK
+int miCompileUI(const char* text, void** data, int* size);
+// Validates the blob, returns 0 if the data is not valid. Cells nested deeper than
+// the text compiler allows (64 levels) are rejected too.
+// Data loaded from untrusted source must be checked before it is passed to the other functions.
+int miCheckUI(const void* data, int size);
+// Returns index of the cell with specified id, or -1 if not found.
+int miFindUI(const void* data, const char* id);
+// Creates the cell and its children, the same subtree can be instantiated many times.
+// The data is expected to have passed miCheckUI().
+struct MIcell* miCreateFromUI(const void* data, int index);
+
 void miAddChild(struct MIcell* parent, struct MIcell* child);
 
 void miFreeCell(struct MIcell* cell);
 
+// Compiled params are cached based on the params pointer, so using string literals is fast.
+// When text in a reused buffer changes but the keys stay the same, only the changed values are parsed again.
 void miSet(struct MIcell* cell, const char* params);
+void miSetCompiled(struct MIcell* cell, struct MIparam* params);
 
 #define MILLI_NOTUSED(v) do { (void)(1 ? (void)0 : ( (void)(v) ) ); } while(0)
 
 void miLayout(struct MIcell* cell, struct NVGcontext* vg);
+
+// Sets number of threads used to measure big trees, 1 disables threading.
+// Each worker measures text using its own headless nanovg context, the fonts
+// used by the cells must be added to the workers using miAddMeasureFont().
+int miSetMeasureThreads(int count);
+int miAddMeasureFont(const char* name, const char* filename);
+// Marks the whole subtree to be measured again, call after font or DPI changes.
+void miInvalidateMeasure(struct MIcell* cell);
+// Input state can be NULL when all input is pushed to the event queue.
 void miInput(struct MIcell* cell, struct MIinputState* input);
 void miRender(struct MIcell* cell, struct NVGcontext* vg);
 
@@ -132,6 +132,8 @@ static char* mi__codepointToUTF8(int cp, char* str)
 enum MIdrawCommandType {
 	MI_SHAPE_RECT,
 	MI_SHAPE_TEXT,
+	MI_SHAPE_SCISSOR,
+	MI_SHAPE_RESET_SCISSOR,
 };
 
 struct MIshape {
@@ -168,6 +170,14 @@ struct MIlayout {
 	int parentPack;
 	float colWidth;
 	float rowHeight;
+
+	int deferred;	// rect was reserved based on last frame's content size.
+
+	int overflow;
+	float scrollOffset;
+	float scrollExtent;
+	MIrect savedClip;
+	int savedClipped;
 };
 typedef struct MIlayout MIlayout;
 
@@ -184,6 +194,8 @@ struct MIpanel {
 //	float spacing;
 	MIlayout layoutStack[MAX_LAYOUTS];
 	int layoutStackCount;
+	MIrect clip;
+	int clipped;
 };
 typedef struct MIpanel MIpanel;
 
@@ -201,6 +213,31 @@ struct MIstateBlock {
 };
 typedef struct MIstateBlock MIstateBlock;
 
+struct MIsizeEntry {
+	MIhandle handle;
+	MIsize size;
+};
+typedef struct MIsizeEntry MIsizeEntry;
+
+struct MIsizeCache {
+	MIsizeEntry* entries;
+	int count, cap;
+};
+typedef struct MIsizeCache MIsizeCache;
+
+#define MAX_TEXT_METRIC_CHARS 48
+
+// Short texts are stored in the entry and compared exactly, longer ones by length and a second hash.
+struct MItextMetric {
+	unsigned int hash, hash2;
+	int len;
+	int fontFace;
+	float fontSize;
+	char text[MAX_TEXT_METRIC_CHARS];
+	MIsize size;
+};
+typedef struct MItextMetric MItextMetric;
+
 struct MIiconImage
 {
 	char* name;
@@ -215,6 +252,8 @@ typedef struct MIiconImage MIiconImage;
 #define MAX_ICONS 100
 #define MAX_STATES 100
 #define MAX_STATEMEM 8000
+#define INIT_SIZES 1024		// Must be power of two, the size cache grows when half full.
+#define MAX_TEXT_METRICS 512	// Must be power of two.
 
 struct MIcontext {
 	struct NVGcontext* vg;
@@ -263,6 +302,14 @@ struct MIcontext {
 	char stateMem[MAX_STATEMEM];
 	int stateMemSize;
 
+	// Content sizes of layouts, current frame is written and previous frame is read.
+	int deferLayout;
+	MIsizeCache sizeCache[2];
+	int sizeCacheCur;
+
+	// Measured text sizes, kept over frames.
+	MItextMetric textMetrics[MAX_TEXT_METRICS];
+
 	int fontIds[MI_COUNT_FONTS];
 
 	struct MIiconImage* icons[MAX_ICONS];
@@ -334,6 +381,87 @@ static void mi__garbageCollectState()
 	g_context.stateMemSize = offset;
 }
 
+static unsigned int mi__hashHandle(MIhandle handle, int cap)
+{
+	return (handle * 2654435761u) & (unsigned int)(cap-1);
+}
+
+static int mi__growSizeCache(MIsizeCache* cache)
+{
+	int i, cap = cache->cap == 0 ? INIT_SIZES : cache->cap*2;
+	MIsizeEntry* entries = (MIsizeEntry*)calloc(cap, sizeof(MIsizeEntry));
+	if (entries == NULL) return 0;
+	for (i = 0; i < cache->cap; i++) {
+		unsigned int h;
+		if (cache->entries[i].handle == 0) continue;
+		h = mi__hashHandle(cache->entries[i].handle, cap);
+		while (entries[h].handle != 0)
+			h = (h+1) & (cap-1);
+		entries[h] = cache->entries[i];
+	}
+	free(cache->entries);
+	cache->entries = entries;
+	cache->cap = cap;
+	return 1;
+}
+
+static void mi__storeSize(MIhandle handle, MIsize size)
+{
+	MIsizeCache* cache = &g_context.sizeCache[g_context.sizeCacheCur];
+	unsigned int i;
+	if (handle == 0) return;
+	// Keep the table sparse so that probing stays short.
+	if ((cache->count+1)*2 > cache->cap) {
+		if (!mi__growSizeCache(cache)) {
+			printf("Size cache: out of memory, layout %u is not deferred.\n", handle);
+			return;
+		}
+	}
+	i = mi__hashHandle(handle, cache->cap);
+	while (cache->entries[i].handle != 0 && cache->entries[i].handle != handle)
+		i = (i+1) & (cache->cap-1);
+	if (cache->entries[i].handle == 0)
+		cache->count++;
+	cache->entries[i].handle = handle;
+	cache->entries[i].size = size;
+}
+
+static int mi__getCachedSize(MIhandle handle, MIsize* size)
+{
+	MIsizeCache* cache = &g_context.sizeCache[g_context.sizeCacheCur ^ 1];
+	unsigned int i;
+	if (handle == 0 || cache->cap == 0) return 0;
+	i = mi__hashHandle(handle, cache->cap);
+	while (cache->entries[i].handle != 0) {
+		if (cache->entries[i].handle == handle) {
+			*size = cache->entries[i].size;
+			return 1;
+		}
+		i = (i+1) & (cache->cap-1);
+	}
+	return 0;
+}
+
+static void mi__swapSizeCache()
+{
+	// Sizes which were not stored this frame are dropped.
+	MIsizeCache* cache;
+	g_context.sizeCacheCur ^= 1;
+	cache = &g_context.sizeCache[g_context.sizeCacheCur];
+	if (cache->entries != NULL)
+		memset(cache->entries, 0, sizeof(MIsizeEntry)*cache->cap);
+	cache->count = 0;
+}
+
+static void mi__deleteSizeCache()
+{
+	int i;
+	for (i = 0; i < 2; i++) {
+		free(g_context.sizeCache[i].entries);
+		memset(&g_context.sizeCache[i], 0, sizeof(MIsizeCache));
+	}
+}
+
 static char* mi__allocText(const char* text, int len)
 {
 	char* ret;
@@ -413,6 +541,38 @@ static void mi__drawRect(MIpanel* panel, float x, float y, float width, float he
 	mi__addShape(panel, shape);
 }
 
+static void mi__pushClip(MIpanel* panel, MIlayout* layout, MIrect rect)
+{
+	MIshape* shape = mi__allocShape();
+	if (shape == NULL) return;
+	layout->savedClip = panel->clip;
+	layout->savedClipped = panel->clipped;
+	if (panel->clipped) {
+		float maxx = mi__minf(mi__rectMaxX(rect), mi__rectMaxX(panel->clip));
+		float maxy = mi__minf(mi__rectMaxY(rect), mi__rectMaxY(panel->clip));
+		rect.x = mi__maxf(rect.x, panel->clip.x);
+		rect.y = mi__maxf(rect.y, panel->clip.y);
+		rect.width = mi__maxf(0, maxx - rect.x);
+		rect.height = mi__maxf(0, maxy - rect.y);
+	}
+	panel->clip = rect;
+	panel->clipped = 1;
+	shape->type = MI_SHAPE_SCISSOR;
+	shape->rect = rect;
+	mi__addShape(panel, shape);
+}
+
+static void mi__popClip(MIpanel* panel, MIlayout* layout)
+{
+	MIshape* shape = mi__allocShape();
+	panel->clip = layout->savedClip;
+	panel->clipped = layout->savedClipped;
+	if (shape == NULL) return;
+	shape->type = panel->clipped ? MI_SHAPE_SCISSOR : MI_SHAPE_RESET_SCISSOR;
+	shape->rect = panel->clip;
+	mi__addShape(panel, shape);
+}
+
 static void mi__drawText(MIpanel* panel, float x, float y, float width, float height, const char* text, MIcolor col, int textAlign, int fontFace, int fontSize)
 {
 	MIshape* shape = mi__allocShape();
@@ -460,12 +620,60 @@ static int mi__measureTextGlyphs(struct NVGglyphPosition* pos, int maxpos,
 	return count;
 }
 
+static unsigned int mi__hashText(const char* text, int* len)
+{
+	// FNV-1a
+	const char* s = text;
+	unsigned int h = 2166136261u;
+	for (; *s; s++) {
+		h ^= (unsigned char)*s;
+		h *= 16777619u;
+	}
+	*len = (int)(s - text);
+	return h;
+}
+
+static unsigned int mi__hashText2(const char* text, int len)
+{
+	// djb2, independent of FNV-1a
+	unsigned int h = 5381;
+	int i;
+	for (i = 0; i < len; i++)
+		h = h*33 + (unsigned char)text[i];
+	return h;
+}
+
+static int mi__sameText(const MItextMetric* metric, const char* text, int len)
+{
+	if (metric->len != len) return 0;
+	if (len < MAX_TEXT_METRIC_CHARS)
+		return memcmp(metric->text, text, len) == 0;
+	return metric->hash2 == mi__hashText2(text, len);
+}
+
+static void mi__clearTextMetrics()
+{
+	memset(g_context.textMetrics, 0, sizeof(g_context.textMetrics));
+}
+
 MIsize miMeasureText(const char* text, int fontFace, float fontSize)
 {
 	float bounds[4];
 	MIsize size = {0,0};
+	MItextMetric* metric;
+	unsigned int hash;
+	int len;
 	struct NVGcontext* vg = g_context.vg;
 	if (vg == NULL) return size;
+
+	// Labels are usually the same from frame to frame, look up previous measurement first.
+	// Zero hash is reserved for empty slot.
+	hash = mi__hashText(text, &len);
+	if (hash == 0) hash = 1;
+	metric = &g_context.textMetrics[(hash ^ (unsigned int)fontFace*2654435761u ^ (unsigned int)(fontSize*16.0f)) & (MAX_TEXT_METRICS-1)];
+	if (metric->hash == hash && metric->fontFace == fontFace && metric->fontSize == fontSize && mi__sameText(metric, text, len))
+		return metric->size;
+
 	nvgSave(vg);
 	nvgFontFaceId(vg, fontFace);
 	nvgFontSize(vg, fontSize);
@@ -473,6 +681,17 @@ MIsize miMeasureText(const char* text, int fontFace, float fontSize)
 	size.width = bounds[2] - bounds[0];
 	size.height = bounds[3] - bounds[1];
 	nvgRestore(vg);
+
+	metric->hash = hash;
+	metric->len = len;
+	if (len < MAX_TEXT_METRIC_CHARS)
+		memcpy(metric->text, text, len);
+	else
+		metric->hash2 = mi__hashText2(text, len);
+	metric->fontFace = fontFace;
+	metric->fontSize = fontSize;
+	metric->size = size;
+
 	return size;
 }
 
@@ -628,6 +847,9 @@ int miCreateFont(int face, const char* filename)
 	if (idx == -1) return -1;
 	g_context.fontIds[face] = idx;
 
+	// Font changed, cached sizes are not valid anymore.
+	mi__clearTextMetrics();
+
 	return 0;
 }
 
@@ -643,6 +865,7 @@ int miInit(struct NVGcontext* vg)
 void miTerminate()
 {
 	mi__deleteIcons();
+	mi__deleteSizeCache();
 }
 
 
@@ -654,6 +877,14 @@ static void mi__drawPanel(MIpanel* panel)
 	if (!panel->visible) return;
 
 	for (s = panel->shapesHead; s != NULL; s = s->next) {
+		// Scissor is set outside save/restore so that it applies to the following shapes.
+		if (s->type == MI_SHAPE_SCISSOR) {
+			nvgScissor(vg, s->rect.x, s->rect.y, s->rect.width, s->rect.height);
+			continue;
+		} else if (s->type == MI_SHAPE_RESET_SCISSOR) {
+			nvgResetScissor(vg);
+			continue;
+		}
 		nvgSave(vg);
 		if (s->type == MI_SHAPE_RECT) {
 			nvgBeginPath(vg);
@@ -684,6 +915,7 @@ static void mi__drawPanel(MIpanel* panel)
 		}
 		nvgRestore(vg);
 	}
+	nvgResetScissor(vg);
 }
 
 void miFrameBegin(int width, int height, MIinputState* input, float dt)
@@ -749,6 +981,31 @@ void miFrameEnd()
 	}
 
 	 mi__garbageCollectState();
+
+	mi__swapSizeCache();
+}
+
+void miDeferLayout(int enable)
+{
+	g_context.deferLayout = enable;
+}
+
+void miGetPoolStats(MIpoolStats* stats)
+{
+	stats->panels = g_context.panelPoolSize;
+	stats->maxPanels = MAX_PANELS;
+	stats->shapes = g_context.shapePoolSize;
+	stats->maxShapes = MAX_SHAPES;
+	stats->boxes = g_context.boxPoolSize;
+	stats->maxBoxes = MAX_BOXES;
+	stats->text = g_context.textPoolSize;
+	stats->maxText = MAX_TEXT;
+	stats->states = g_context.statePoolSize;
+	stats->maxStates = MAX_STATES;
+	stats->stateMem = g_context.stateMemSize;
+	stats->maxStateMem = MAX_STATEMEM;
+	stats->sizes = g_context.sizeCache[g_context.sizeCacheCur ^ 1].count;
+	stats->maxSizes = g_context.sizeCache[g_context.sizeCacheCur ^ 1].cap/2;
 }
 
 static void mi__pushPanel(MIpanel* panel)
@@ -783,6 +1040,22 @@ static MIhandle mi__allocHandle(MIpanel* panel)
 #define PANEL_PADDING 16
 #define LAYOUT_SPACING 8
 
+#define SCROLL_SPEED 20
+#define SCROLLBAR_SIZE 4
+
+enum MIstateAttr {
+	MI_STATE_DEFAULT,
+	MI_STATE_SCROLL,
+};
+
+struct MIscrollState {
+	float offset;
+	float contentHeight;
+};
+typedef struct MIscrollState MIscrollState;
+
+static int mi__hitTest(MIpanel* panel, struct MIrect rect);
+
 #define DEFAULT_WIDTH 256
 #define DEFAULT_HEIGHT 48
 
@@ -1008,6 +1281,75 @@ static MIrect mi__layoutRect(MIpanel* panel, MIlayout* layout, MIsize content)
 	return rect;
 }
 
+static MIrect mi__reserveRect(MIpanel* panel, MIlayout* parentLayout, MIlayout* newLayout)
+{
+	MIsize size;
+	MIrect rect = mi__getFreeRect(panel, parentLayout);
+
+	// In deferred mode, use the content size from previous frame to place the layout
+	// so that bottom-up and right-to-left docks do not depend on the call order.
+	newLayout->deferred = 0;
+	if (g_context.deferLayout && mi__getCachedSize(newLayout->handle, &size)) {
+		mi__applySizeX(&rect, parentLayout->pack, size.width);
+		mi__applySizeY(&rect, parentLayout->pack, size.height);
+		newLayout->deferred = 1;
+	}
+
+	return rect;
+}
+
+static void mi__endScroll(MIpanel* panel, MIlayout* layout)
+{
+	MIscrollState* scroll;
+	float top, bottom, viewHeight, contentHeight;
+
+	mi__popClip(panel, layout);
+
+	scroll = (MIscrollState*)mi__getState(layout->handle, MI_STATE_SCROLL, sizeof(MIscrollState));
+	if (scroll == NULL) return;
+
+	// Store content height for clamping the offset next frame.
+	top = layout->rect.y - layout->scrollOffset;
+	bottom = mi__maxf(mi__rectMaxY(layout->usedSpace), layout->scrollExtent);
+	scroll->contentHeight = mi__maxf(0, bottom - top);
+
+	// Scroll bar
+	viewHeight = layout->rect.height;
+	contentHeight = scroll->contentHeight;
+	if (contentHeight > viewHeight && viewHeight > 0) {
+		float h = mi__maxf(SCROLLBAR_SIZE*2, viewHeight * viewHeight / contentHeight);
+		float y = layout->rect.y + (viewHeight - h) * (layout->scrollOffset / (contentHeight - viewHeight));
+		float x = mi__rectMaxX(layout->rect) - SCROLLBAR_SIZE;
+		mi__drawRect(panel, x, layout->rect.y, SCROLLBAR_SIZE, viewHeight, miRGBA(0,0,0,64));
+		mi__drawRect(panel, x, y, SCROLLBAR_SIZE, h, miRGBA(255,255,255,128));
+	}
+}
+
+static MIrect mi__closeLayout(MIpanel* panel, MIlayout* parentLayout, MIlayout* closedLayout)
+{
+	MIrect rect = closedLayout->usedSpace;
+	MIsize size;
+
+	if (closedLayout->overflow == MI_SCROLL) {
+		// Scrolling layout occupies its viewport regardless of the content.
+		mi__endScroll(panel, closedLayout);
+		mi__commitSpace(panel, parentLayout, closedLayout->rect);
+		return closedLayout->rect;
+	}
+
+	if (g_context.deferLayout) {
+		size.width = closedLayout->usedSpace.width;
+		size.height = closedLayout->usedSpace.height;
+		mi__storeSize(closedLayout->handle, size);
+		if (closedLayout->deferred)
+			rect = closedLayout->rect;
+	}
+
+	mi__commitSpace(panel, parentLayout, rect);
+
+	return rect;
+}
+
 void miPack(int pack)
 {
 	MIlayout* layout;
@@ -1019,6 +1361,66 @@ void miPack(int pack)
 	layout->pack = pack;
 }
 
+void miOverflow(int overflow)
+{
+	MIlayout* layout;
+	MIscrollState* scroll;
+	MIpanel* panel = mi__curPanel();
+	if (panel == NULL) return;
+	layout = mi__getLayout(panel);
+	if (layout == NULL || layout->depth == 0) return;
+	if (overflow != MI_SCROLL || layout->overflow == MI_SCROLL) return;
+
+	scroll = (MIscrollState*)mi__getState(layout->handle, MI_STATE_SCROLL, sizeof(MIscrollState));
+	if (scroll == NULL) return;
+
+	layout->overflow = MI_SCROLL;
+
+	if (mi__hitTest(panel, layout->rect) && g_context.input.scrolly != 0.0f) {
+		scroll->offset -= g_context.input.scrolly * SCROLL_SPEED;
+		g_context.input.scrolly = 0;
+	}
+	// Content height is from previous frame.
+	scroll->offset = mi__clampf(scroll->offset, 0, mi__maxf(0, scroll->contentHeight - layout->rect.height));
+	layout->scrollOffset = scroll->offset;
+	layout->scrollExtent = 0;
+
+	// Move the content, the layout rect stays as viewport.
+	layout->freeSpace.y -= scroll->offset;
+	layout->freeSpace.width = mi__maxf(0, layout->freeSpace.width - SCROLLBAR_SIZE);
+
+	mi__pushClip(panel, layout, layout->rect);
+}
+
+int miVisibleRange(float rowHeight, int count, int* first, int* end)
+{
+	MIlayout* layout;
+	MIrect view;
+	float top;
+	int f, e;
+	MIpanel* panel = mi__curPanel();
+
+	*first = 0;
+	*end = count;
+	if (panel == NULL || count <= 0 || rowHeight <= 0.0f) return *end - *first;
+	layout = mi__getLayout(panel);
+	if (layout == NULL || layout->cellCount > 0 || layout->pack != MI_TOP_BOTTOM) return *end - *first;
+
+	view = panel->clipped ? panel->clip : panel->rect;
+	top = layout->freeSpace.y;
+
+	f = (int)((view.y - top) / rowHeight);
+	e = (int)((mi__rectMaxY(view) - top) / rowHeight) + 1;
+	*first = mi__clampi(f, 0, count);
+	*end = mi__clampi(e, *first, count);
+
+	// Skip the rows above the view, and account the rows below it into the content size.
+	mi__rectSetMinY(&layout->freeSpace, top + *first * rowHeight);
+	layout->scrollExtent = mi__maxf(layout->scrollExtent, top + count * rowHeight);
+
+	return *end - *first;
+}
+
 void miColWidth(float width)
 {
 	MIlayout* layout;
@@ -1055,7 +1457,8 @@ MIhandle miDivsBegin(int pack, int count, float* divs)
 	box = mi__allocBox();
 	if (box == NULL) return 0;
 
-	newLayout->rect = mi__getFreeRect(panel, parentLayout);
+	box->handle = newLayout->handle = mi__allocHandle(panel);
+	newLayout->rect = mi__reserveRect(panel, parentLayout, newLayout);
 
 	newLayout->freeSpace = mi__inflateRect(newLayout->rect, 0);//PANEL_PADDING);
 	newLayout->usedSpace = MI_EMPTY_RECT;
@@ -1128,7 +1531,7 @@ MIhandle miDivsEnd()
 	box = mi__getBoxByHandle(closedLayout->handle);
 	if (box == NULL) return 0;
 
-	mi__commitSpace(panel, parentLayout, closedLayout->usedSpace);
+	box->rect = mi__closeLayout(panel, parentLayout, closedLayout);
 
 //	mi__drawRect(panel, closedLayout->usedSpace.x, closedLayout->usedSpace.y, closedLayout->usedSpace.width, closedLayout->usedSpace.height, miRGBA(255,0,192,32));
 
@@ -1149,7 +1552,8 @@ MIhandle miLayoutBegin(int pack)
 	box = mi__allocBox();
 	if (box == NULL) return 0;
 
-	newLayout->rect = mi__getFreeRect(panel, parentLayout);
+	box->handle = newLayout->handle = mi__allocHandle(panel);
+	newLayout->rect = mi__reserveRect(panel, parentLayout, newLayout);
 
 	newLayout->freeSpace = mi__inflateRect(newLayout->rect, 0);//PANEL_PADDING);
 	newLayout->usedSpace = MI_EMPTY_RECT;
@@ -1172,10 +1576,10 @@ MIhandle miLayoutEnd()
 	if (closedLayout == NULL) { printf("no prev\n"); return 0; }
 	parentLayout = mi__getLayout(panel);
 	if (parentLayout == NULL) { printf("no cur\n"); return 0; }
-	box = mi__getBoxByHandle(parentLayout->handle);
+	box = mi__getBoxByHandle(closedLayout->handle);
 	if (box == NULL) return 0;
 
-	mi__commitSpace(panel, parentLayout, closedLayout->usedSpace);
+	box->rect = mi__closeLayout(panel, parentLayout, closedLayout);
 
 	mi__drawRect(panel, closedLayout->usedSpace.x, closedLayout->usedSpace.y, closedLayout->usedSpace.width, closedLayout->usedSpace.height, miRGBA(255,0,192,32));
 
@@ -1318,6 +1722,7 @@ int miGetKeyPress(MIkeyPress* key)
 static int mi__hitTest(MIpanel* panel, struct MIrect rect)
 {
 	if (g_context.hoverPanel != panel->handle) return 0;
+	if (panel->clipped && !mi__pointInRect(g_context.input.mx, g_context.input.my, panel->clip)) return 0;
 	return mi__pointInRect(g_context.input.mx, g_context.input.my, rect);
 }
 
@@ -1439,6 +1844,14 @@ struct MItextInputState {
 };
 typedef struct MItextInputState MItextInputState;
 
+static void mi__measureInputGlyphs(MItextInputState* state, const char* text, struct NVGglyphPosition* glyphs, MIrect rect)
+{
+	// Glyph positions are relative to the input box so that they stay valid when the box moves,
+	// they need to be measured again only when the text is edited.
+	state->nglyphs = mi__measureTextGlyphs(glyphs, state->maxText, 0, 0, rect.width, rect.height,
+										   text, NVG_ALIGN_LEFT|NVG_ALIGN_MIDDLE, MI_FONT_NORMAL, TEXT_FONT_SIZE);
+}
+
 static int findCaretPos(float x, struct NVGglyphPosition* glyphs, int nglyphs)
 {
 	float px;
@@ -1523,9 +1936,7 @@ MIhandle miInput(char* text, int maxText)
 		if (state == NULL  || stateText == NULL || stateGlyphs == NULL) return 0;
 		memcpy(stateText, text, maxText);
 		state->maxText = maxText;
-		state->nglyphs = mi__measureTextGlyphs(stateGlyphs, maxText,
-							box->rect.x, box->rect.y, box->rect.width, box->rect.height,
-							stateText, NVG_ALIGN_LEFT|NVG_ALIGN_MIDDLE, MI_FONT_NORMAL, TEXT_FONT_SIZE);
+		mi__measureInputGlyphs(state, stateText, stateGlyphs, box->rect);
 		state->caretPos = state->nglyphs;
 		state->selStart = 0;
 		state->selEnd = state->nglyphs;
@@ -1550,14 +1961,14 @@ MIhandle miInput(char* text, int maxText)
 				state->selStart = 0;
 				state->selEnd = state->selPivot = state->caretPos = state->nglyphs;
 			} else {
-				state->caretPos = findCaretPos(mouse.x, stateGlyphs, state->nglyphs);
+				state->caretPos = findCaretPos(mouse.x - box->rect.x, stateGlyphs, state->nglyphs);
 				state->selStart = state->selEnd = state->selPivot = state->caretPos;
 			}
 		}
 		if (miDragged(box->handle)) {
 			MIpoint mouse = miMousePos();
 			// Drag
-			state->caretPos = findCaretPos(mouse.x, stateGlyphs, state->nglyphs);
+			state->caretPos = findCaretPos(mouse.x - box->rect.x, stateGlyphs, state->nglyphs);
 			state->selStart = mi__mini(state->caretPos, state->selPivot);
 			state->selEnd = mi__maxi(state->caretPos, state->selPivot);
 		}
@@ -1635,9 +2046,7 @@ MIhandle miInput(char* text, int maxText)
 					}
 					if (count > 0) {
 						deleteText(stateText, state->maxText, del, count);
-						state->nglyphs = mi__measureTextGlyphs(stateGlyphs, maxText,
-											box->rect.x, box->rect.y, box->rect.width, box->rect.height,
-											stateText, NVG_ALIGN_LEFT|NVG_ALIGN_MIDDLE, MI_FONT_NORMAL, TEXT_FONT_SIZE);
+						mi__measureInputGlyphs(state, stateText, stateGlyphs, box->rect);
 						// Store result
 //						mgSetResultStr(w->id, stateText, state->maxText);
 						strncpy(text, stateText, maxText);
@@ -1674,9 +2083,7 @@ MIhandle miInput(char* text, int maxText)
 					state->caretPos = state->selStart;
 					if (count > 0) {
 						deleteText(stateText, state->maxText, del, count);
-						state->nglyphs = mi__measureTextGlyphs(stateGlyphs, maxText,
-											box->rect.x, box->rect.y, box->rect.width, box->rect.height,
-											stateText, NVG_ALIGN_LEFT|NVG_ALIGN_MIDDLE, MI_FONT_NORMAL, TEXT_FONT_SIZE);
+						mi__measureInputGlyphs(state, stateText, stateGlyphs, box->rect);
 						state->selStart = state->selEnd = 0;
 						state->selPivot = -1;
 					}
@@ -1690,9 +2097,7 @@ MIhandle miInput(char* text, int maxText)
 					ins = strlen(stateText);
 				insertText(stateText, state->maxText, ins, str, strlen(str));
 
-				state->nglyphs = mi__measureTextGlyphs(stateGlyphs, maxText,
-									box->rect.x, box->rect.y, box->rect.width, box->rect.height,
-									stateText, NVG_ALIGN_LEFT|NVG_ALIGN_MIDDLE, MI_FONT_NORMAL, TEXT_FONT_SIZE);
+				mi__measureInputGlyphs(state, stateText, stateGlyphs, box->rect);
 				state->caretPos = mi__mini(state->caretPos + strlen(str), state->nglyphs);
 
 				state->selStart = state->selEnd = 0;
@@ -1713,7 +2118,7 @@ MIhandle miInput(char* text, int maxText)
 		if (state->selStart != state->selEnd && state->nglyphs > 0) {
 			float sx = (state->selStart >= state->nglyphs) ? stateGlyphs[state->nglyphs-1].maxx : stateGlyphs[state->selStart].x;
 			float ex = (state->selEnd >= state->nglyphs) ? stateGlyphs[state->nglyphs-1].maxx : stateGlyphs[state->selEnd].x;
-			mi__drawRect(panel, sx, box->rect.y, ex - sx, box->rect.height, miRGBA(255,0,0,64));
+			mi__drawRect(panel, box->rect.x + sx, box->rect.y, ex - sx, box->rect.height, miRGBA(255,0,0,64));
 		}
 
 		mi__drawText(panel, box->rect.x, box->rect.y, box->rect.width, box->rect.height, stateText, miRGBA(255,255,255,255),
@@ -1733,12 +2138,13 @@ MIhandle miInput(char* text, int maxText)
 			else if (w->style.textAlign == MG_END)
 				caretx = w->x + w->width - w->style.paddingx;
 			else*/
-				caretx = box->rect.x;
+				caretx = 0;
 		} else if (state->caretPos >= state->nglyphs) {
 			caretx = stateGlyphs[state->nglyphs-1].maxx;
 		} else {
 			caretx = stateGlyphs[state->caretPos].x;
 		}
+		caretx += box->rect.x;
 		mi__drawRect(panel, (int)(caretx-0.5f), box->rect.y, 1, box->rect.height, miRGBA(255,0,0,255));
 	} else {
 		mi__drawRect(panel, box->rect.x, box->rect.y, box->rect.width, box->rect.height, miRGBA(0,0,0,32));
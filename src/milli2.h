@@ -82,6 +82,7 @@ typedef struct MIevent MIevent;
 struct MIinputState
 {
 	float mx, my;
+	float scrolly;
 	int mbut;
 	MIkeyPress keys[MI_MAX_INPUTKEYS];
 	int nkeys;	
@@ -105,6 +106,17 @@ typedef struct MIcanvasState MIcanvasState;
 
 typedef unsigned int MIhandle;
 
+struct MIpoolStats {
+	int panels, maxPanels;
+	int shapes, maxShapes;
+	int boxes, maxBoxes;
+	int text, maxText;
+	int states, maxStates;
+	int stateMem, maxStateMem;
+	int sizes, maxSizes;
+};
+typedef struct MIpoolStats MIpoolStats;
+
 enum MIfontFace {
 	MI_FONT_NORMAL,
 	MI_FONT_ITALIC,
@@ -122,6 +134,13 @@ int miCreateIconImage(const char* name, const char* filename, float scale);
 void miFrameBegin(int width, int height, MIinputState* input, float dt);
 void miFrameEnd();
 
+// Deferred layout places layouts and divs based on their content size from the previous frame.
+// Docks are layouts and are placed the same way. The size cache grows with the number of layouts.
+void miDeferLayout(int enable);
+
+// Returns pool usage of the last frame, valid after miFrameEnd().
+void miGetPoolStats(MIpoolStats* stats);
+
 MIhandle miPanelBegin(float x, float y, float width, float height);
 MIhandle miPanelEnd();
 
@@ -161,6 +180,8 @@ enum MIpack {
 };
 
 void miPack(int pack);
+// Scrolls the contents of current layout when set to MI_SCROLL, the layout occupies the space it was given.
+void miOverflow(int overflow);
 void miColWidth(float width);
 void miRowHeight(float height);
 
@@ -175,6 +196,11 @@ MIhandle miDivsEnd();
 
 MIhandle miSpacer();
 
+// Returns the range [first,end) of rows of given height which are visible in the current
+// scrolling layout, and skips the space of the rows above it. Rows must be packed top-to-bottom,
+// be exactly rowHeight tall, and be the last items in the layout.
+int miVisibleRange(float rowHeight, int count, int* first, int* end);
+
 enum MIpopupSide {
 	MI_RIGHT,
 	MI_BELOW,